@@ -0,0 +1,341 @@
+//======================================================
+// Generator of training data (state, shot, outcome) for evaluation of positions.
+// States are sampled from logs or random rollouts, candidate shots are simulated
+// with noise on all cores, and records are written to shards of fixed-size records.
+//======================================================
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../Simulator/dcurling_simulator.h"
+#include "../Server/game_log_binary.h"
+#include "training_data.h"
+
+#ifdef _MSC_VER
+#ifdef _DEBUG
+#pragma comment( lib, "../x64/Debug/Simulator.lib" )
+#endif
+#ifndef _DEBUG
+#pragma comment( lib, "../x64/Release/Simulator.lib" )
+#endif
+#endif
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using std::string;
+
+namespace digital_curling {
+
+	namespace generator {
+
+		// Options of generator
+		struct Options {
+			string prefix;               // shards are written to PREFIX_<thread>.dct
+			uint64_t num_records;        // number of records of all shards
+			unsigned int candidates;     // number of candidate shots for each state
+			unsigned int threads;        // number of threads (0: number of cores)
+			uint32_t seed;               // seed of thread i is seed + i
+			float random[2];             // random_1 and random_2 of noise
+			float friction;              // friction of simulator
+			unsigned int freeguard_num;  // number of shots of freeguard rule
+			std::vector<string> logs;    // logs (or directories of them) as states, random rollouts if empty
+
+			Options() :
+				prefix("train"),
+				num_records(100000),
+				candidates(16),
+				threads(0),
+				seed(0),
+				random{ 0.0725f, 0.2900f },  // random_1 and random_2 of config.json
+				friction(12.009216f),         // friction_default of config.json
+				freeguard_num(5) {}
+		};
+
+		// Number of records buffered before writing to shard
+		constexpr size_t kWriteBufferRecords = 4096;
+
+		// Read positions before shots of logs
+		// Mix doubles games are skipped as their rule differs from freeguard_num
+		static bool LoadStates(const std::vector<string> &paths, std::vector<GameState> &states) {
+			std::vector<string> logs = ListLogs(paths);
+			for (const string &log : logs) {
+				BinaryLogHeader header;
+				std::vector<BinaryLogRecord> records;
+				if (!ReadLog(log, header, records)) {
+					cerr << "failed to read " << log << endl;
+					return false;
+				}
+
+				for (const BinaryLogRecord &record : records) {
+					if (record.type == BinaryLogRecord::GAMEINFO && record.value[0] == 1) {
+						break;  // mix doubles
+					}
+					if (record.type != BinaryLogRecord::SHOT || record.shot_num >= 16) {
+						continue;
+					}
+					GameState gs(record.last_end);
+					gs.ShotNum = record.shot_num;
+					gs.CurEnd = record.cur_end;
+					gs.WhiteToMove = (record.white_to_move != 0);
+					memcpy(gs.body, record.before, sizeof(gs.body));
+					states.push_back(gs);
+				}
+			}
+			cout << "> " << states.size() << " states from " << logs.size() << " logs." << endl;
+			return !states.empty();
+		}
+
+		// Worker which generates a shard
+		class Worker {
+		public:
+			Worker(const Options &options, const std::vector<GameState> &states, uint32_t seed) :
+				options_(options),
+				states_(states),
+				sim_(options.friction),
+				engine_(seed),
+				normal_(0.0f, 1.0f) {
+				sim_.num_freeguard_ = options.freeguard_num;
+				sim_.area_freeguard_ = b2simulator::IN_FREEGUARD;
+			}
+
+			// Write num_records records to shard
+			bool Run(const string &path, const TrainingDataHeader &header, uint64_t num_records) {
+				std::ofstream ofs(path, std::ios::binary);
+				if (!ofs.is_open()) {
+					cerr << "failed to create " << path << endl;
+					return false;
+				}
+				ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+				std::vector<TrainingRecord> buffer;
+				buffer.reserve(kWriteBufferRecords);
+				uint32_t state_id = 0;
+				uint64_t written = 0;
+				while (written < num_records) {
+					GameState gs = SampleState();
+					unsigned int n = (unsigned int)std::min<uint64_t>(options_.candidates, num_records - written);
+					for (unsigned int i = 0; i < n; i++) {
+						buffer.push_back(Simulate(gs, state_id));
+						if (buffer.size() == kWriteBufferRecords) {
+							ofs.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(TrainingRecord));
+							buffer.clear();
+						}
+					}
+					written += n;
+					state_id++;
+				}
+				ofs.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(TrainingRecord));
+
+				if (!ofs) {
+					cerr << "failed to write " << path << endl;
+					return false;
+				}
+				return true;
+			}
+
+		private:
+			// State from logs, or random shots from the start of a random end
+			GameState SampleState() {
+				if (!states_.empty()) {
+					return states_[std::uniform_int_distribution<size_t>(0, states_.size() - 1)(engine_)];
+				}
+
+				GameState gs(kLastEndMax);
+				gs.CurEnd = std::uniform_int_distribution<unsigned int>(0, kLastEndMax - 1)(engine_);
+				gs.WhiteToMove = (std::uniform_int_distribution<int>(0, 1)(engine_) != 0);
+				unsigned int shots = std::uniform_int_distribution<unsigned int>(0, 15)(engine_);
+				for (unsigned int i = 0; i < shots; i++) {
+					ShotVec vec = Noise(CandidateShot(gs));
+					sim_.Simulation(&gs, vec, 0.0f, 0.0f, nullptr, nullptr, 0);
+				}
+				return gs;
+			}
+
+			// Random draw shot to the house or guard zone, or hit shot to a stone in play
+			ShotVec CandidateShot(const GameState &gs) {
+				ShotVec vec;
+				bool angle = (std::uniform_int_distribution<int>(0, 1)(engine_) != 0);
+
+				std::vector<unsigned int> stones;
+				for (unsigned int i = 0; i < gs.ShotNum; i++) {
+					if (b2simulator::GetStoneArea(ShotPos(gs.body[i][0], gs.body[i][1], angle)) & b2simulator::IN_PLAYAREA) {
+						stones.push_back(i);
+					}
+				}
+				if (!stones.empty() && std::uniform_int_distribution<int>(0, 1)(engine_) != 0) {
+					unsigned int i = stones[std::uniform_int_distribution<size_t>(0, stones.size() - 1)(engine_)];
+					float weight = std::uniform_real_distribution<float>(1.0f, 16.0f)(engine_);
+					sim_.CreateHitShot(ShotPos(gs.body[i][0], gs.body[i][1], angle), weight, &vec);
+				}
+				else {
+					float x = std::uniform_real_distribution<float>(kCenterX - kHouseR, kCenterX + kHouseR)(engine_);
+					float y = std::uniform_real_distribution<float>(kTeeY - kHouseR, kHogY - kHouseR)(engine_);
+					sim_.CreateShot(ShotPos(x, y, angle), &vec);
+				}
+				return vec;
+			}
+
+			// Shot with noise drawn from engine_ (the simulator draws from its own generator otherwise)
+			ShotVec Noise(ShotVec vec) {
+				float r1 = normal_(engine_);
+				float r2 = normal_(engine_);
+				sim_.AddNoise2Vec(r1 * options_.random[0], r2 * options_.random[1], &vec);
+				return vec;
+			}
+
+			// Simulate a candidate shot from gs
+			TrainingRecord Simulate(const GameState &gs, uint32_t state_id) {
+				TrainingRecord record;
+				record.state_id = state_id;
+				record.cur_end = gs.CurEnd;
+				record.last_end = gs.LastEnd;
+				record.shot_num = gs.ShotNum;
+				record.white_to_move = (gs.WhiteToMove) ? 1 : 0;
+				memcpy(record.before, gs.body, sizeof(record.before));
+
+				ShotVec shot = CandidateShot(gs);
+				ShotVec run_shot = Noise(shot);
+				GameState after = gs;
+				sim_.Simulation(&after, run_shot, 0.0f, 0.0f, nullptr, nullptr, 0);
+
+				record.shot[0] = shot.x;
+				record.shot[1] = shot.y;
+				record.shot[2] = (shot.angle) ? 1.0f : 0.0f;
+				record.run_shot[0] = run_shot.x;
+				record.run_shot[1] = run_shot.y;
+				record.run_shot[2] = (run_shot.angle) ? 1.0f : 0.0f;
+				memcpy(record.after, after.body, sizeof(record.after));
+				record.score = b2simulator::Simulator::GetScore(&after);
+				return record;
+			}
+
+			const Options &options_;
+			const std::vector<GameState> &states_;
+			b2simulator::Simulator sim_;
+			std::mt19937 engine_;
+			std::normal_distribution<float> normal_;
+		};
+
+		// Generate shards in parallel
+		static bool Generate(const Options &options) {
+			std::vector<GameState> states;
+			if (!options.logs.empty() && !LoadStates(options.logs, states)) {
+				cerr << "no states in logs." << endl;
+				return false;
+			}
+
+			unsigned int num_threads = (options.threads > 0) ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+			cout << "> generate " << options.num_records << " records with " << num_threads << " threads (seed " << options.seed << ")." << endl;
+
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			std::atomic<unsigned int> num_failed(0);
+			std::vector<std::thread> threads;
+			for (unsigned int i = 0; i < num_threads; i++) {
+				// Records are divided equally (first shards have one more)
+				uint64_t num_records = options.num_records / num_threads + ((i < options.num_records % num_threads) ? 1 : 0);
+				threads.push_back(std::thread([&options, &states, &num_failed, i, num_records]() {
+					TrainingDataHeader header;
+					memset(&header, 0, sizeof(header));
+					memcpy(header.magic, kTrainingDataMagic, sizeof(header.magic));
+					header.version = kTrainingDataVersion;
+					header.header_size = sizeof(TrainingDataHeader);
+					header.record_size = sizeof(TrainingRecord);
+					header.source = (states.empty()) ? SOURCE_ROLLOUT : SOURCE_LOG;
+					header.seed = options.seed + i;
+					header.candidates = options.candidates;
+					header.random[0] = options.random[0];
+					header.random[1] = options.random[1];
+					header.friction = options.friction;
+					header.freeguard_num = options.freeguard_num;
+
+					// Simulator of each thread (initialization of tables takes time)
+					Worker worker(options, states, header.seed);
+					if (!worker.Run(options.prefix + "_" + std::to_string(i) + ".dct", header, num_records)) {
+						num_failed++;
+					}
+				}));
+			}
+			for (std::thread &thread : threads) {
+				thread.join();
+			}
+
+			double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			cout << "> wrote " << num_threads << " shards " << options.prefix << "_*.dct in " << sec << " sec (" <<
+				(uint64_t)(options.num_records / std::max(sec, 1e-9)) << " records/sec)." << endl;
+			return num_failed == 0;
+		}
+
+		static void PrintUsage() {
+			cerr << "usage: DataGenerator [-o PREFIX] [-n NUM] [-c CANDIDATES] [-t THREADS] [-s SEED] [-r R1 R2] [-f FRICTION] [-g FREEGUARD] [LOG...]" << endl;
+			cerr << "  -o PREFIX     : shards are written to PREFIX_<thread>.dct (default: train)" << endl;
+			cerr << "  -n NUM        : number of records of all shards (default: 100000)" << endl;
+			cerr << "  -c CANDIDATES : number of candidate shots for each state (default: 16)" << endl;
+			cerr << "  -t THREADS    : number of threads (default: number of cores)" << endl;
+			cerr << "  -s SEED       : seed of random numbers (default: random)" << endl;
+			cerr << "  -r R1 R2      : random_1 and random_2 of noise (default: 0.0725 0.29)" << endl;
+			cerr << "  -f FRICTION   : friction of simulator (default: 12.009216)" << endl;
+			cerr << "  -g FREEGUARD  : number of shots of freeguard rule (default: 5)" << endl;
+			cerr << "  LOG...        : logs (.dcl or .dcb, or directories of them) as states (default: random rollouts)" << endl;
+		}
+	}
+}
+
+int main(int argc, char* argv[]) {
+	using namespace digital_curling::generator;
+
+	Options options;
+	options.seed = std::random_device()();
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		bool has_value = (i + 1 < argc);
+		if (arg == "-o" && has_value) {
+			options.prefix = argv[++i];
+		}
+		else if (arg == "-n" && has_value) {
+			options.num_records = std::strtoull(argv[++i], nullptr, 10);
+		}
+		else if (arg == "-c" && has_value) {
+			options.candidates = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+		}
+		else if (arg == "-t" && has_value) {
+			options.threads = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+		}
+		else if (arg == "-s" && has_value) {
+			options.seed = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+		}
+		else if (arg == "-r" && i + 2 < argc) {
+			options.random[0] = std::strtof(argv[++i], nullptr);
+			options.random[1] = std::strtof(argv[++i], nullptr);
+		}
+		else if (arg == "-f" && has_value) {
+			options.friction = std::strtof(argv[++i], nullptr);
+		}
+		else if (arg == "-g" && has_value) {
+			options.freeguard_num = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+		}
+		else if (arg == "-h" || arg == "--help" || arg[0] == '-') {
+			PrintUsage();
+			return (arg[0] == '-' && arg != "-h" && arg != "--help") ? 1 : 0;
+		}
+		else {
+			options.logs.push_back(arg);
+		}
+	}
+	if (options.num_records == 0 || options.candidates == 0) {
+		PrintUsage();
+		return 1;
+	}
+
+	return Generate(options) ? 0 : 1;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+
+namespace digital_curling {
+
+	// Shard of training data (.dct)
+	// A file is a TrainingDataHeader and TrainingRecords following it
+	// All fields are 4 bytes (little-endian, no padding), so the file can be memory-mapped
+	// as the header and an array of records (e.g. numpy.memmap with offset header_size)
+	// Number of records = (file size - header_size) / record_size
+
+	const char     kTrainingDataMagic[4] = { 'D', 'C', 'T', '1' };
+	const uint32_t kTrainingDataVersion = 1;
+
+	// Source of states
+	enum : uint32_t {
+		SOURCE_ROLLOUT = 0,  // random shots from the start of an end
+		SOURCE_LOG     = 1   // positions before shots of logs (.dcl or .dcb)
+	};
+
+	// Header of shard
+	struct TrainingDataHeader {
+		char     magic[4];          // kTrainingDataMagic
+		uint32_t version;           // kTrainingDataVersion
+		uint32_t header_size;       // sizeof(TrainingDataHeader)
+		uint32_t record_size;       // sizeof(TrainingRecord)
+		uint32_t source;            // SOURCE_ROLLOUT or SOURCE_LOG
+		uint32_t seed;              // seed of random numbers of this shard
+		uint32_t candidates;        // number of candidate shots for each state
+		float    random[2];         // random_1 and random_2 of noise
+		float    friction;          // friction of simulator
+		uint32_t freeguard_num;     // number of shots of freeguard rule
+		uint32_t reserved;          // 0
+	};
+
+	// Record of shard (a candidate shot from a state)
+	struct TrainingRecord {
+		uint32_t state_id;          // index of state in the shard (records of a state are consecutive)
+		uint32_t cur_end;           // CurEnd
+		uint32_t last_end;          // LastEnd
+		uint32_t shot_num;          // ShotNum before the shot
+		uint32_t white_to_move;     // WhiteToMove
+		float    before[16][2];     // position of stones before the shot
+		float    shot[3];           // candidate shot (x, y, angle)
+		float    run_shot[3];       // shot with noise (x, y, angle)
+		float    after[16][2];      // position of stones after the shot
+		int32_t  score;             // score for second player if the end finished after the shot (GetScore())
+	};
+
+	static_assert(sizeof(TrainingDataHeader) == 48, "TrainingDataHeader must not have padding");
+	static_assert(sizeof(TrainingRecord) == 4 * 76, "TrainingRecord must not have padding");
+}
@@ -4,19 +4,50 @@
 // also how to use digital_curling::b2simulator.
 //======================================================
 
+#ifdef _WIN32
+#include <winsock2.h>  // must be included before windows.h
+#include <ws2tcpip.h>
 #include <windows.h>
+#else
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <strings.h>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+// Functions of MSVC used in this sample
+#define TRUE true
+#define FALSE false
+#define _stricmp strcasecmp
+#define sprintf_s snprintf
+#define strcpy_s(dest, size, src) (void)snprintf(dest, size, "%s", src)
+#define strncpy_s(dest, size, src, count) (void)snprintf(dest, size, "%.*s", (int)(count), src)
+#define closesocket close
+#endif
 #include <iostream>
+#include <string>
 #include <vector>
 #include <algorithm>
 
 #include "../Simulator/dcurling_simulator.h"
+#include "../Simulator/dcurling_evaluator.h"
+#include "../Simulator/dcurling_dcp.h"
+#include "../Simulator/dcurling_last_shot.h"
 
+#ifdef _MSC_VER
 #ifdef _DEBUG
 #pragma comment( lib, "../x64/Debug/Simulator.lib" )
 #endif
 #ifndef _DEBUG
 #pragma comment( lib, "../x64/Release/Simulator.lib" )
 #endif
+#pragma comment( lib, "ws2_32.lib" )
+#endif
+
+namespace dcp = digital_curling::dcp;
 
 // type of rule
 enum {
@@ -26,6 +57,19 @@ enum {
 
 constexpr unsigned int kBufferSize = 1024;  // Buffer size
 
+// Socket connected to the server (only for network mode, see 'Network transport' on DCP.md)
+#ifdef _WIN32
+typedef SOCKET socket_t;
+const socket_t kNoSocket = INVALID_SOCKET;
+#else
+typedef int socket_t;
+const socket_t kNoSocket = -1;
+#endif
+socket_t server_socket = kNoSocket;
+
+// Binary DCP is used after 'READYOK BIN1' (see 'Binary DCP' on DCP.md)
+bool binary_mode = false;
+
 digital_curling::b2simulator::Simulator *sim = nullptr;  // simulator
 
 unsigned int power_play_count = 0;
@@ -57,11 +101,19 @@ struct STATE {
 void Send(const char* const Message);
 void Recv(char* Message, size_t Size);
 bool DoCommand(char *Message);
+bool Listen(int Port);
 
-int main()
+// Usage: 'SampleAI' (messages from stdin/stdout) or 'SampleAI port' (network mode)
+int main(int argc, char *argv[])
 {
 	char Message[kBufferSize];
 
+	// Wait for the server to connect in network mode
+	if (argc >= 2 && !Listen(atoi(argv[1]))) {
+		std::cerr << "failed to listen on port " << argv[1] << std::endl;
+		return 1;
+	}
+
 	while (1) {
 		memset(Message, 0x00, sizeof(Message));
 
@@ -75,18 +127,185 @@ int main()
 	return 0;
 }
 
-// Send Message
+// Wait for the server to connect to Port (network mode)
+bool Listen(int Port)
+{
+#ifdef _WIN32
+	WSADATA wsa_data;
+	if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) {
+		return false;
+	}
+#endif
+	socket_t listen_socket = socket(AF_INET, SOCK_STREAM, 0);
+	if (listen_socket == kNoSocket) {
+		return false;
+	}
+	int flag = 1;
+	setsockopt(listen_socket, SOL_SOCKET, SO_REUSEADDR, (const char*)&flag, sizeof(flag));
+
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons((unsigned short)Port);
+	if (bind(listen_socket, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listen_socket, 1) != 0) {
+		closesocket(listen_socket);
+		return false;
+	}
+
+	server_socket = accept(listen_socket, NULL, NULL);
+	closesocket(listen_socket);
+	if (server_socket == kNoSocket) {
+		return false;
+	}
+
+	// Send small frames at once (disable Nagle's algorithm)
+	setsockopt(server_socket, IPPROTO_TCP, TCP_NODELAY, (const char*)&flag, sizeof(flag));
+
+	return true;
+}
+
+// Write bytes to the server (exit if the server disconnected or closed pipe)
+void Write(const char *Data, size_t Size)
+{
+	while (Size > 0) {
+		if (server_socket != kNoSocket) {
+			int n = send(server_socket, Data, (int)Size, 0);
+			if (n <= 0) {
+				exit(0);
+			}
+			Data += n;
+			Size -= n;
+			continue;
+		}
+#ifdef _WIN32
+		DWORD NumberOfBytesWritten = 0;
+		if (!WriteFile(GetStdHandle(STD_OUTPUT_HANDLE), Data, (DWORD)Size, &NumberOfBytesWritten, NULL)) {
+			exit(0);
+		}
+#else
+		ssize_t NumberOfBytesWritten = write(STDOUT_FILENO, Data, Size);
+		if (NumberOfBytesWritten < 0) {
+			exit(0);
+		}
+#endif
+		Data += NumberOfBytesWritten;
+		Size -= NumberOfBytesWritten;
+	}
+}
+
+// Read bytes from the server (exit if the server disconnected or closed pipe)
+size_t Read(char *Data, size_t Size)
+{
+	if (server_socket != kNoSocket) {
+		int NumberOfBytesRead = recv(server_socket, Data, (int)Size, 0);
+		if (NumberOfBytesRead <= 0) {
+			exit(0);
+		}
+		return NumberOfBytesRead;
+	}
+#ifdef _WIN32
+	DWORD NumberOfBytesRead = 0;
+	if (!ReadFile(GetStdHandle(STD_INPUT_HANDLE), Data, (DWORD)Size, &NumberOfBytesRead, NULL) ||
+		NumberOfBytesRead == 0) {
+		exit(0);
+	}
+#else
+	ssize_t NumberOfBytesRead = read(STDIN_FILENO, Data, Size);
+	if (NumberOfBytesRead <= 0) {
+		exit(0);
+	}
+#endif
+	return NumberOfBytesRead;
+}
+
+// Send a frame to the server (network mode or binary DCP)
+//  Seq is given only for ACK, other frames are numbered in network mode (0 through pipes)
+void SendFrame(unsigned char Type, const char *Data, size_t Size, unsigned int Seq = 0)
+{
+	static unsigned int seq = 0;
+	if (Type != dcp::FRAME_ACK && server_socket != kNoSocket) {
+		Seq = ++seq;
+	}
+
+	char frame[dcp::kFrameHeaderSize + kBufferSize];
+	Write(frame, dcp::WriteFrame(Type, Seq, Data, Size, frame, sizeof(frame)));
+}
+
+// Recieve a frame from the server and append its message to Buffer (network mode or binary DCP)
+//  State in frame is set to state.gs directly, and 'GO' in frame is appended as a message
+void RecvFrame(std::string &Buffer)
+{
+	static std::string frames;  // recieved data which is not decoded yet
+
+	// Read until a whole frame is recieved
+	dcp::Frame frame;
+	size_t size;
+	while ((size = dcp::ReadFrame(frames.data(), frames.size(), &frame)) == 0) {
+		char data[kBufferSize];
+		frames.append(data, Read(data, sizeof(data)));
+	}
+
+	// Return ACK as soon as a frame is recieved (the server measures round trip time with it)
+	if (server_socket != kNoSocket && frame.type != dcp::FRAME_ACK) {
+		SendFrame(dcp::FRAME_ACK, "", 0, frame.seq);
+	}
+
+	char Message[kBufferSize];
+	int time_remain1, time_remain2;
+	switch (frame.type) {
+	case dcp::FRAME_MESSAGE:
+		Buffer.append(frame.data, frame.size);
+		Buffer.push_back(0x00);
+		break;
+	case dcp::FRAME_STATE:
+		dcp::DecodeState(frame.data, frame.size, &state.gs);
+		break;
+	case dcp::FRAME_GO:
+		if (dcp::DecodeGo(frame.data, frame.size, &time_remain1, &time_remain2)) {
+			Buffer.append(Message, dcp::FormatGo(time_remain1, time_remain2, Message, sizeof(Message)));
+			Buffer.push_back(0x00);
+		}
+		break;
+	default:
+		break;
+	}
+	frames.erase(0, size);
+}
+
+// Send Message (a message is terminated by '\n')
 void Send(const char* const Message)
 {
-	DWORD NumberOfBytesWritten;
-	WriteFile(GetStdHandle(STD_OUTPUT_HANDLE), Message, (DWORD)strlen(Message), &NumberOfBytesWritten, NULL);
+	if (server_socket != kNoSocket || binary_mode) {
+		SendFrame(dcp::FRAME_MESSAGE, Message, strlen(Message));
+		return;
+	}
+
+	std::string line = std::string(Message) + "\n";
+	Write(line.data(), line.size());
 }
 
-// Recv Message
+// Recv Message (a message from the server is terminated by '\0' or '\n')
 void Recv(char* Message, size_t Size)
 {
-	DWORD NumberOfBytesRead;
-	ReadFile(GetStdHandle(STD_INPUT_HANDLE), Message, (DWORD)Size, &NumberOfBytesRead, NULL);
+	static std::string buffer;  // recieved data which is not processed yet
+	size_t pos;
+
+	// Read until a whole message is recieved
+	while ((pos = buffer.find_first_of(std::string("\n\0", 2))) == std::string::npos) {
+		if (server_socket != kNoSocket || binary_mode) {
+			RecvFrame(buffer);
+			continue;
+		}
+
+		char data[kBufferSize];
+		buffer.append(data, Read(data, sizeof(data)));
+	}
+
+	size_t len = (pos < Size - 1) ? pos : Size - 1;
+	memcpy(Message, buffer.data(), len);
+	Message[len] = 0x00;
+	buffer.erase(0, pos + 1);
 }
 
 // Delete new line
@@ -226,32 +445,28 @@ namespace digital_curling{
 					//std::cerr << "CreateHitShot " << pos.x << " " << pos.y << " " << pos.angle << std::endl;
 					sim->CreateHitShot(pos, weight, &vecs[0]);
 					pos.angle = 1;
-					sim->CreateHitShot(pos, weight, &vecs[0]);
-
-					int saccess[2] = {0, 0};
-
-					for (int i = 0; i < 100; i++) {
-						for (int j = 0; j < 2; j++) {
-							GameState gstmp = *gs;
-							sim->Simulation(&gstmp, vecs[j], state.params[order_table[gs->ShotNum / 2]].rand_1, state.params[order_table[gs->ShotNum / 2]].rand_2, nullptr, nullptr, -1);
-
-							int NumberOneStone = GetNumberOneStone(gs, &pos);
-							if ((NumberOneStone % 2) == (gs->ShotNum % 2)) {
-								saccess[j++];
-							}
-						}
-					}
-
-					int saccess_max = -1;
-					int num_best = 0;
-					for (int i = 0; i < 2; i++) {
-						if (saccess_max < saccess[i]) {
-							saccess_max = saccess[i];
-							num_best = i;
-						}
-					}
-
-					return vecs[num_best];
+					sim->CreateHitShot(pos, weight, &vecs[1]);
+
+					// Success if No.1 stone is mine after the shot
+					auto success = [](const GameState &before, const GameState &after) {
+						GameState gstmp = after;
+						ShotPos pos_one;
+						int NumberOneStone = GetNumberOneStone(&gstmp, &pos_one);
+						return ((NumberOneStone % 2) == (int)(before.ShotNum % 2)) ? 1.0f : 0.0f;
+					};
+
+					// Evaluate both shots, and stop early if one is clearly better
+					search::RaceOptions options;
+					options.batch = 20;
+					options.max_samples = 100;
+					options.time_limit = 1000;
+					std::vector<search::RaceResult> results = search::RaceShots(
+						sim, *gs, std::vector<ShotVec>(vecs, vecs + 2),
+						state.params[order_table[gs->ShotNum / 2]].rand_1,
+						state.params[order_table[gs->ShotNum / 2]].rand_2,
+						success, options);
+
+					return results[0].shot;
 				}
 			}
 		}
@@ -265,6 +480,36 @@ namespace digital_curling{
 
 		return vec;
 	}
+
+	// Minimum time for GetLastShot() [msec] (a simple shot is returned with less time)
+	constexpr unsigned int kLastShotTimeMin = 500;
+
+	// Search last shot of the end (ShotNum 15) with a part of time remaining [msec]
+	ShotVec GetLastShot(GameState *gs, unsigned int timelimit)
+	{
+		unsigned int time_limit = std::min(3000u, timelimit / 10);
+		if (time_limit < kLastShotTimeMin) {
+			std::cerr << "last shot: no time to search (" << time_limit << " msec)" << std::endl;
+			return GetSimpleShot(gs);
+		}
+
+		const int *order_table = (state.rule_type == NORMAL) ?
+			state.shotnum_order_table_normal :
+			state.shotnum_order_table_mix_doubles;
+		const auto &param = state.params[order_table[gs->ShotNum / 2]];
+
+		// Hit shots up to the maximum weight of the player
+		float weight_max = (param.shot_max == 50) ? state.weight_max_50 : state.weight_max_75;
+		search::LastShotOptions options;
+		options.hit_weights = { 0.25f * weight_max, 0.5f * weight_max, weight_max };
+		options.race.time_limit = time_limit;
+
+		search::LastShotResult result = search::SolveLastShot(sim, *gs, param.rand_1, param.rand_2, options);
+		std::cerr << "last shot: expected score = " << result.estimate.mean << " (" << result.num_candidates << " candidates, " <<
+			result.num_pruned << " pruned, " << result.num_simulations << " simulations)" << std::endl;
+
+		return result.shot;
+	}
 }
 
 // Process command
@@ -379,7 +624,14 @@ bool DoCommand(char *Message)
 		//cerr << "weight_max = " << state.weight_max_50 << " " << state.weight_max_75 << endl;
 
 		// Return 'READYOK' to the server
-		Send("READYOK");
+		//  Accept binary DCP if the server offers it ('ISREADY BIN1')
+		if (dcp::Tokens(Message)[1] == dcp::kBinaryVersion) {
+			Send("READYOK BIN1");
+			binary_mode = true;
+		}
+		else {
+			Send("READYOK");
+		}
 	}
 	else if (_stricmp(CMD, "POSITION") == 0) {
 		//======================================================
@@ -387,18 +639,8 @@ bool DoCommand(char *Message)
 		//  You can get positions from 'POSITION'.
         //======================================================
 
-		for (unsigned int i = 0; i < 16; i++) {
-			// X coordinate
-			if (!GetArgument(Buffer, sizeof(Buffer), Message, 2 * i + 1)) {
-				return false;
-			}
-			state.gs.body[i][0] = (float)atof(Buffer);
-
-			// Y coordinate
-			if (!GetArgument(Buffer, sizeof(Buffer), Message, 2 * i + 2)) {
-				return false;
-			}
-			state.gs.body[i][1] = (float)atof(Buffer);
+		if (!dcp::ParsePosition(dcp::Tokens(Message), &state.gs)) {
+			return false;
 		}
 	}
 	else if (_stricmp(CMD, "SETSTATE") == 0) {
@@ -407,34 +649,11 @@ bool DoCommand(char *Message)
 		//  You can get information about shot, end, move from 'SETSTATE'
 		//======================================================
 
-		// Get number of shots
-		if (GetArgument(Buffer, sizeof(Buffer), Message, 1) == FALSE) {
+		// Get number of shots, number of ends, number of last end
+		// and info about move (false: first player in 1st end, true: second player in 1st end)
+		if (!dcp::ParseSetState(dcp::Tokens(Message), &state.gs)) {
 			return false;
 		}
-		state.gs.ShotNum = atoi(Buffer);
-
-		// Get number of ends
-		if (GetArgument(Buffer, sizeof(Buffer), Message, 2) == FALSE) {
-			return false;
-		}
-		state.gs.CurEnd = atoi(Buffer);
-
-		// Gen number of last end
-		if (GetArgument(Buffer, sizeof(Buffer), Message, 3) == FALSE) {
-			return false;
-		}
-		state.gs.LastEnd = atoi(Buffer);
-
-		// Get info about move (false: first player in 1st end, true: second player in 1st end)
-		if (GetArgument(Buffer, sizeof(Buffer), Message, 4) == FALSE) {
-			return false;
-		}
-		if (atoi(Buffer) == 1) {
-			state.gs.WhiteToMove = true;
-		}
-		else {
-			state.gs.WhiteToMove = false;
-		}
 	}
 	else if (_stricmp(CMD, "SETORDER") == 0) {
 		//======================================================
@@ -484,22 +703,26 @@ bool DoCommand(char *Message)
 		// Note: WhiteToMove represents your move in 1st end (false: first, true: second)
 		move_info = state.gs.WhiteToMove;
 		int arg_num = (move_info)? 2 : 1;
-		if (GetArgument(Buffer, sizeof(Buffer), Message, arg_num)) {
-			timelimit = atoi(Buffer);
-		}
-		else {
+		if (!dcp::Tokens(Message).Get(arg_num, &timelimit)) {
 			timelimit = INT_MAX;
 		}
 		cerr << "timelimit = " << timelimit << endl;
 
 		// Calclate shot vector to return
-		ShotVec vec = GetSimpleShot(&state.gs);
+		ShotVec vec = (state.gs.ShotNum == 15) ? GetLastShot(&state.gs, timelimit) : GetSimpleShot(&state.gs);
 
 		// őPVbg̑M
-		sprintf_s(Buffer, sizeof(Buffer), "BESTSHOT %f %f %d", vec.x, vec.y, vec.angle);
+		dcp::FormatBestShot(vec, Buffer, sizeof(Buffer));
 		cerr << Buffer << endl;
-		cout << Buffer << endl;
-		//Send(Buffer);
+		if (binary_mode) {
+			// Send shot vector in frame (without conversion to text)
+			char data[dcp::kShotSize];
+			dcp::EncodeShot(vec, data);
+			SendFrame(dcp::FRAME_BESTSHOT, data, sizeof(data));
+		}
+		else {
+			Send(Buffer);
+		}
 	}
 	else if (_stricmp(CMD, "SCORE") == 0) {
 		if (GetArgument(Buffer, sizeof(Buffer), Message, 1) == FALSE) {
@@ -0,0 +1,97 @@
+#pragma once
+
+// C ABI of AI plugin (shared library loaded by the server in its own process)
+//
+// A plugin exports 'dc_plugin_entry' which returns a table of functions.
+// The server calls them directly instead of sending DCP messages through pipes:
+//   create       : loading of plugin         destroy      : unloading of plugin
+//   on_new_game  : 'NEWGAME' + 'GAMEINFO'    on_state     : 'POSITION' + 'SETSTATE'
+//   go           : 'GO'                      put_stone    : 'PUTSTONE'
+//   set_order    : 'SETORDER'                on_score     : 'SCORE'
+//   on_game_over : 'GAMEOVER'
+// Time used by go() is accounted as time of 'GO' for LocalPlayer (a shot after time limit is timeout).
+// Functions other than create, destroy and go may be NULL.
+
+#ifdef _WIN32
+#define DC_PLUGIN_EXPORT __declspec(dllexport)
+#else
+#define DC_PLUGIN_EXPORT __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DC_PLUGIN_VERSION 1
+#define DC_PLUGIN_ENTRY "dc_plugin_entry"
+
+// Return values of go()
+enum {
+	DC_PLUGIN_BESTSHOT = 0,
+	DC_PLUGIN_CONCEDE  = 1
+};
+
+// Result of a game (on_game_over())
+enum {
+	DC_PLUGIN_LOSE = -1,
+	DC_PLUGIN_DRAW = 0,
+	DC_PLUGIN_WIN  = 1
+};
+
+// Same as digital_curling::GameState
+typedef struct DCPluginState {
+	unsigned int shot_num;  // number of current shot
+	unsigned int cur_end;   // number of current end (0 to last_end - 1)
+	unsigned int last_end;  // number of last end
+	int score[10];          // score of each end (> 0: first player scored)
+	int white_to_move;      // which have next shot (0: first, 1: second)
+	float body[16][2];      // position of stones
+} DCPluginState;
+
+// Same as digital_curling::ShotVec
+typedef struct DCPluginShot {
+	float x;    // x-conponent
+	float y;    // y-conponent
+	int angle;  // curl angle
+} DCPluginShot;
+
+// Information of a game
+typedef struct DCPluginGameInfo {
+	const char *name[2];     // names of players (first, second)
+	int rule_type;           // type of rule (0: standard, 1: mix doubles)
+	int random_type;         // type of random number generator
+	unsigned int nplayers;   // number of players of this plugin
+	float params[4][3];      // random_1, random_2, weight_max of each player
+} DCPluginGameInfo;
+
+typedef struct DCPlugin {
+	unsigned int version;  // DC_PLUGIN_VERSION
+
+	// Create instance of AI (returns NULL if failed)
+	void *(*create)(void);
+	// Destroy instance of AI
+	void (*destroy)(void *ai);
+
+	// New game is started
+	void (*on_new_game)(void *ai, const DCPluginGameInfo *info);
+	// State of the game is updated
+	void (*on_state)(void *ai, const DCPluginState *gs);
+	// Set shot to *shot and return DC_PLUGIN_BESTSHOT (or return DC_PLUGIN_CONCEDE)
+	//   time_remain: time limit remaining of each player [msec]
+	int (*go)(void *ai, const DCPluginState *gs, const int time_remain[2], DCPluginShot *shot);
+	// Return type of placement of stones for mix doubles (0 to 3)
+	int (*put_stone)(void *ai, const DCPluginState *gs);
+	// Return order of players for mix doubles (0: '0 1', 1: '1 0')
+	int (*set_order)(void *ai, const DCPluginState *gs);
+	// Score of current end (> 0: first player scored)
+	void (*on_score)(void *ai, int score);
+	// Game is over
+	void (*on_game_over)(void *ai, int result);
+} DCPlugin;
+
+// Type of 'dc_plugin_entry'
+typedef const DCPlugin *(*DCPluginEntry)(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -5,7 +5,9 @@
 //#include "CurlingSimulator.h"
 #include "dcurling_simulator.h"
 
+#ifdef _WIN32
 #include <Windows.h>
+#endif
 
 #include <iostream>
 #include <string>
@@ -0,0 +1,130 @@
+#include "event_loop.h"
+
+#ifndef _WIN32
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <iostream>
+
+#include "game_player.h"
+
+using std::cerr;
+using std::endl;
+
+namespace digital_curling {
+
+	EventLoop& EventLoop::Instance() {
+		static EventLoop loop;
+		return loop;
+	}
+
+	EventLoop::EventLoop() {
+		epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+		wake_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+		if (epoll_fd_ < 0 || wake_fd_ < 0) {
+			cerr << "failed to create epoll for EventLoop" << endl;
+			return;
+		}
+
+		epoll_event ev;
+		ev.events = EPOLLIN;
+		ev.data.fd = wake_fd_;
+		epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+
+		thread_ = std::thread(&EventLoop::Run, this);
+	}
+
+	EventLoop::~EventLoop() {
+		// Wake up and stop I/O thread
+		if (thread_.joinable()) {
+			uint64_t one = 1;
+			ssize_t ret = write(wake_fd_, &one, sizeof(one));
+			(void)ret;
+			thread_.join();
+		}
+		if (epoll_fd_ >= 0) {
+			close(epoll_fd_);
+		}
+		if (wake_fd_ >= 0) {
+			close(wake_fd_);
+		}
+	}
+
+	// Start reading from fd
+	bool EventLoop::Add(int fd, Player *player) {
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+		epoll_event ev;
+		ev.events = EPOLLIN;
+		ev.data.fd = fd;
+		if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+			cerr << "failed to add fd " << fd << " to EventLoop" << endl;
+			return false;
+		}
+		players_[fd] = player;
+
+		return true;
+	}
+
+	// Stop reading from fd
+	void EventLoop::Remove(int fd) {
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		std::map<int, Player*>::iterator it = players_.find(fd);
+		if (it != players_.end()) {
+			epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+			players_.erase(it);
+		}
+	}
+
+	// Loop of I/O thread
+	void EventLoop::Run() {
+		epoll_event events[kMaxEvents];
+		char buffer[Player::kBufferSize];
+
+		while (true) {
+			int n = epoll_wait(epoll_fd_, events, kMaxEvents, -1);
+			if (n < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				cerr << "epoll_wait failed in EventLoop" << endl;
+				return;
+			}
+
+			std::lock_guard<std::mutex> lock(mutex_);
+			for (int i = 0; i < n; i++) {
+				int fd = events[i].data.fd;
+				if (fd == wake_fd_) {
+					return;
+				}
+
+				// Skip fd removed after epoll_wait()
+				std::map<int, Player*>::iterator it = players_.find(fd);
+				if (it == players_.end()) {
+					continue;
+				}
+
+				ssize_t size = read(fd, buffer, sizeof(buffer));
+				if (size > 0) {
+					it->second->DeliverData(buffer, (size_t)size);
+				}
+				else if (size == 0 || (errno != EAGAIN && errno != EINTR)) {
+					// Process exited
+					epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+					it->second->CloseQueue();
+					players_.erase(it);
+				}
+			}
+		}
+	}
+}
+
+#endif
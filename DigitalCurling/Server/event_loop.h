@@ -0,0 +1,44 @@
+#pragma once
+
+#ifndef _WIN32
+
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace digital_curling {
+
+	class Player;
+
+	// Loop which reads from pipes and sockets of all players on one I/O thread with epoll (not for Windows)
+	// Received bytes are delivered to queue of each player as messages
+	class EventLoop {
+	public:
+		static const int kMaxEvents = 64;  // number of events handled at once
+
+		// EventLoop of the server process (the I/O thread starts at first call)
+		static EventLoop& Instance();
+
+		// Start reading from fd (set to non-blocking) and deliver messages to player
+		bool Add(int fd, Player *player);
+		// Stop reading from fd (nothing is delivered to the player after this function returns)
+		void Remove(int fd);
+
+	private:
+		EventLoop();
+		~EventLoop();
+		EventLoop(const EventLoop&) = delete;
+		EventLoop& operator=(const EventLoop&) = delete;
+
+		// Loop of I/O thread
+		void Run();
+
+		int epoll_fd_;
+		int wake_fd_;                     // eventfd to stop the loop
+		std::map<int, Player*> players_;  // players by fd
+		std::mutex mutex_;                // for players_ (held while delivering)
+		std::thread thread_;              // I/O thread
+	};
+}
+
+#endif
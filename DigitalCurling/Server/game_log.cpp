@@ -2,54 +2,94 @@
 
 #include "game_log.h"
 
+#include <chrono>
+#include <cstring>
 #include <ctime>
-#include <fstream>
 #include <string>
 
 using std::endl;
 
 namespace digital_curling {
 
+	// Directory of log files
+#ifdef _WIN32
+	const std::string kLogDirectory = "Log\\";
+#else
+	const std::string kLogDirectory = "Log/";
+#endif
+
 	// Create file and write 'GameInfo' statement
-	GameLog::GameLog(const Player* const p1, const Player* const p2) {
+	GameLog::GameLog(const Player* const p1, const Player* const p2) :
+		player1_(nullptr), player2_(nullptr), output_binary_(false), output_json_(false), max_buffer_size_(kMaxBufferSize), backpressure_(BLOCK), flush_requested_(false), stop_(false) {
 		Create(p1, p2);
+		flusher_ = std::thread(&GameLog::FlushLoop, this);
 	}
 
-	// Create new file
-	GameLog::~GameLog() {}
+	// Write rest of buffer and close file
+	GameLog::~GameLog() {
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stop_ = true;
+		}
+		cv_.notify_all();
+		flusher_.join();
 
+		Close();
+	}
+
+	// Create new file
 	bool GameLog::Create(const Player* const p1, const Player* const p2) {
 		if (p1 == nullptr || p2 == nullptr) {
 			return false;
 		}
 
+		// Messages to the current file are written before switching
+		Close();
+
+		// Logs of games running in parallel are created one by one
+		static std::mutex create_mutex;
+		std::lock_guard<std::mutex> create_lock(create_mutex);
+
 		// Get current time
 		char date[128];
 		time_t t = time(NULL);
 		strftime(date, sizeof(date), "(%Y%m%d_%H%M%S)", localtime(&t));
 
 		// Set filename of log e.g. 'Player1_Player2(20180131_123456).dcl'
-		std::string file_name;
-		file_name = p1->name_ + "_" + p2->name_ + date + ".dcl";
-
-		file_path_ = "Log\\" + file_name;
+		// Number is added if the file exists e.g. 'Player1_Player2(20180131_123456)_1.dcl'
+		std::string file_name = p1->name_ + "_" + p2->name_ + date;
+		std::string file_path = kLogDirectory + file_name + ".dcl";
+		for (int i = 1; std::ifstream(file_path).is_open(); i++) {
+			file_path = kLogDirectory + file_name + "_" + std::to_string(i) + ".dcl";
+		}
 
 		// Create file
-		std::ofstream ofs(file_path_);
-		if (!ofs.is_open()) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		std::lock_guard<std::mutex> file_lock(file_mutex_);
+		player1_ = p1;
+		player2_ = p2;
+		file_path_ = file_path;
+		ofs_.open(file_path_);
+		if (!ofs_.is_open()) {
 			return false;
 		}
+		if (output_binary_) {
+			binary_.Open(PathWithExtension(".dcb"), MakeHeader());
+		}
+		if (output_json_) {
+			json_.Open(PathWithExtension(".jsonl"), MakeHeader());
+		}
 
 		// Write 'GameInfo' statement
-		ofs << "[GameInfo]" << endl;
-		ofs << "First=" << p1->name_ << endl;
-		ofs << "FirstRemTime=" << p1->time_limit_ << endl;
-		ofs << "FirstRandom_1=" << p1->pinfo_.params[0].random_1 << endl;
-		ofs << "FirstRandom_2=" << p1->pinfo_.params[0].random_2 << endl;
-		ofs << "Second=" << p2->name_ << endl;
-		ofs << "SecondRemTime=" << p2->time_limit_ << endl;
-		ofs << "SecondRandom_1=" << p2->pinfo_.params[0].random_1 << endl;
-		ofs << "SecondRandom_2=" << p2->pinfo_.params[0].random_2 << endl;
+		ofs_ << "[GameInfo]" << endl;
+		ofs_ << "First=" << p1->name_ << endl;
+		ofs_ << "FirstRemTime=" << p1->time_limit_ << endl;
+		ofs_ << "FirstRandom_1=" << p1->pinfo_.params[0].random_1 << endl;
+		ofs_ << "FirstRandom_2=" << p1->pinfo_.params[0].random_2 << endl;
+		ofs_ << "Second=" << p2->name_ << endl;
+		ofs_ << "SecondRemTime=" << p2->time_limit_ << endl;
+		ofs_ << "SecondRandom_1=" << p2->pinfo_.params[0].random_1 << endl;
+		ofs_ << "SecondRandom_2=" << p2->pinfo_.params[0].random_2 << endl;
 
 		return true;
 	}
@@ -57,12 +97,147 @@ namespace digital_curling {
 	// Write to logfile
 	void GameLog::Write(std::string message)
 	{
-		// Create file
-		std::ofstream ofs(file_path_, std::ios::in | std::ios::ate);
-		if (!ofs.is_open()) {
+		std::unique_lock<std::mutex> lock(mutex_);
+
+		// Buffer is full
+		if (buffer_.size() + message.size() + 1 > max_buffer_size_) {
+			if (backpressure_ == BLOCK) {
+				flush_requested_ = true;
+				cv_.notify_all();
+				cv_.wait(lock, [&] { return buffer_.size() + message.size() + 1 <= max_buffer_size_ || buffer_.empty(); });
+			}
+			else {
+				WriteBuffer(lock);
+			}
+		}
+
+		buffer_ += message;
+		buffer_ += '\n';
+
+		// Wake up background thread
+		if (buffer_.size() >= kFlushSize) {
+			flush_requested_ = true;
+			cv_.notify_all();
+		}
+	}
+
+	// Write buffer to the file
+	void GameLog::Flush(bool wait) {
+		std::unique_lock<std::mutex> lock(mutex_);
+		if (wait) {
+			// Write the rest here (file_mutex_ waits for writing of the background thread)
+			WriteBuffer(lock);
+			std::lock_guard<std::mutex> file_lock(file_mutex_);
+			ofs_.flush();
+		}
+		else {
+			flush_requested_ = true;
+			cv_.notify_all();
+		}
+		binary_.Flush();
+		json_.Flush();
+	}
+
+	// Set maximum size of buffer and what to do when it is full
+	void GameLog::SetBuffer(size_t max_buffer_size, Backpressure backpressure) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		max_buffer_size_ = (max_buffer_size > 0) ? max_buffer_size : kMaxBufferSize;
+		backpressure_ = backpressure;
+	}
+
+	// Output binary log or not
+	void GameLog::SetBinary(bool output_binary) {
+		output_binary_ = output_binary;
+		if (output_binary_ && !binary_.IsOpen() && player1_ != nullptr && player2_ != nullptr) {
+			binary_.Open(PathWithExtension(".dcb"), MakeHeader());
+		}
+		if (!output_binary_) {
+			binary_.Close();
+		}
+	}
+
+	// Output JSON log or not
+	void GameLog::SetJson(bool output_json) {
+		output_json_ = output_json;
+		if (output_json_ && !json_.IsOpen() && player1_ != nullptr && player2_ != nullptr) {
+			json_.Open(PathWithExtension(".jsonl"), MakeHeader());
+		}
+		if (!output_json_) {
+			json_.Close();
+		}
+	}
+
+	// Write record to binary log and JSON log
+	void GameLog::WriteRecord(const BinaryLogRecord &record) {
+		binary_.Append(record);
+		json_.Append(record);
+	}
+
+	// Header of binary log and JSON log for the current file
+	BinaryLogHeader GameLog::MakeHeader() const {
+		BinaryLogHeader header;
+		const Player *players[2] = { player1_, player2_ };
+		for (int p = 0; p < 2; p++) {
+			strncpy(header.name[p], players[p]->name_.c_str(), sizeof(header.name[p]) - 1);
+			header.time_limit[p] = players[p]->time_limit_;
+			header.nplayers[p] = players[p]->pinfo_.nplayers;
+			for (int i = 0; i < 4; i++) {
+				header.params[p][i][0] = players[p]->pinfo_.params[i].random_1;
+				header.params[p][i][1] = players[p]->pinfo_.params[i].random_2;
+				header.params[p][i][2] = players[p]->pinfo_.params[i].shot_max;
+			}
+		}
+
+		return header;
+	}
+
+	// Path of the current file with another extension (e.g. 'Log\A_B(20180131_123456).dcb')
+	std::string GameLog::PathWithExtension(const char *extension) const {
+		return file_path_.substr(0, file_path_.size() - 4) + extension;
+	}
+
+	// Loop of background thread
+	void GameLog::FlushLoop() {
+		std::unique_lock<std::mutex> lock(mutex_);
+		while (!stop_) {
+			cv_.wait_for(lock, std::chrono::milliseconds(kFlushInterval), [this] { return flush_requested_ || stop_; });
+			flush_requested_ = false;
+			WriteBuffer(lock);
+		}
+	}
+
+	// Write buffer to the file
+	void GameLog::WriteBuffer(std::unique_lock<std::mutex> &lock) {
+		if (buffer_.empty()) {
 			return;
 		}
 
-		ofs << message << endl;
+		// Take the buffer and the file, then write without holding mutex_
+		std::string data;
+		data.swap(buffer_);
+		std::unique_lock<std::mutex> file_lock(file_mutex_);
+		lock.unlock();
+		cv_.notify_all();  // buffer_ has space
+
+		if (ofs_.is_open()) {
+			ofs_.write(data.data(), data.size());
+			ofs_.flush();
+		}
+
+		file_lock.unlock();
+		lock.lock();
+	}
+
+	// Flush and close the current file
+	void GameLog::Close() {
+		Flush(true);
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		std::lock_guard<std::mutex> file_lock(file_mutex_);
+		if (ofs_.is_open()) {
+			ofs_.close();
+		}
+		binary_.Close();
+		json_.Close();
 	}
-}
\ No newline at end of file
+}
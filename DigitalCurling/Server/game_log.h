@@ -1,23 +1,88 @@
 #pragma once
 
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "game_log_binary.h"
+#include "game_log_json.h"
 #include "game_player.h"
 
 namespace digital_curling {
 
 	// GameLog
-	// TODO: try not to use WritePrivateProffile()
+	// Messages are appended to a buffer in memory and written to the file by a background thread
+	// Records of binary log (.dcb) and JSON log (.jsonl) are written to the files of the same name if they are enabled
 	class GameLog {
 	public:
+		// What Write() does when the buffer is full
+		enum Backpressure {
+			BLOCK,         // wait for the background thread to write the buffer
+			WRITE_THROUGH  // write the buffer to the file on the caller's thread
+		};
+
+		static const size_t kFlushSize = 16 * 1024;         // size of buffer to start writing [byte]
+		static const size_t kMaxBufferSize = 1024 * 1024;  // default size of buffer [byte]
+		static const int kFlushInterval = 1000;             // interval of writing in background [msec]
+
 		GameLog(const Player* const p1, const Player* const p2);
 		~GameLog();
 
-		// Create new file
+		// Create new file (the current file is flushed and closed)
 		bool Create(const Player* const p1, const Player* const p2);
 
 		// Write to logfile
 		void Write(std::string message);
 
+		// Write buffer to the file (wait: wait until it is written)
+		void Flush(bool wait);
+
+		// Set maximum size of buffer and what to do when it is full
+		void SetBuffer(size_t max_buffer_size, Backpressure backpressure);
+
+		// Output binary log or not (binary log of the current game is created if enabled)
+		void SetBinary(bool output_binary);
+
+		// Output JSON log or not (JSON log of the current game is created if enabled)
+		void SetJson(bool output_json);
+
+		// Write record to binary log and JSON log (only from the game's thread)
+		void WriteRecord(const BinaryLogRecord &record);
+
 	private:
+		// Loop of background thread
+		void FlushLoop();
+		// Write buffer to the file, lock of mutex_ is released during writing
+		void WriteBuffer(std::unique_lock<std::mutex> &lock);
+		// Flush and close the current file
+		void Close();
+		// Header of binary log and JSON log for the current file
+		BinaryLogHeader MakeHeader() const;
+		// Path of the current file with another extension
+		std::string PathWithExtension(const char *extension) const;
+
+		const Player *player1_;         // first player of the current file
+		const Player *player2_;         // second player of the current file
+
 		std::string file_path_;
+		std::ofstream ofs_;             // file being written (guarded by file_mutex_)
+
+		bool output_binary_;            // output binary log or not
+		BinaryLogWriter binary_;        // binary log of the current file
+		bool output_json_;              // output JSON log or not
+		JsonLogWriter json_;            // JSON log of the current file
+
+		std::string buffer_;            // messages not written yet
+		size_t max_buffer_size_;        // maximum size of buffer_
+		Backpressure backpressure_;     // what to do when buffer_ is full
+		bool flush_requested_;          // background thread should write buffer_ now
+		bool stop_;                     // background thread should exit
+
+		std::mutex mutex_;              // for members above except ofs_
+		std::mutex file_mutex_;         // for ofs_ (locked after mutex_)
+		std::condition_variable cv_;    // notified when buffer_ is taken for writing or flush is requested
+		std::thread flusher_;           // background thread
 	};
-}
\ No newline at end of file
+}
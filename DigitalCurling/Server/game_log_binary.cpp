@@ -0,0 +1,453 @@
+#define _CRT_SECURE_NO_WARNINGS 1
+
+#include "game_log_binary.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using std::cerr;
+using std::endl;
+
+namespace digital_curling {
+
+	static_assert(sizeof(BinaryLogHeader) == 192, "BinaryLogHeader must be packed");
+	static_assert(sizeof(BinaryLogRecord) == 332, "BinaryLogRecord must be packed");
+
+	BinaryLogHeader::BinaryLogHeader() {
+		memset(this, 0, sizeof(BinaryLogHeader));
+		memcpy(magic, kBinaryLogMagic, sizeof(magic));
+		version = kBinaryLogVersion;
+		header_size = sizeof(BinaryLogHeader);
+		record_size = sizeof(BinaryLogRecord);
+	}
+
+	BinaryLogRecord::BinaryLogRecord() {
+		memset(this, 0, sizeof(BinaryLogRecord));
+	}
+
+	BinaryLogRecord::BinaryLogRecord(uint32_t record_type) {
+		memset(this, 0, sizeof(BinaryLogRecord));
+		type = record_type;
+	}
+
+	BinaryLogWriter::BinaryLogWriter() {}
+
+	BinaryLogWriter::~BinaryLogWriter() {
+		Close();
+	}
+
+	// Create file and write header
+	bool BinaryLogWriter::Open(const std::string &file_path, const BinaryLogHeader &header) {
+		Close();
+		ofs_.open(file_path, std::ios::binary);
+		if (!ofs_.is_open()) {
+			return false;
+		}
+		ofs_.write(reinterpret_cast<const char*>(&header), sizeof(BinaryLogHeader));
+		return true;
+	}
+
+	// Append a record
+	void BinaryLogWriter::Append(const BinaryLogRecord &record) {
+		if (ofs_.is_open()) {
+			ofs_.write(reinterpret_cast<const char*>(&record), sizeof(BinaryLogRecord));
+		}
+	}
+
+	// Write buffered records to the file
+	void BinaryLogWriter::Flush() {
+		if (ofs_.is_open()) {
+			ofs_.flush();
+		}
+	}
+
+	// Close file
+	void BinaryLogWriter::Close() {
+		if (ofs_.is_open()) {
+			ofs_.close();
+		}
+	}
+
+	bool BinaryLogWriter::IsOpen() const {
+		return ofs_.is_open();
+	}
+
+	// Read binary log
+	bool ReadBinaryLog(const std::string &file_path, BinaryLogHeader &header, std::vector<BinaryLogRecord> &records) {
+		std::ifstream ifs(file_path, std::ios::binary);
+		if (!ifs.is_open()) {
+			cerr << "failed to open " << file_path << endl;
+			return false;
+		}
+
+		// Read and check header
+		if (!ifs.read(reinterpret_cast<char*>(&header), sizeof(BinaryLogHeader)) ||
+			memcmp(header.magic, kBinaryLogMagic, sizeof(header.magic)) != 0 ||
+			header.version != kBinaryLogVersion ||
+			header.header_size < sizeof(BinaryLogHeader) ||
+			header.record_size < kBinaryLogRecordSizeMin) {
+			cerr << file_path << " is not a binary log (version " << kBinaryLogVersion << ")" << endl;
+			return false;
+		}
+		ifs.seekg(header.header_size, std::ios::beg);
+
+		// Read records (incomplete record at the end is ignored)
+		// Fields which older record has not are 0
+		records.clear();
+		std::vector<char> buffer(header.record_size);
+		size_t copy_size = (header.record_size < sizeof(BinaryLogRecord)) ? header.record_size : sizeof(BinaryLogRecord);
+		while (ifs.read(buffer.data(), header.record_size)) {
+			BinaryLogRecord record;
+			memcpy(&record, buffer.data(), copy_size);
+			records.push_back(record);
+		}
+
+		return true;
+	}
+
+	// Read numbers following the first token of a message e.g. 'POSITION x0 y0 x1 y1 ...'
+	static void ParseFloats(const std::string &message, float *values, size_t num) {
+		std::istringstream sstream(message);
+		std::string token;
+		sstream >> token;
+		for (size_t i = 0; i < num; i++) {
+			if (!(sstream >> token)) {
+				break;
+			}
+			values[i] = (float)atof(token.c_str());
+		}
+	}
+
+	// Read log (.dcl) as records of binary log
+	bool ReadDclLog(const std::string &dcl_path, BinaryLogHeader &header, std::vector<BinaryLogRecord> &records) {
+		std::ifstream ifs(dcl_path);
+		if (!ifs.is_open()) {
+			cerr << "failed to open " << dcl_path << endl;
+			return false;
+		}
+
+		header = BinaryLogHeader();
+		records.clear();
+		BinaryLogRecord *section = nullptr;  // record of current '[EESS]' section
+		bool has_bestshot = false;
+		bool has_param = false;
+		int32_t end_state = 0;       // 'ENDSTATE' of [GameOverInfo]
+		uint32_t white_to_move = 0;  // player to move of the last section (who conceded or timed out)
+
+		// Decide type of a section by its statements
+		auto close_section = [&]() {
+			if (section != nullptr && section->type != BinaryLogRecord::SCORE && section->type != BinaryLogRecord::CONCEDE) {
+				if (has_bestshot) {
+					section->type = has_param ? BinaryLogRecord::SHOT : BinaryLogRecord::PLACED;
+				}
+				else {
+					section->type = BinaryLogRecord::TIMEOUT;
+				}
+			}
+			section = nullptr;
+		};
+
+		std::string line;
+		while (std::getline(ifs, line)) {
+			if (!line.empty() && line.back() == '\r') {
+				line.pop_back();
+			}
+			if (line.empty()) {
+				continue;
+			}
+
+			if (line[0] == '[') {
+				close_section();
+				if (line.size() >= 6 && isdigit((unsigned char)line[1])) {
+					// '[EESS]'
+					records.push_back(BinaryLogRecord(BinaryLogRecord::SHOT));
+					section = &records.back();
+					section->cur_end = (uint32_t)atoi(line.substr(1, 2).c_str());
+					section->shot_num = (uint32_t)atoi(line.substr(3, 2).c_str());
+					has_bestshot = has_param = false;
+				}
+				continue;
+			}
+
+			size_t pos = line.find('=');
+			if (pos == std::string::npos) {
+				continue;
+			}
+			std::string key = line.substr(0, pos);
+			std::string message = line.substr(pos + 1);
+
+			// [GameInfo]
+			if (key == "First" || key == "Second") {
+				int p = (key == "First") ? 0 : 1;
+				strncpy(header.name[p], message.c_str(), sizeof(header.name[p]) - 1);
+			}
+			else if (key == "FirstRemTime" || key == "SecondRemTime") {
+				header.time_limit[key == "FirstRemTime" ? 0 : 1] = atoi(message.c_str());
+			}
+			else if (key == "FirstRandom_1" || key == "SecondRandom_1") {
+				int p = (key == "FirstRandom_1") ? 0 : 1;
+				header.nplayers[p] = 1;
+				header.params[p][0][0] = (float)atof(message.c_str());
+			}
+			else if (key == "FirstRandom_2" || key == "SecondRandom_2") {
+				header.params[key == "FirstRandom_2" ? 0 : 1][0][1] = (float)atof(message.c_str());
+			}
+			else if (key == "GAMEINFO") {
+				close_section();
+				BinaryLogRecord record(BinaryLogRecord::GAMEINFO);
+				float values[2] = { 0.0f, 0.0f };
+				ParseFloats(message, values, 2);
+				record.value[0] = (int32_t)values[0];
+				record.value[1] = (int32_t)values[1];
+				records.push_back(record);
+			}
+			// [EESS]
+			else if (section != nullptr && key == "POSITION") {
+				ParseFloats(message, &section->before[0][0], 32);
+			}
+			else if (section != nullptr && key == "SETSTATE") {
+				float values[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+				ParseFloats(message, values, 4);
+				section->shot_num = (uint32_t)values[0];
+				section->cur_end = (uint32_t)values[1];
+				section->last_end = (uint32_t)values[2];
+				section->white_to_move = (uint32_t)values[3];
+				white_to_move = section->white_to_move;
+			}
+			else if (section != nullptr && key == "BESTSHOT") {
+				if (message == "CONCEDE") {
+					section->type = BinaryLogRecord::CONCEDE;
+				}
+				else {
+					// old server wrote no space after 'BESTSHOT'
+					if (message.compare(0, 8, "BESTSHOT") == 0 && message.size() > 8 && message[8] != ' ') {
+						message.insert(8, " ");
+					}
+					ParseFloats(message, section->best_shot, 3);
+					has_bestshot = true;
+				}
+			}
+			else if (section != nullptr && key == "PARAM") {
+				ParseFloats(message, section->param, 3);
+				has_param = true;
+			}
+			else if (section != nullptr && key == "RUNSHOT") {
+				ParseFloats(message, section->run_shot, 3);
+			}
+			else if (section != nullptr && key == "SCORE") {
+				float value = 0.0f;
+				ParseFloats(message, &value, 1);
+				section->type = BinaryLogRecord::SCORE;
+				section->value[0] = (int32_t)value;
+			}
+			// [GameOverInfo]
+			else if (key == "ENDSTATE") {
+				if (message == "CONCEDE") {
+					end_state = BinaryLogRecord::CONCEDE;
+				}
+				else if (message == "TIMEOUT") {
+					end_state = BinaryLogRecord::TIMEOUT;
+				}
+			}
+			else if (key == "TOTALSCORE") {
+				BinaryLogRecord record(BinaryLogRecord::GAMEOVER);
+				float values[2] = { 0.0f, 0.0f };
+				ParseFloats(message, values, 2);
+				record.value[0] = (int32_t)values[0];
+				record.value[1] = (int32_t)values[1];
+				record.value[2] = end_state;
+				record.white_to_move = white_to_move;
+				records.push_back(record);
+			}
+		}
+		close_section();
+
+		// Position after a shot is position of the next section
+		for (size_t i = 0; i < records.size(); i++) {
+			if (records[i].type != BinaryLogRecord::SHOT && records[i].type != BinaryLogRecord::PLACED) {
+				continue;
+			}
+			for (size_t j = i + 1; j < records.size(); j++) {
+				if (records[j].type != BinaryLogRecord::GAMEINFO && records[j].type != BinaryLogRecord::GAMEOVER) {
+					memcpy(records[i].after, records[j].before, sizeof(records[i].after));
+					break;
+				}
+			}
+		}
+		// SCORE section has no 'SETSTATE' statement
+		for (size_t i = 1; i < records.size(); i++) {
+			if (records[i].type == BinaryLogRecord::SCORE) {
+				records[i].last_end = records[i - 1].last_end;
+				records[i].white_to_move = records[i - 1].white_to_move;
+			}
+		}
+
+		return true;
+	}
+
+	// Extension of log
+	std::string LogExtension(const std::string &path) {
+		std::string extension = (path.size() > 4) ? path.substr(path.size() - 4) : "";
+		return (extension == ".dcl" || extension == ".dcb") ? extension : "";
+	}
+
+	// Read log of either format
+	bool ReadLog(const std::string &path, BinaryLogHeader &header, std::vector<BinaryLogRecord> &records) {
+		return (LogExtension(path) == ".dcb") ? ReadBinaryLog(path, header, records) : ReadDclLog(path, header, records);
+	}
+
+	// List logs of paths
+	std::vector<std::string> ListLogs(const std::vector<std::string> &paths) {
+		std::vector<std::string> logs;
+		for (const std::string &path : paths) {
+			std::error_code ec;
+			if (std::filesystem::is_directory(path, ec)) {
+				std::vector<std::string> files;
+				for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(path, ec)) {
+					std::string file = entry.path().string();
+					if (entry.is_regular_file(ec) && !LogExtension(file).empty()) {
+						files.push_back(file);
+					}
+				}
+				std::sort(files.begin(), files.end());
+				logs.insert(logs.end(), files.begin(), files.end());
+			}
+			else {
+				logs.push_back(path);
+			}
+		}
+		return logs;
+	}
+
+	// Convert log (.dcl) to binary log (.dcb)
+	bool ConvertDclToBinary(const std::string &dcl_path, const std::string &binary_path) {
+		BinaryLogHeader header;
+		std::vector<BinaryLogRecord> records;
+		if (!ReadDclLog(dcl_path, header, records)) {
+			return false;
+		}
+
+		// Write binary log
+		BinaryLogWriter writer;
+		if (!writer.Open(binary_path, header)) {
+			cerr << "failed to create " << binary_path << endl;
+			return false;
+		}
+		for (size_t i = 0; i < records.size(); i++) {
+			writer.Append(records[i]);
+		}
+		writer.Close();
+
+		return true;
+	}
+
+	// Write '[EESS]', 'POSITION' and 'SETSTATE' statements
+	static void WriteSection(std::ostream &os, const BinaryLogRecord &record, bool setstate) {
+		os << "[" <<
+			std::setfill('0') << std::setw(2) << record.cur_end <<
+			std::setfill('0') << std::setw(2) << record.shot_num << "]" << endl;
+		os << std::setfill(' ');
+		os << "POSITION=POSITION";
+		for (int i = 0; i < 16; i++) {
+			os << " " << record.before[i][0] << " " << record.before[i][1];
+		}
+		os << endl;
+		if (setstate) {
+			os << "SETSTATE=SETSTATE " << record.shot_num << " " << record.cur_end << " " << record.last_end << " " << record.white_to_move << endl;
+		}
+	}
+
+	// Convert binary log (.dcb) to log (.dcl)
+	bool ConvertBinaryToDcl(const std::string &binary_path, const std::string &dcl_path) {
+		BinaryLogHeader header;
+		std::vector<BinaryLogRecord> records;
+		if (!ReadBinaryLog(binary_path, header, records)) {
+			return false;
+		}
+
+		std::ofstream ofs(dcl_path);
+		if (!ofs.is_open()) {
+			cerr << "failed to create " << dcl_path << endl;
+			return false;
+		}
+
+		// Names are not '\0' terminated if they are too long
+		std::string name[2];
+		for (int p = 0; p < 2; p++) {
+			name[p] = std::string(header.name[p], strnlen(header.name[p], sizeof(header.name[p])));
+		}
+
+		// Write 'GameInfo' statement
+		ofs << "[GameInfo]" << endl;
+		ofs << "First=" << name[0] << endl;
+		ofs << "FirstRemTime=" << header.time_limit[0] << endl;
+		ofs << "FirstRandom_1=" << header.params[0][0][0] << endl;
+		ofs << "FirstRandom_2=" << header.params[0][0][1] << endl;
+		ofs << "Second=" << name[1] << endl;
+		ofs << "SecondRemTime=" << header.time_limit[1] << endl;
+		ofs << "SecondRandom_1=" << header.params[1][0][0] << endl;
+		ofs << "SecondRandom_2=" << header.params[1][0][1] << endl;
+
+		for (size_t i = 0; i < records.size(); i++) {
+			const BinaryLogRecord &r = records[i];
+			switch (r.type) {
+			case BinaryLogRecord::GAMEINFO:
+				ofs << "GAMEINFO=GAMEINFO " << r.value[0] << " " << r.value[1] << endl;
+				break;
+			case BinaryLogRecord::SHOT:
+				WriteSection(ofs, r, true);
+				ofs << "BESTSHOT=BESTSHOT " << r.best_shot[0] << ' ' << r.best_shot[1] << ' ' << (int)r.best_shot[2] << endl;
+				ofs << "PARAM=PARAM " << r.param[0] << ' ' << r.param[1] << ' ' << r.param[2] << endl;
+				ofs << "RUNSHOT=RUNSHOT " << r.run_shot[0] << ' ' << r.run_shot[1] << ' ' << (int)r.run_shot[2] << endl;
+				break;
+			case BinaryLogRecord::PLACED:
+				WriteSection(ofs, r, true);
+				ofs << "BESTSHOT=BESTSHOT 0 0 0" << endl;
+				ofs << "RUNSHOT=RUNSHOT 0 0 0" << endl;
+				break;
+			case BinaryLogRecord::CONCEDE:
+				WriteSection(ofs, r, true);
+				ofs << "BESTSHOT=CONCEDE" << endl;
+				break;
+			case BinaryLogRecord::TIMEOUT:
+				WriteSection(ofs, r, true);
+				break;
+			case BinaryLogRecord::SCORE:
+				WriteSection(ofs, r, false);
+				ofs << "SCORE=SCORE " << r.value[0] << endl;
+				break;
+			case BinaryLogRecord::GAMEOVER:
+				ofs << "[GameOverInfo]" << endl;
+				if (r.value[2] == BinaryLogRecord::CONCEDE || r.value[2] == BinaryLogRecord::TIMEOUT) {
+					// Player to move conceded or timed out
+					ofs << "ENDSTATE=" << ((r.value[2] == BinaryLogRecord::CONCEDE) ? "CONCEDE" : "TIMEOUT") << endl;
+					ofs << "WIN=" << name[(r.white_to_move) ? 0 : 1] << endl;
+					ofs << "LOSE=" << name[(r.white_to_move) ? 1 : 0] << endl;
+				}
+				else if (r.value[0] != r.value[1]) {
+					ofs << "ENDSTATE=" << "NORMAL" << endl;
+					ofs << "WIN=" << name[(r.value[0] > r.value[1]) ? 0 : 1] << endl;
+					ofs << "LOSE=" << name[(r.value[0] > r.value[1]) ? 1 : 0] << endl;
+				}
+				else {
+					ofs << "ENDSTATE=" << "NORMAL" << endl;
+					ofs << "WIN=" << endl;
+					ofs << "LOSE=" << endl;
+				}
+				ofs << "TOTALSCORE=TOTALSCORE " << r.value[0] << " " << r.value[1] << endl;
+				ofs << endl;
+				break;
+			default:
+				break;
+			}
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace digital_curling {
+
+	// Binary log (.dcb)
+	// A file is a BinaryLogHeader and BinaryLogRecords following it
+	// All fields are 4 bytes (little-endian, no padding), so records can be appended while the game runs
+	// and the file can be memory-mapped as the header and an array of records
+	// Number of records = (file size - header_size) / record_size
+
+	const char     kBinaryLogMagic[4] = { 'D', 'C', 'B', '1' };
+	const uint32_t kBinaryLogVersion = 1;
+	const uint32_t kBinaryLogRecordSizeMin = 328;  // record_size of old servers (value[2] is read as 0)
+
+	// Header of binary log
+	struct BinaryLogHeader {
+		char     magic[4];          // kBinaryLogMagic
+		uint32_t version;           // kBinaryLogVersion
+		uint32_t header_size;       // sizeof(BinaryLogHeader)
+		uint32_t record_size;       // sizeof(BinaryLogRecord)
+		char     name[2][32];       // name of first and second player ('\0' terminated)
+		int32_t  time_limit[2];     // time limit of each player [msec]
+		uint32_t nplayers[2];       // number of players in each team
+		float    params[2][4][3];   // random_1, random_2 and shot_max of each player in each team
+
+		BinaryLogHeader();
+	};
+
+	// Record of binary log
+	struct BinaryLogRecord {
+		enum {
+			GAMEINFO = 0,  // start of game (value: rule_type, random_type)
+			SHOT     = 1,  // a shot (all fields)
+			PLACED   = 2,  // stones placed by rule of mix doubles (before, after and state)
+			CONCEDE  = 3,  // player to move conceded (before and state)
+			TIMEOUT  = 4,  // player to move timed out (before and state)
+			SCORE    = 5,  // end of End (before: final position, value[0]: score of the End)
+			GAMEOVER = 6   // end of game (value: total score of first and second player, and end state: 0, CONCEDE or TIMEOUT)
+		};
+
+		uint32_t type;              // type of record
+		uint32_t cur_end;           // CurEnd
+		uint32_t last_end;          // LastEnd
+		uint32_t shot_num;          // ShotNum
+		uint32_t white_to_move;     // WhiteToMove
+		float    before[16][2];     // position of stones before the shot
+		float    best_shot[3];      // shot from player (x, y, angle)
+		float    param[3];          // random_1, random_2 and shot_max of the shooter
+		float    run_shot[3];       // shot with random number (x, y, angle)
+		float    after[16][2];      // position of stones after the shot
+		int32_t  time_remain[2];    // time remaining of each player [msec]
+		int32_t  value[3];          // value for the type
+
+		BinaryLogRecord();
+		BinaryLogRecord(uint32_t record_type);
+	};
+
+	// Writer of binary log
+	class BinaryLogWriter {
+	public:
+		BinaryLogWriter();
+		~BinaryLogWriter();
+
+		// Create file and write header
+		bool Open(const std::string &file_path, const BinaryLogHeader &header);
+		// Append a record
+		void Append(const BinaryLogRecord &record);
+		// Write buffered records to the file
+		void Flush();
+		// Close file
+		void Close();
+
+		bool IsOpen() const;
+
+	private:
+		std::ofstream ofs_;
+	};
+
+	// Read binary log
+	// This function returns false if the file is not a binary log
+	bool ReadBinaryLog(const std::string &file_path, BinaryLogHeader &header, std::vector<BinaryLogRecord> &records);
+
+	// Read log (.dcl) as records of binary log
+	// This function returns false if the file cannot be opened
+	bool ReadDclLog(const std::string &dcl_path, BinaryLogHeader &header, std::vector<BinaryLogRecord> &records);
+
+	// Extension of log ('.dcl' or '.dcb', empty if path is not a log)
+	std::string LogExtension(const std::string &path);
+
+	// Read log of either format (.dcb is read as binary log, others as .dcl)
+	bool ReadLog(const std::string &path, BinaryLogHeader &header, std::vector<BinaryLogRecord> &records);
+
+	// List logs of paths (a directory is replaced with logs in it sorted by name)
+	std::vector<std::string> ListLogs(const std::vector<std::string> &paths);
+
+	// Convert log (.dcl) to binary log (.dcb)
+	bool ConvertDclToBinary(const std::string &dcl_path, const std::string &binary_path);
+
+	// Convert binary log (.dcb) to log (.dcl)
+	bool ConvertBinaryToDcl(const std::string &binary_path, const std::string &dcl_path);
+}
@@ -0,0 +1,240 @@
+#define _CRT_SECURE_NO_WARNINGS 1
+
+#include "game_log_json.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+using std::cerr;
+using std::endl;
+
+namespace digital_curling {
+
+	// Appends formatted values to a buffer (line is invalid if it overflows the buffer)
+	class JsonLine {
+	public:
+		JsonLine(char *buffer, size_t size) : begin_(buffer), p_(buffer), end_(buffer + size - 1), overflow_(false) {}
+
+		// Append raw text
+		void Raw(const char *text) {
+			while (*text != '\0' && p_ < end_) {
+				*p_++ = *text++;
+			}
+			if (*text != '\0') {
+				overflow_ = true;
+			}
+		}
+
+		// Append '"key":' (nothing for element of array)
+		void Key(const char *key) {
+			if (key == nullptr) {
+				return;
+			}
+			if (p_ > begin_ && p_[-1] != '{' && p_[-1] != '[') {
+				Raw(",");
+			}
+			Raw("\"");
+			Raw(key);
+			Raw("\":");
+		}
+
+		// Append '"key":value'
+		void Int(const char *key, long long value) {
+			Key(key);
+			Print("%lld", value);
+		}
+
+		// Append '"key":[v0,v1,...]' ('[v0,v1,...]' if key is nullptr)
+		void Floats(const char *key, const float *values, size_t num) {
+			Key(key);
+			Raw("[");
+			for (size_t i = 0; i < num; i++) {
+				if (!std::isfinite(values[i])) {
+					// JSON has no nan and inf
+					Raw((i == 0) ? "null" : ",null");
+					continue;
+				}
+				// 9 digits to restore the same float
+				Print((i == 0) ? "%.9g" : ",%.9g", (double)values[i]);
+			}
+			Raw("]");
+		}
+
+		void Ints(const char *key, const int32_t *values, size_t num) {
+			Key(key);
+			Raw("[");
+			for (size_t i = 0; i < num; i++) {
+				Print((i == 0) ? "%d" : ",%d", (int)values[i]);
+			}
+			Raw("]");
+		}
+
+		// Append '"key":"text"' (with escape)
+		void String(const char *key, const char *text, size_t max_length) {
+			Key(key);
+			Raw("\"");
+			for (size_t i = 0; i < max_length && text[i] != '\0'; i++) {
+				unsigned char c = (unsigned char)text[i];
+				if (c == '"' || c == '\\') {
+					char escaped[3] = { '\\', (char)c, '\0' };
+					Raw(escaped);
+				}
+				else if (c < 0x20) {
+					Print("\\u%04x", (unsigned int)c);
+				}
+				else {
+					char ch[2] = { (char)c, '\0' };
+					Raw(ch);
+				}
+			}
+			Raw("\"");
+		}
+
+		// Finish line with '\n' and return its size (0 if the line overflowed)
+		size_t End() {
+			if (overflow_) {
+				return 0;
+			}
+			*p_++ = '\n';
+			return p_ - begin_;
+		}
+
+	private:
+		template<typename T>
+		void Print(const char *format, T value) {
+			int n = snprintf(p_, end_ - p_, format, value);
+			if (n < 0 || (size_t)n >= (size_t)(end_ - p_)) {
+				// Output is cut by '\0'
+				overflow_ = true;
+				p_ = end_;
+				return;
+			}
+			p_ += n;
+		}
+
+		char *begin_;
+		char *p_;
+		char *end_;       // last byte is reserved for '\n'
+		bool overflow_;   // text was cut at the end of the buffer
+	};
+
+	// Name of record types in JSON
+	static const char* const kRecordTypeName[] = { "gameinfo", "shot", "placed", "concede", "timeout", "score", "gameover" };
+
+	JsonLogWriter::JsonLogWriter() {}
+
+	JsonLogWriter::~JsonLogWriter() {
+		Close();
+	}
+
+	// Create file and write header
+	bool JsonLogWriter::Open(const std::string &file_path, const BinaryLogHeader &header) {
+		Close();
+		ofs_.open(file_path, std::ios::binary);
+		if (!ofs_.is_open()) {
+			return false;
+		}
+
+		// {"type":"header","players":[{"name":"AI1","time_limit":219000,"params":[[0.0725,0.29,50]]},{...}]}
+		JsonLine line(line_, kLineSize);
+		line.Raw("{\"type\":\"header\",\"players\":[");
+		for (int p = 0; p < 2; p++) {
+			line.Raw((p == 0) ? "{" : ",{");
+			line.String("name", header.name[p], sizeof(header.name[p]));
+			line.Int("time_limit", header.time_limit[p]);
+			line.Key("params");
+			line.Raw("[");
+			unsigned int nplayers = (header.nplayers[p] > 0 && header.nplayers[p] <= 4) ? header.nplayers[p] : 1;
+			for (unsigned int i = 0; i < nplayers; i++) {
+				line.Raw((i == 0) ? "" : ",");
+				line.Floats(nullptr, header.params[p][i], 3);
+			}
+			line.Raw("]}");
+		}
+		line.Raw("]}");
+		WriteLine(line.End());
+
+		return true;
+	}
+
+	// Append a record
+	void JsonLogWriter::Append(const BinaryLogRecord &record) {
+		if (!ofs_.is_open() || record.type > BinaryLogRecord::GAMEOVER) {
+			return;
+		}
+
+		JsonLine line(line_, kLineSize);
+		line.Raw("{\"type\":\"");
+		line.Raw(kRecordTypeName[record.type]);
+		line.Raw("\"");
+
+		switch (record.type) {
+		case BinaryLogRecord::GAMEINFO:
+			line.Int("last_end", record.last_end);
+			line.Int("rule_type", record.value[0]);
+			line.Int("random_type", record.value[1]);
+			break;
+		case BinaryLogRecord::SCORE:
+			line.Int("end", record.cur_end);
+			line.Int("score", record.value[0]);
+			line.Floats("position", &record.before[0][0], 32);
+			break;
+		case BinaryLogRecord::GAMEOVER:
+			line.Ints("score", record.value, 2);
+			line.Raw(",\"end_state\":\"");
+			line.Raw((record.value[2] == BinaryLogRecord::CONCEDE || record.value[2] == BinaryLogRecord::TIMEOUT) ?
+				kRecordTypeName[record.value[2]] : "normal");
+			line.Raw("\"");
+			break;
+		default:
+			// Shot and events of a shot
+			line.Int("end", record.cur_end);
+			line.Int("shot", record.shot_num);
+			line.Int("last_end", record.last_end);
+			line.Int("white_to_move", record.white_to_move);
+			line.Ints("time_remain", record.time_remain, 2);
+			line.Floats("before", &record.before[0][0], 32);
+			if (record.type == BinaryLogRecord::SHOT) {
+				line.Floats("best_shot", record.best_shot, 3);
+				line.Floats("param", record.param, 3);
+				line.Floats("run_shot", record.run_shot, 3);
+			}
+			if (record.type == BinaryLogRecord::SHOT || record.type == BinaryLogRecord::PLACED) {
+				line.Floats("after", &record.after[0][0], 32);
+			}
+			break;
+		}
+		line.Raw("}");
+		WriteLine(line.End());
+	}
+
+	// Write buffered lines to the file
+	void JsonLogWriter::Flush() {
+		if (ofs_.is_open()) {
+			ofs_.flush();
+		}
+	}
+
+	// Close file
+	void JsonLogWriter::Close() {
+		if (ofs_.is_open()) {
+			ofs_.close();
+		}
+	}
+
+	bool JsonLogWriter::IsOpen() const {
+		return ofs_.is_open();
+	}
+
+	// Write a line in line_
+	void JsonLogWriter::WriteLine(size_t size) {
+		if (size == 0) {
+			// Record is dropped rather than written as broken JSON
+			cerr << "json log: line longer than " << kLineSize << " bytes is dropped" << endl;
+			return;
+		}
+		ofs_.write(line_, size);
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+
+#include "game_log_binary.h"
+
+namespace digital_curling {
+
+	// Streaming JSON log (.jsonl)
+	// One JSON object per line: a header, then a record for each event of the game as it happens
+	// e.g. {"type":"shot","end":0,"shot":3,...,"best_shot":[2.3,31.7,0],...}
+	// Lines are formatted into a fixed buffer without building DOM or streams
+	class JsonLogWriter {
+	public:
+		static const size_t kLineSize = 4096;  // maximum size of a line
+
+		JsonLogWriter();
+		~JsonLogWriter();
+
+		// Create file and write header
+		bool Open(const std::string &file_path, const BinaryLogHeader &header);
+		// Append a record
+		void Append(const BinaryLogRecord &record);
+		// Write buffered lines to the file
+		void Flush();
+		// Close file
+		void Close();
+
+		bool IsOpen() const;
+
+	private:
+		// Write a line in line_ (size 0: line overflowed and is dropped)
+		void WriteLine(size_t size);
+
+		std::ofstream ofs_;
+		char line_[kLineSize];
+	};
+}
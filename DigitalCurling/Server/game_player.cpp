@@ -1,9 +1,44 @@
 #pragma warning(disable:4996)  // disable error (string::copy)
 
+#ifdef _WIN32
+// winsock2.h must be included before Windows.h
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "ws2_32.lib")
+#endif
+#endif
+
 #include "game_player.h"
 
+#include "dcurling_dcp.h"
+
+#ifndef _WIN32
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+#include "event_loop.h"
+
+extern char **environ;
+#endif
+
+#include <chrono>
+#include <cstdio>
 #include <iostream>
+#include <mutex>
 #include <sstream>
+#include <vector>
 
 using std::cin;
 using std::cout;
@@ -31,16 +66,261 @@ namespace digital_curling
 		}
 	}
 
+	Player::Player() : binary_(false), framed_(false), text_tail_(false), binary_offered_(false), stop_reader_(false), pending_(false), has_shot_(false) {}
+
+	Player::~Player() {
+		// Recv() must be unblocked by derived class (e.g. ExitProcess()) before its members are destroyed
+		JoinReader();
+	}
+
+	// Recieve message from queue of reader thread
+	bool Player::RecvWait(char *message, unsigned int time_out) {
+		memset(message, 0, kBufferSize);
+		bool popped = queue_.WaitPop(message, std::chrono::steady_clock::now() + std::chrono::milliseconds(time_out));
+		// A slot is free now for messages which stayed in recv_buffer_
+		if (pending_) {
+			DeliverPending();
+		}
+		return popped;
+	}
+
+	// Server offers binary DCP
+	void Player::OfferBinary() {
+		binary_offered_ = true;
+	}
+
+	// Discard messages in queue
+	int Player::DiscardMessages() {
+		char message[kBufferSize];
+		int count = 0;
+		while (true) {
+			while (queue_.Pop(message)) {
+				count++;
+			}
+			if (!pending_) {
+				break;
+			}
+			DeliverPending();
+		}
+
+		std::lock_guard<std::mutex> lock(shot_mutex_);
+		has_shot_ = false;
+
+		return count;
+	}
+
+	// Take shot delivered as ShotVec
+	bool Player::TakeShot(ShotVec *vec) {
+		std::lock_guard<std::mutex> lock(shot_mutex_);
+		if (!has_shot_) {
+			return false;
+		}
+		*vec = shot_;
+		has_shot_ = false;
+		return true;
+	}
+
+	// Start reader thread
+	void Player::StartReader(bool framed) {
+		JoinReader();
+		OpenQueue(framed);
+		stop_reader_ = false;
+		reader_ = std::thread(&Player::ReadLoop, this);
+	}
+
+	// Wait for reader thread to exit
+	void Player::JoinReader() {
+		if (reader_.joinable()) {
+			stop_reader_ = true;
+			reader_.join();
+		}
+	}
+
+	// Loop of reader thread
+	void Player::ReadLoop() {
+		char message[kBufferSize];
+		while (Recv(message) > 0) {
+			// Wait for consumer while the queue is full
+			while (!queue_.Push(message)) {
+				if (stop_reader_) {
+					queue_.Close();
+					return;
+				}
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		}
+		queue_.Close();
+	}
+
+	// Clear queue and received bytes
+	void Player::OpenQueue(bool framed) {
+		queue_.Reset();
+		recv_buffer_.clear();
+		pending_ = false;
+		binary_ = false;
+		binary_offered_ = false;
+		framed_ = framed;
+		text_tail_ = false;
+	}
+
+	// Deliver received bytes to queue as messages
+	void Player::DeliverData(const char *data, size_t size) {
+		std::lock_guard<std::mutex> lock(deliver_mutex_);
+		PushData(data, size);
+		PushMessages();
+	}
+
+	// Deliver messages which stayed in recv_buffer_ while the queue was full
+	void Player::DeliverPending() {
+		std::lock_guard<std::mutex> lock(deliver_mutex_);
+		PushMessages();
+	}
+
+	// Push messages in recv_buffer_ to queue (deliver_mutex_ must be locked)
+	void Player::PushMessages() {
+		char message[kBufferSize];
+		while (true) {
+			if (!queue_.Full()) {
+				if (!PopMessage(message)) {
+					pending_ = false;  // no whole message is left
+					return;
+				}
+				queue_.Push(message);
+				continue;
+			}
+			// Messages stay in recv_buffer_ while the queue is full (delivered by consumer after it pops)
+			pending_ = true;
+			if (queue_.Full()) {
+				return;
+			}
+		}
+	}
+
+	// No more messages will be delivered
+	void Player::CloseQueue() {
+		queue_.Close();
+	}
+
+	// Deliver 'BESTSHOT' with shot as is
+	void Player::DeliverShot(const ShotVec &vec) {
+		KeepShot(vec);
+		DeliverData("BESTSHOT", sizeof("BESTSHOT"));
+	}
+
+	// Keep shot for TakeShot()
+	void Player::KeepShot(const ShotVec &vec) {
+		std::lock_guard<std::mutex> lock(shot_mutex_);
+		shot_ = vec;
+		has_shot_ = true;
+	}
+
+	// Append received bytes
+	void Player::PushData(const char *data, size_t size) {
+		// Tail of previous data which is not popped yet is terminated before next data
+		if (text_tail_ && !framed_) {
+			recv_buffer_.push_back('\0');
+		}
+		// A frame split by reads stays here until the whole frame arrives
+		recv_buffer_.append(data, size);
+
+		// Text without delimiter at the end of data is regarded as a whole message
+		//  (AIs may write a message without terminator)
+		text_tail_ = !framed_ && size > 0 && data[size - 1] != '\n' && data[size - 1] != '\0';
+	}
+
+	// Pop a message delimited by '\n' or '\0', or a message in frame
+	bool Player::PopMessage(char *message) {
+		while (framed_) {
+			dcp::Frame frame;
+			size_t size = dcp::ReadFrame(recv_buffer_.data(), recv_buffer_.size(), &frame);
+			if (size == 0) {
+				return false;
+			}
+
+			bool popped = false;
+			ShotVec vec;
+			switch (frame.type) {
+			case dcp::FRAME_MESSAGE:
+				// Message without '\0'
+				if (frame.size > 0) {
+					size_t len = (frame.size < kBufferSize - 1) ? frame.size : kBufferSize - 1;
+					memcpy(message, frame.data, len);
+					message[len] = '\0';
+					popped = true;
+				}
+				break;
+			case dcp::FRAME_BESTSHOT:
+				// Queue holds messages, shot is taken as is after 'BESTSHOT' without arguments
+				if (dcp::DecodeShot(frame.data, frame.size, &vec)) {
+					KeepShot(vec);
+					strcpy(message, "BESTSHOT");
+					popped = true;
+				}
+				break;
+			case dcp::FRAME_ACK:
+				OnAck(frame.seq);
+				break;
+			default:
+				break;  // unknown frame is ignored
+			}
+			recv_buffer_.erase(0, size);
+
+			if (popped) {
+				return true;
+			}
+		}
+
+		while (true) {
+			size_t pos = recv_buffer_.find_first_of(std::string("\n\0", 2));
+			if (pos == std::string::npos) {
+				if (!text_tail_ || recv_buffer_.empty()) {
+					return false;
+				}
+				pos = recv_buffer_.size();  // tail of data
+				text_tail_ = false;
+			}
+
+			// Get message without delimiter and '\r'
+			std::string msg = recv_buffer_.substr(0, pos);
+			recv_buffer_.erase(0, pos + 1);
+			if (!msg.empty() && msg.back() == '\r') {
+				msg.pop_back();
+			}
+			if (msg.empty()) {
+				continue;  // skip empty line
+			}
+
+			size_t len = msg.copy(message, kBufferSize - 1);
+			message[len] = '\0';
+
+			// Player sends frames after 'READYOK BIN1' (only as reply of 'ISREADY BIN1')
+			dcp::Tokens tokens(message);
+			if (binary_offered_ && tokens.Is("READYOK") && tokens[1] == dcp::kBinaryVersion) {
+				framed_ = true;
+				text_tail_ = false;
+			}
+			return true;
+		}
+	}
+
 	LocalPlayer::LocalPlayer(std::string path, int time_limit, float random_x, float random_y)
 	{
+		// process is not created yet
+#ifdef _WIN32
+		ZeroMemory(&pi_, sizeof(pi_));
+		write_pipe_ = read_pipe_ = NULL;
+#else
+		pid_ = 0;
+		write_fd_ = read_fd_ = -1;
+#endif
+
 		// set file path
 		path_ = path;
 
 		// get name from path
-		std::istringstream sstream(path);
 		std::string name;
 		// remove directories from path
-		while (std::getline(sstream, name, '\\'));
+		name = path.substr(path.find_last_of("\\/") + 1);
 		std::istringstream exe_file_name(name);
 		// remove .exe from path
 		std::getline(exe_file_name, name, '.');
@@ -60,14 +340,22 @@ namespace digital_curling
 	}
 
 	LocalPlayer::LocalPlayer(std::string path, int time_limit, PlayerInfo pinfo) {
+		// process is not created yet
+#ifdef _WIN32
+		ZeroMemory(&pi_, sizeof(pi_));
+		write_pipe_ = read_pipe_ = NULL;
+#else
+		pid_ = 0;
+		write_fd_ = read_fd_ = -1;
+#endif
+
 		// set file path
 		path_ = path;
 
 		// get name from path
-		std::istringstream sstream(path);
 		std::string name;
 		// remove directories from path
-		while (std::getline(sstream, name, '\\'));
+		name = path.substr(path.find_last_of("\\/") + 1);
 		std::istringstream exe_file_name(name);
 		// remove .exe from path
 		std::getline(exe_file_name, name, '.');
@@ -85,70 +373,118 @@ namespace digital_curling
 		pinfo_ = pinfo;
 	}
 
-	LocalPlayer::~LocalPlayer() {}
+	LocalPlayer::~LocalPlayer() {
+		// Reader thread is running until the process exits
+		ExitProcess();
+	}
 
-	// recieve message from player
+	// send message to player
 	int LocalPlayer::Send(const char *message)
 	{
 		//cout << "Server -> LocalPlayer: '" << message << "'" << endl;
-		DWORD NumberOfBytesWritten = 0;
-		if (this->write_pipe_ != NULL) {
-			WriteFile(this->write_pipe_, message, (DWORD)strlen(message) + 1, &NumberOfBytesWritten, NULL);
+		size_t size = strlen(message);
+		if (binary_) {
+			// Message in frame (binary DCP)
+			char frame[dcp::kFrameHeaderSize + kBufferSize];
+			size = dcp::WriteFrame(dcp::FRAME_MESSAGE, 0, message, size, frame, sizeof(frame));
+			return (Write(frame, size)) ? (int)size : 0;
+		}
+
+		// Write message with '\0'
+		return (Write(message, size + 1)) ? (int)size + 1 : 0;
+	}
+
+	// Send state in frame instead of 'POSITION' and 'SETSTATE'
+	bool LocalPlayer::SetState(const GameState &gs) {
+		if (!binary_) {
+			return false;
 		}
+		char data[dcp::kStateSize];
+		char frame[dcp::kFrameHeaderSize + dcp::kStateSize];
+		dcp::EncodeState(gs, data);
+		Write(frame, dcp::WriteFrame(dcp::FRAME_STATE, 0, data, sizeof(data), frame, sizeof(frame)));
+		return true;
+	}
 
-		return NumberOfBytesWritten;
+	// Send 'GO' in frame
+	bool LocalPlayer::SendGo(int time_remain1, int time_remain2) {
+		if (!binary_) {
+			return false;
+		}
+		char data[dcp::kGoSize];
+		char frame[dcp::kFrameHeaderSize + dcp::kGoSize];
+		dcp::EncodeGo(time_remain1, time_remain2, data);
+		Write(frame, dcp::WriteFrame(dcp::FRAME_GO, 0, data, sizeof(data), frame, sizeof(frame)));
+		return true;
+	}
+
+#ifdef _WIN32
+
+	// Write bytes to player
+	bool LocalPlayer::Write(const char *data, size_t size) {
+		DWORD NumberOfBytesWritten = 0;
+		if (this->write_pipe_ == NULL) {
+			return false;
+		}
+		return WriteFile(this->write_pipe_, data, (DWORD)size, &NumberOfBytesWritten, NULL) && NumberOfBytesWritten == size;
 	}
 
 	// recieve message from player
 	int LocalPlayer::Recv(char *message)
 	{
-		DWORD NumberOfBytesRead = 0;
 		memset(message, 0, kBufferSize);
-		if (this->read_pipe_ != NULL) {
-			ReadFile(this->read_pipe_, message, kBufferSize, &NumberOfBytesRead, NULL);
+
+		// Read from pipe until a message is framed
+		while (!PopMessage(message)) {
+			char buffer[kBufferSize];
+			DWORD NumberOfBytesRead = 0;
+			if (this->read_pipe_ == NULL ||
+				!ReadFile(this->read_pipe_, buffer, kBufferSize, &NumberOfBytesRead, NULL) ||
+				NumberOfBytesRead == 0) {
+				return 0;
+			}
+			PushData(buffer, NumberOfBytesRead);
 		}
 
 		//cout << "LocalPlayer -> Server: '" << message << "'" << endl;
 		
-		return NumberOfBytesRead;
+		return (int)strlen(message);
 	}
 
 	// Create Proccess
 	// This function returns 0 when CreateProcess was failed
 	int LocalPlayer::InitProcess()
 	{
+		// Pipes must not be inherited by processes created by other threads at the same time
+		static std::mutex create_mutex;
+		std::lock_guard<std::mutex> lock(create_mutex);
+
 		/*** create pipe ***/
-		HANDLE read_tmp, write_tmp;
+		HANDLE child_read, child_write;
 		SECURITY_ATTRIBUTES sa;
 		sa.nLength = sizeof(SECURITY_ATTRIBUTES);
 		sa.lpSecurityDescriptor = NULL;
 		sa.bInheritHandle = TRUE;
 
-		// server -> COM
-		if (!CreatePipe(&read_tmp, &write_pipe_, &sa, 0)) {
-			return 0;
-		}
-		if (!DuplicateHandle(GetCurrentProcess(), read_tmp, GetCurrentProcess(), &read_pipe_, 0, TRUE, DUPLICATE_SAME_ACCESS)) {
-			return 0;
-		}
-		CloseHandle(read_tmp);
-
-		// COM -> server
-		if (!CreatePipe(&read_pipe_, &write_tmp, &sa, 0)) {
+		// server -> COM (stdin of COM)
+		if (!CreatePipe(&child_read, &write_pipe_, &sa, 0)) {
 			return 0;
 		}
-		if (!DuplicateHandle(GetCurrentProcess(), write_tmp, GetCurrentProcess(), &write_pipe_, 0, TRUE, DUPLICATE_SAME_ACCESS)) {
+		// COM -> server (stdout of COM)
+		if (!CreatePipe(&read_pipe_, &child_write, &sa, 0)) {
 			return 0;
 		}
-		CloseHandle(write_tmp);
+		// Ends of server should not be inherited
+		SetHandleInformation(write_pipe_, HANDLE_FLAG_INHERIT, 0);
+		SetHandleInformation(read_pipe_, HANDLE_FLAG_INHERIT, 0);
 
 		// redirection
 		STARTUPINFO si;
 		ZeroMemory(&si, sizeof(si));
 		si.cb = sizeof(STARTUPINFO);
 		si.dwFlags = STARTF_USESTDHANDLES;
-		si.hStdInput = this->read_pipe_;
-		si.hStdOutput = this->write_pipe_;
+		si.hStdInput = child_read;
+		si.hStdOutput = child_write;
 		si.hStdError = GetStdHandle(STD_ERROR_HANDLE);
 
 		if (si.hStdOutput == INVALID_HANDLE_VALUE || si.hStdError == INVALID_HANDLE_VALUE) {
@@ -156,14 +492,657 @@ namespace digital_curling
 		}
 
 		/*** create process ***/
-		return CreateProcess(NULL, (LPSTR)path_.c_str(), NULL, NULL, TRUE, 0, NULL, NULL, &si, &pi_);
+		int ret = CreateProcess(NULL, (LPSTR)path_.c_str(), NULL, NULL, TRUE, 0, NULL, NULL, &si, &pi_);
+
+		// Close ends of COM (ReadFile() fails when COM exits)
+		CloseHandle(child_read);
+		CloseHandle(child_write);
+
+		// Start reading messages from COM
+		if (ret) {
+			StartReader();
+		}
+
+		return ret;
 	}
 
 	// Exit process
 	int LocalPlayer::ExitProcess() {
-		if (!TerminateProcess(pi_.hProcess, 0)) {
+		if (pi_.hProcess == NULL) {
+			return 1;  // not running
+		}
+		if (!TerminateProcess(pi_.hProcess, 0) && WaitForSingleObject(pi_.hProcess, 0) != WAIT_OBJECT_0) {
+			return 0;  // failed to terminate running process
+		}
+
+		// Reader thread exits as the pipe is broken
+		WaitForSingleObject(pi_.hProcess, INFINITE);
+		JoinReader();
+
+		// Close handles of process and pipes
+		CloseHandle(pi_.hProcess);
+		CloseHandle(pi_.hThread);
+		CloseHandle(write_pipe_);
+		CloseHandle(read_pipe_);
+		write_pipe_ = read_pipe_ = NULL;
+		pi_.hProcess = pi_.hThread = NULL;
+
+		return 1;
+	}
+#else
+	// Write bytes to player
+	bool LocalPlayer::Write(const char *data, size_t size)
+	{
+		if (write_fd_ < 0) {
+			return false;
+		}
+
+		while (size > 0) {
+			ssize_t n = write(write_fd_, data, size);
+			if (n < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				return false;  // process exited (EPIPE)
+			}
+			data += n;
+			size -= n;
+		}
+
+		return true;
+	}
+
+	// recieve message from player
+	// Messages are read by EventLoop, this function waits for one of them
+	int LocalPlayer::Recv(char *message)
+	{
+		if (!RecvWait(message, kTimeLimitInfinite)) {
+			return 0;
+		}
+		return (int)strlen(message);
+	}
+
+	// Create Proccess
+	// This function returns 0 when posix_spawn was failed
+	int LocalPlayer::InitProcess()
+	{
+		// Server is not killed by writing to player which exited
+		signal(SIGPIPE, SIG_IGN);
+
+		/*** create pipe ***/
+		// Ends of server are not inherited by any process (O_CLOEXEC)
+		int to_child[2];    // server -> COM (stdin of COM)
+		int from_child[2];  // COM -> server (stdout of COM)
+		if (pipe2(to_child, O_CLOEXEC) != 0) {
+			return 0;
+		}
+		if (pipe2(from_child, O_CLOEXEC) != 0) {
+			close(to_child[0]);
+			close(to_child[1]);
+			return 0;
+		}
+
+		// redirection (dup2() clears O_CLOEXEC of stdin and stdout)
+		posix_spawn_file_actions_t actions;
+		posix_spawn_file_actions_init(&actions);
+		posix_spawn_file_actions_adddup2(&actions, to_child[0], STDIN_FILENO);
+		posix_spawn_file_actions_adddup2(&actions, from_child[1], STDOUT_FILENO);
+
+		// Split path as arguments e.g. './SampleAI arg1'
+		std::vector<std::string> args;
+		std::istringstream sstream(path_);
+		std::string arg;
+		while (sstream >> arg) {
+			args.push_back(arg);
+		}
+		std::vector<char*> argv;
+		for (size_t i = 0; i < args.size(); i++) {
+			argv.push_back(&args[i][0]);
+		}
+		argv.push_back(nullptr);
+
+		/*** create process ***/
+		int ret = (args.size() > 0) && (posix_spawn(&pid_, argv[0], &actions, nullptr, argv.data(), environ) == 0);
+		posix_spawn_file_actions_destroy(&actions);
+
+		// Close ends of COM (read() returns 0 when COM exits)
+		close(to_child[0]);
+		close(from_child[1]);
+
+		if (!ret) {
+			pid_ = 0;
+			close(to_child[1]);
+			close(from_child[0]);
+			return 0;
+		}
+		write_fd_ = to_child[1];
+		read_fd_ = from_child[0];
+
+		// Start reading messages from COM on EventLoop
+		OpenQueue();
+		EventLoop::Instance().Add(read_fd_, this);
+
+		return 1;
+	}
+
+	// Exit process
+	int LocalPlayer::ExitProcess() {
+		if (pid_ == 0) {
+			return 1;  // not running
+		}
+
+		// EventLoop does not read from the pipe after Remove()
+		EventLoop::Instance().Remove(read_fd_);
+		CloseQueue();
+
+		kill(pid_, SIGKILL);
+		waitpid(pid_, nullptr, 0);
+		pid_ = 0;
+
+		// Close pipes
+		close(write_fd_);
+		close(read_fd_);
+		write_fd_ = read_fd_ = -1;
+
+		return 1;
+	}
+#endif
+
+	PluginPlayer::PluginPlayer(std::string path, int time_limit, PlayerInfo pinfo) {
+		// plugin is not loaded yet
+		module_ = NULL;
+		plugin_ = nullptr;
+		ai_ = nullptr;
+		memset(&state_, 0, sizeof(state_));
+
+		// set file path
+		path_ = path;
+
+		// get name from path
+		std::string name;
+		// remove directories from path
+		name = path.substr(path.find_last_of("\\/") + 1);
+		std::istringstream lib_file_name(name);
+		// remove .dll/.so from path
+		std::getline(lib_file_name, name, '.');
+		name_ = name;
+
+		// set timelimit
+		if (time_limit > 0) {
+			time_limit_ = time_remain_ = time_limit;
+		}
+		else {
+			time_limit_ = time_remain_ = INT_MAX;
+		}
+
+		// set player info
+		pinfo_ = pinfo;
+	}
+
+	PluginPlayer::~PluginPlayer() {
+		ExitProcess();
+	}
+
+	// Deliver reply of plugin to queue (same as a message from LocalPlayer)
+	void PluginPlayer::Reply(const char *message) {
+		DeliverData(message, strlen(message) + 1);
+	}
+
+	// send message to player
+	// Plugin is called in this thread, so time of 'GO' includes time of go()
+	int PluginPlayer::Send(const char *message)
+	{
+		if (ai_ == nullptr) {
+			return 0;
+		}
+
+		dcp::Tokens tokens(message);
+		if (tokens.Size() == 0) {
+			return (int)strlen(message) + 1;  // empty message
+		}
+
+		char reply[kBufferSize];
+		if (tokens.Is("ISREADY")) {
+			Reply("READYOK");
+		}
+		else if (tokens.Is("NEWGAME")) {
+			names_[0] = std::string(tokens[1]);
+			names_[1] = std::string(tokens[2]);
+		}
+		else if (tokens.Is("GAMEINFO")) {
+			DCPluginGameInfo info;
+			memset(&info, 0, sizeof(info));
+			info.name[0] = names_[0].c_str();
+			info.name[1] = names_[1].c_str();
+			tokens.Get(1, &info.rule_type);
+			tokens.Get(2, &info.random_type);
+			info.nplayers = pinfo_.nplayers;
+			for (int i = 0; i < 4; i++) {
+				info.params[i][0] = pinfo_.params[i].random_1;
+				info.params[i][1] = pinfo_.params[i].random_2;
+				info.params[i][2] = pinfo_.params[i].shot_max;
+			}
+			if (plugin_->on_new_game != nullptr) {
+				plugin_->on_new_game(ai_, &info);
+			}
+		}
+		else if (tokens.Is("GO")) {
+			int time_remain[2] = { kTimeLimitInfinite, kTimeLimitInfinite };
+			tokens.Get(1, &time_remain[0]);
+			tokens.Get(2, &time_remain[1]);
+
+			DCPluginShot shot = { 0.0f, 0.0f, 0 };
+			if (plugin_->go(ai_, &state_, time_remain, &shot) == DC_PLUGIN_CONCEDE) {
+				Reply("CONCEDE");
+			}
+			else {
+				// Shot is not converted to text and back
+				DeliverShot(ShotVec(shot.x, shot.y, shot.angle != 0));
+			}
+		}
+		else if (tokens.Is("PUTSTONE")) {
+			snprintf(reply, sizeof(reply), "PUTSTONE %d",
+				(plugin_->put_stone != nullptr) ? plugin_->put_stone(ai_, &state_) : 0);
+			Reply(reply);
+		}
+		else if (tokens.Is("SETORDER")) {
+			int order = (plugin_->set_order != nullptr) ? plugin_->set_order(ai_, &state_) : 0;
+			snprintf(reply, sizeof(reply), "SETORDER %d %d", (order) ? 1 : 0, (order) ? 0 : 1);
+			Reply(reply);
+		}
+		else if (tokens.Is("SCORE")) {
+			int score = 0;
+			tokens.Get(1, &score);
+			if (plugin_->on_score != nullptr) {
+				plugin_->on_score(ai_, score);
+			}
+		}
+		else if (tokens.Is("GAMEOVER")) {
+			int result = DC_PLUGIN_DRAW;
+			if (tokens[1] == "WIN") {
+				result = DC_PLUGIN_WIN;
+			}
+			else if (tokens[1] == "LOSE") {
+				result = DC_PLUGIN_LOSE;
+			}
+			if (plugin_->on_game_over != nullptr) {
+				plugin_->on_game_over(ai_, result);
+			}
+		}
+
+		return (int)strlen(message) + 1;
+	}
+
+	// recieve message from player
+	// Replies are delivered to queue by Send(), this function waits for one of them
+	int PluginPlayer::Recv(char *message)
+	{
+		if (!RecvWait(message, 0)) {
+			return 0;
+		}
+		return (int)strlen(message);
+	}
+
+	// Set state of the game to plugin directly
+	bool PluginPlayer::SetState(const GameState &gs) {
+		if (ai_ == nullptr) {
+			return false;
+		}
+
+		state_.shot_num = gs.ShotNum;
+		state_.cur_end = gs.CurEnd;
+		state_.last_end = gs.LastEnd;
+		for (int i = 0; i < 10; i++) {
+			state_.score[i] = gs.Score[i];
+		}
+		state_.white_to_move = (gs.WhiteToMove) ? 1 : 0;
+		memcpy(state_.body, gs.body, sizeof(state_.body));
+
+		if (plugin_->on_state != nullptr) {
+			plugin_->on_state(ai_, &state_);
+		}
+
+		return true;
+	}
+
+	// Load plugin
+	// This function returns 0 when plugin was not loaded
+	int PluginPlayer::InitProcess()
+	{
+		DCPluginEntry entry = nullptr;
+#ifdef _WIN32
+		module_ = LoadLibraryA(path_.c_str());
+		if (module_ == NULL) {
+			cerr << "failed to load " << path_ << endl;
+			return 0;
+		}
+		entry = (DCPluginEntry)GetProcAddress(module_, DC_PLUGIN_ENTRY);
+#else
+		module_ = dlopen(path_.c_str(), RTLD_NOW | RTLD_LOCAL);
+		if (module_ == NULL) {
+			cerr << "failed to load " << path_ << ": " << dlerror() << endl;
+			return 0;
+		}
+		entry = (DCPluginEntry)dlsym(module_, DC_PLUGIN_ENTRY);
+#endif
+		if (entry != nullptr) {
+			plugin_ = entry();
+		}
+		if (plugin_ == nullptr || plugin_->version != DC_PLUGIN_VERSION ||
+			plugin_->create == nullptr || plugin_->destroy == nullptr || plugin_->go == nullptr) {
+			cerr << "invalid plugin " << path_ << " (" DC_PLUGIN_ENTRY " of version " << DC_PLUGIN_VERSION << " is required)" << endl;
+			plugin_ = nullptr;
+			ExitProcess();
+			return 0;
+		}
+
+		ai_ = plugin_->create();
+		if (ai_ == nullptr) {
+			cerr << "failed to create AI of plugin " << path_ << endl;
+			ExitProcess();
+			return 0;
+		}
+
+		OpenQueue();
+
+		return 1;
+	}
+
+	// Unload plugin
+	int PluginPlayer::ExitProcess() {
+		if (ai_ != nullptr) {
+			plugin_->destroy(ai_);
+			ai_ = nullptr;
+		}
+		plugin_ = nullptr;
+		CloseQueue();
+
+		if (module_ != NULL) {
+#ifdef _WIN32
+			FreeLibrary(module_);
+#else
+			dlclose(module_);
+#endif
+			module_ = NULL;
+		}
+
+		return 1;
+	}
+
+#ifdef _WIN32
+	static const UINT_PTR kNoSocket = INVALID_SOCKET;
+#else
+	static const int kNoSocket = -1;
+#endif
+
+	NetworkPlayer::NetworkPlayer(std::string host, int port, int time_limit, PlayerInfo pinfo) : seq_(0), num_round_trips_(0), round_trip_(0) {
+		// not connected yet
+		socket_ = kNoSocket;
+
+		// set address
+		host_ = host;
+		port_ = port;
+
+		// get name from address (':' is not used for name of log file)
+		name_ = host + "_" + std::to_string(port);
+
+		// set timelimit
+		if (time_limit > 0) {
+			time_limit_ = time_remain_ = time_limit;
+		}
+		else {
+			time_limit_ = time_remain_ = INT_MAX;
+		}
+
+		// set player info
+		pinfo_ = pinfo;
+	}
+
+	NetworkPlayer::~NetworkPlayer() {
+		ExitProcess();
+	}
+
+	// send message to player
+	int NetworkPlayer::Send(const char *message)
+	{
+		size_t size = strlen(message);
+		if (socket_ == kNoSocket || size == 0) {
+			return 0;
+		}
+
+		if (!SendFrame(dcp::FRAME_MESSAGE, message, size, !dcp::Tokens(message).Is("GO"))) {
+			return 0;
+		}
+
+		return (int)size + 1;
+	}
+
+	// Send state in frame instead of 'POSITION' and 'SETSTATE'
+	bool NetworkPlayer::SetState(const GameState &gs) {
+		if (!binary_) {
+			return false;
+		}
+		char data[dcp::kStateSize];
+		dcp::EncodeState(gs, data);
+		SendFrame(dcp::FRAME_STATE, data, sizeof(data));
+		return true;
+	}
+
+	// Send 'GO' in frame
+	bool NetworkPlayer::SendGo(int time_remain1, int time_remain2) {
+		if (!binary_) {
+			return false;
+		}
+		char data[dcp::kGoSize];
+		dcp::EncodeGo(time_remain1, time_remain2, data);
+		SendFrame(dcp::FRAME_GO, data, sizeof(data), false);
+		return true;
+	}
+
+	// recieve message from player
+	int NetworkPlayer::Recv(char *message)
+	{
+#ifdef _WIN32
+		memset(message, 0, kBufferSize);
+
+		// Read from socket until a message is popped from frames
+		while (!PopMessage(message)) {
+			char buffer[kBufferSize];
+			int size = recv((SOCKET)socket_, buffer, sizeof(buffer), 0);
+			if (size <= 0) {
+				return 0;  // disconnected
+			}
+			PushData(buffer, size);
+		}
+
+		return (int)strlen(message);
+#else
+		// Messages are read by EventLoop, this function waits for one of them
+		if (!RecvWait(message, kTimeLimitInfinite)) {
 			return 0;
 		}
+		return (int)strlen(message);
+#endif
+	}
+
+	// Round trip time of the transport
+	int NetworkPlayer::RoundTrip() const {
+		return round_trip_ / 1000;
+	}
+
+	// Send all bytes
+	bool NetworkPlayer::SendAll(const char *data, size_t size) {
+		while (size > 0) {
+#ifdef _WIN32
+			int n = send((SOCKET)socket_, data, (int)size, 0);
+			if (n == SOCKET_ERROR) {
+				return false;
+			}
+#else
+			ssize_t n = send(socket_, data, size, MSG_NOSIGNAL);
+			if (n < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				if (errno == EAGAIN || errno == EWOULDBLOCK) {
+					// Socket is non-blocking for EventLoop, wait until it is writable
+					pollfd pfd;
+					pfd.fd = socket_;
+					pfd.events = POLLOUT;
+					pfd.revents = 0;
+					poll(&pfd, 1, 1000);
+					continue;
+				}
+				return false;  // disconnected
+			}
+#endif
+			data += n;
+			size -= n;
+		}
+
+		return true;
+	}
+
+	// Send a frame with next sequence number
+	bool NetworkPlayer::SendFrame(unsigned char type, const char *data, size_t size, bool timed) {
+		// Remember time to measure round trip time with ACK
+		uint32_t seq;
+		{
+			std::lock_guard<std::mutex> lock(sent_mutex_);
+			seq = ++seq_;
+			if (timed) {
+				sent_[seq] = std::chrono::steady_clock::now();
+			}
+		}
+
+		// Header and data are sent at once (Nagle's algorithm is disabled)
+		char frame[dcp::kFrameHeaderSize + kBufferSize];
+		size = dcp::WriteFrame(type, seq, data, size, frame, sizeof(frame));
+
+		return size > 0 && SendAll(frame, size);
+	}
+
+	// Measure round trip time of an acknowledged frame
+	void NetworkPlayer::OnAck(uint32_t seq) {
+		std::lock_guard<std::mutex> lock(sent_mutex_);
+
+		// Frames are acknowledged in order (frames before seq are not measured)
+		std::map<uint32_t, std::chrono::steady_clock::time_point>::iterator it = sent_.find(seq);
+		if (it == sent_.end()) {
+			sent_.erase(sent_.begin(), sent_.upper_bound(seq));
+			return;
+		}
+		round_trips_[num_round_trips_++ % kRoundTripWindow] = (int)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - it->second).count();
+		sent_.erase(sent_.begin(), ++it);
+
+		// Minimum of the window is the transport without delay of player
+		int round_trip = kMaxRoundTrip * 1000;
+		unsigned int n = (num_round_trips_ < kRoundTripWindow) ? num_round_trips_ : kRoundTripWindow;
+		for (unsigned int i = 0; i < n; i++) {
+			if (round_trips_[i] < round_trip) {
+				round_trip = round_trips_[i];
+			}
+		}
+		round_trip_ = round_trip;
+	}
+
+	// Connect to player
+	// This function returns 0 when connect was failed
+	int NetworkPlayer::InitProcess()
+	{
+#ifdef _WIN32
+		WSADATA wsa_data;
+		if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) {
+			return 0;
+		}
+#endif
+
+		addrinfo hints;
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+		addrinfo *result = nullptr;
+		if (getaddrinfo(host_.c_str(), std::to_string(port_).c_str(), &hints, &result) != 0) {
+			cerr << "failed to resolve " << host_ << endl;
+#ifdef _WIN32
+			WSACleanup();
+#endif
+			return 0;
+		}
+
+		// Try each address of host
+		for (addrinfo *ai = result; ai != nullptr && socket_ == kNoSocket; ai = ai->ai_next) {
+#ifdef _WIN32
+			SOCKET s = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+			if (s == INVALID_SOCKET) {
+				continue;
+			}
+			if (connect(s, ai->ai_addr, (int)ai->ai_addrlen) != 0) {
+				closesocket(s);
+				continue;
+			}
+#else
+			int s = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+			if (s < 0) {
+				continue;
+			}
+			if (connect(s, ai->ai_addr, ai->ai_addrlen) != 0) {
+				close(s);
+				continue;
+			}
+#endif
+			socket_ = s;
+		}
+		freeaddrinfo(result);
+
+		if (socket_ == kNoSocket) {
+			cerr << "failed to connect to " << host_ << ":" << port_ << endl;
+#ifdef _WIN32
+			WSACleanup();
+#endif
+			return 0;
+		}
+
+		// Small messages are sent at once (disable Nagle's algorithm)
+		int flag = 1;
+		setsockopt(socket_, IPPROTO_TCP, TCP_NODELAY, (const char*)&flag, sizeof(flag));
+
+		seq_ = 0;
+		sent_.clear();
+		num_round_trips_ = 0;
+		round_trip_ = 0;
+
+		// Start reading messages from player
+#ifdef _WIN32
+		StartReader(true);
+#else
+		OpenQueue(true);
+		EventLoop::Instance().Add(socket_, this);
+#endif
+
+		return 1;
+	}
+
+	// Disconnect from player
+	int NetworkPlayer::ExitProcess() {
+		if (socket_ == kNoSocket) {
+			return 1;  // not connected
+		}
+
+#ifdef _WIN32
+		// Reader thread exits as recv() fails
+		shutdown((SOCKET)socket_, SD_BOTH);
+		JoinReader();
+		closesocket((SOCKET)socket_);
+		WSACleanup();
+#else
+		// EventLoop does not read from the socket after Remove()
+		EventLoop::Instance().Remove(socket_);
+		CloseQueue();
+		close(socket_);
+#endif
+		socket_ = kNoSocket;
+
 		return 1;
 	}
 }
\ No newline at end of file
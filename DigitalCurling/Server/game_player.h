@@ -1,7 +1,24 @@
 #pragma once
 
+#ifdef _WIN32
 #include <Windows.h>
+#else
+#include <sys/types.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <map>
+#include <mutex>
 #include <string>
+#include <thread>
+
+#include "dc_plugin.h"
+#include "dcurling_simulator.h"
+#include "latency_stats.h"
+#include "message_queue.h"
 
 namespace digital_curling {
 
@@ -25,11 +42,38 @@ namespace digital_curling {
 		static const size_t kBufferSize = 1024;
 		static const int kTimeLimitInfinite = INT_MAX;
 
+		Player();
+		virtual ~Player();
+
 		// Send message from player
 		virtual int Send(const char *message) = 0;
-		// Recieve message from player
+		// Recieve message from player (blocks until a message arrives, used by reader thread)
 		virtual int Recv(char *message) = 0;
 
+		// Recieve message from queue of reader thread, waiting for it until time out [msec]
+		// This function returns false if no message arrived
+		bool RecvWait(char *message, unsigned int time_out);
+		// Discard messages in queue (e.g. late reply of a command which timed out)
+		// This function returns number of messages discarded
+		int DiscardMessages();
+
+		// Take shot of 'BESTSHOT' (without arguments) which was delivered as ShotVec instead of text
+		// This function returns false if no shot was delivered
+		bool TakeShot(ShotVec *vec);
+
+		// Set state of the game to player directly instead of 'POSITION' and 'SETSTATE'
+		// This function returns false if player needs the messages (default)
+		virtual bool SetState(const GameState &gs) { return false; }
+		// Send 'GO' directly (e.g. in frame of binary DCP)
+		// This function returns false if player needs the message (default)
+		virtual bool SendGo(int time_remain1, int time_remain2) { return false; }
+
+		// Round trip time of the transport to player [msec] (not counted as time used by player)
+		virtual int RoundTrip() const { return 0; }
+		// Send() returns after player handled the message in the server (e.g. PluginPlayer)
+		// Time of Send() is then time used by player, not latency of the transport
+		virtual bool Synchronous() const { return false; }
+
 		// Create process 
 		// This function returns 0 when CreateProcess was failed
 		virtual int InitProcess() = 0;
@@ -46,6 +90,66 @@ namespace digital_curling {
 		PlayerInfo pinfo_;
 		
 		bool mix_doubles;
+
+		bool binary_;       // Binary DCP is used to send (after 'READYOK BIN1', see DCP.md)
+
+		// Server offers binary DCP with 'ISREADY BIN1' (call before sending it)
+		// Received bytes are frames after 'READYOK BIN1' only if it was offered
+		void OfferBinary();
+
+		LatencyStats latency_;  // Latencies of DCP commands (recorded by GameProcess)
+
+	protected:
+		// Start thread which recieves messages with Recv() into queue (call after process is created)
+		void StartReader(bool framed = false);
+		// Wait for reader thread to exit (call after Recv() is unblocked e.g. process is terminated)
+		void JoinReader();
+
+		// Clear queue and received bytes before messages are delivered
+		//   framed: received bytes are frames from the beginning (otherwise after 'READYOK BIN1')
+		void OpenQueue(bool framed = false);
+		// Deliver received bytes to queue as messages (instead of reader thread, e.g. from EventLoop)
+		void DeliverData(const char *data, size_t size);
+		// No more messages will be delivered
+		void CloseQueue();
+		// Deliver 'BESTSHOT' with shot as is (popped by TakeShot() after the message)
+		void DeliverShot(const ShotVec &vec);
+
+		// Append received bytes (end of data is also end of a text message, a partial frame is kept until the rest is appended)
+		void PushData(const char *data, size_t size);
+		// Pop a message delimited by '\n' or '\0', or a message in frame (returns false if no message)
+		// FRAME_BESTSHOT is popped as 'BESTSHOT' and its shot is kept for TakeShot()
+		bool PopMessage(char *message);
+		// Acknowledgement of frame seq is received (network transport)
+		virtual void OnAck(uint32_t seq) {}
+
+		std::string recv_buffer_;           // Received bytes which are not popped yet
+		bool framed_;                       // Received bytes are frames (used by thread which receives)
+		bool text_tail_;                    // Text at the end of recv_buffer_ is a whole message
+		std::atomic<bool> binary_offered_;  // 'ISREADY BIN1' was sent
+
+	private:
+		friend class EventLoop;
+
+		// Loop of reader thread
+		void ReadLoop();
+		// Deliver messages which stayed in recv_buffer_ while the queue was full (consumer)
+		void DeliverPending();
+		// Push messages in recv_buffer_ to queue (deliver_mutex_ must be locked)
+		void PushMessages();
+		// Keep shot for TakeShot()
+		void KeepShot(const ShotVec &vec);
+
+		MessageQueue queue_;             // Messages recieved by reader thread
+		std::thread reader_;             // Reader thread
+		std::atomic<bool> stop_reader_;  // Reader thread should exit
+
+		std::mutex deliver_mutex_;       // for recv_buffer_ while delivering (by I/O thread or consumer)
+		std::atomic<bool> pending_;      // Messages may stay in recv_buffer_ (queue was full)
+
+		std::mutex shot_mutex_;          // for shot_ and has_shot_
+		ShotVec shot_;                   // Shot of the last 'BESTSHOT' delivered by DeliverShot()
+		bool has_shot_;                  // shot_ is not taken yet
 	};
 
 	// Player running on local
@@ -60,6 +164,10 @@ namespace digital_curling {
 		// Recieve message from player
 		int Recv(char *message);
 
+		// Send state and 'GO' in frames (binary DCP)
+		bool SetState(const GameState &gs);
+		bool SendGo(int time_remain1, int time_remain2);
+
 		// Create process 
 		// This function returns 0 when CreateProcess was failed
 		int InitProcess();
@@ -68,25 +176,116 @@ namespace digital_curling {
 
 		std::string path_;  // Full path of .exe file
 
+#ifdef _WIN32
 		PROCESS_INFORMATION pi_;
-		HANDLE write_pipe_;
-		HANDLE read_pipe_;
+		HANDLE write_pipe_;  // server -> player (stdin of player)
+		HANDLE read_pipe_;   // player -> server (stdout of player)
+#else
+		pid_t pid_;          // process id of player (0: not running)
+		int write_fd_;       // server -> player (stdin of player)
+		int read_fd_;        // player -> server (stdout of player, read by EventLoop)
+#endif
+
+	private:
+		// Write bytes to player
+		bool Write(const char *data, size_t size);
+	};
 
+	// Player loaded from shared library (.dll/.so) in the server process (see dc_plugin.h)
+	class PluginPlayer : public Player {
+	public:
+		PluginPlayer(std::string path, int time_limit, PlayerInfo pinfo);
+		~PluginPlayer();
+
+		// Send message to player (calls function of plugin and delivers the reply to queue)
+		int Send(const char *message);
+		// Recieve message from player (not used)
+		int Recv(char *message);
+
+		// Set state of the game to plugin directly
+		bool SetState(const GameState &gs);
+
+		// Functions of plugin are called in Send()
+		bool Synchronous() const { return true; }
+
+		// Load plugin
+		// This function returns 0 when plugin was not loaded
+		int InitProcess();
+		// Unload plugin
+		int ExitProcess();
+
+		std::string path_;  // Full path of .dll/.so file
+
+	private:
+		// Deliver reply of plugin to queue
+		void Reply(const char *message);
+
+#ifdef _WIN32
+		HMODULE module_;
+#else
+		void *module_;
+#endif
+		const DCPlugin *plugin_;   // functions of plugin
+		void *ai_;                 // instance created by plugin
+		DCPluginState state_;      // last state of the game
+		std::string names_[2];     // names of players from 'NEWGAME'
 	};
 
-	// Player running on nerwork (using socket to communicate)
-	/*
-	// TODO: 
+	// Player running on nerwork (DCP messages in frames over TCP, see DCP.md)
+	// The server connects to player which listens on host:port
 	class NetworkPlayer : public Player {
 	public:
+		static const int kRoundTripWindow = 16;  // number of round trip times of which minimum is used
+		static const int kMaxRoundTrip = 50;     // max round trip time not counted as time used by player [msec]
 
-		NetworkPlayer();
+		NetworkPlayer(std::string host, int port, int time_limit, PlayerInfo pinfo);
 		~NetworkPlayer();
 
 		// Send message to player
 		int Send(const char *message);
-		// Recieve message from player
+		// Recieve message from player (used by reader thread on Windows)
 		int Recv(char *message);
+
+		// Send state and 'GO' in frames (binary DCP)
+		bool SetState(const GameState &gs);
+		bool SendGo(int time_remain1, int time_remain2);
+
+		// Round trip time of the transport [msec]
+		//  minimum of the last kRoundTripWindow frames acknowledged by player except 'GO' (ACK of 'GO' may be
+		//  delayed by player as time used), and not more than kMaxRoundTrip
+		int RoundTrip() const;
+
+		// Connect to player
+		// This function returns 0 when connect was failed
+		int InitProcess();
+		// Disconnect from player
+		int ExitProcess();
+
+		std::string host_;  // Host name or address of player
+		int port_;          // Port of player
+
+	protected:
+		// Measure round trip time of an acknowledged frame
+		void OnAck(uint32_t seq);
+
+	private:
+		// Send all bytes (waits while the socket is not writable)
+		bool SendAll(const char *data, size_t size);
+		// Send a frame with next sequence number
+		//   timed: round trip time is measured with ACK of the frame
+		bool SendFrame(unsigned char type, const char *data, size_t size, bool timed = true);
+
+#ifdef _WIN32
+		UINT_PTR socket_;  // SOCKET (INVALID_SOCKET: not connected)
+#else
+		int socket_;       // socket (-1: not connected)
+#endif
+		uint32_t seq_;      // Sequence number of the last frame sent
+
+		std::mutex sent_mutex_;                                          // for sent_ and round_trips_
+		std::map<uint32_t, std::chrono::steady_clock::time_point> sent_;  // Time of timed frames not acknowledged
+		int round_trips_[kRoundTripWindow];                              // Last round trip times [usec] (ring)
+		unsigned int num_round_trips_;                                   // Number of round trip times measured
+		std::atomic<int> round_trip_;                                    // RoundTrip() [usec]
 	};
-	*/
 }
\ No newline at end of file
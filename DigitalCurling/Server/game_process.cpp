@@ -1,12 +1,16 @@
 #include "game_process.h"
 
+#include "dcurling_dcp.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
 #include <ctime>
 #include <iostream>
 #include <iomanip>
 #include <random>
 #include <sstream>
-
-#include <future>
+#include <string_view>
 #include <thread>
 
 using std::cerr;
@@ -17,7 +21,59 @@ namespace digital_curling
 	const int shotnum_order_table_normal[16]      = {0, 0, 1, 1, 2, 2, 3, 3, 0, 0, 1, 1, 2, 2, 3, 3};
 	const int shotnum_order_table_mix_doubles[16] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 0, 0};
 
-	GameProcess::GameProcess(Player *p1, Player *p2, int num_ends, int rule_type) : rule_type_(rule_type), log_file_(p1, p2) {
+	// Discard messages which arrived before a command (a late reply would be taken as reply of the command)
+	static void DiscardStale(Player *p) {
+		int count = p->DiscardMessages();
+		if (count > 0) {
+			cerr << "Warning: " << count << " message(s) from " << p->name_ << " discarded" << endl;
+		}
+	}
+
+	// Send message to player and record time to send it as latency of the command (unless Send() is synchronous)
+	// This function returns time when the message was sent
+	static std::chrono::steady_clock::time_point SendCommand(Player *p, const char *message) {
+		DiscardStale(p);
+		std::chrono::steady_clock::time_point sent = std::chrono::steady_clock::now();
+		p->Send(message);
+		if (!p->Synchronous()) {
+			std::string_view command(message);
+			p->latency_.AddSend(command.substr(0, command.find(' ')), std::chrono::steady_clock::now() - sent);
+		}
+		return sent;
+	}
+
+	// Message is a reply of command ('READYOK' for 'ISREADY', 'BESTSHOT' or 'CONCEDE' for 'GO', message of the same command for others)
+	static bool IsReplyOf(std::string_view command, const char *message) {
+		dcp::Tokens tokens(message);
+		if (command == "ISREADY") {
+			return tokens.Is("READYOK");
+		}
+		if (command == "GO") {
+			return tokens.Is("BESTSHOT") || tokens.Is("CONCEDE");
+		}
+		return tokens.Is(command);
+	}
+
+	// Wait for reply of command sent at time sent and record time until it is received
+	// Other messages are discarded (e.g. reply of a previous command which arrived after its time out)
+	static bool RecvReply(Player *p, std::string_view command, std::chrono::steady_clock::time_point sent, char *message, unsigned int time_out) {
+		std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(time_out);
+		while (true) {
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			unsigned int time_left = (now < deadline) ? (unsigned int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count() : 0;
+			if (!p->RecvWait(message, time_left)) {
+				return false;
+			}
+			if (IsReplyOf(command, message)) {
+				break;
+			}
+			cerr << "Warning: '" << message << "' is not a reply of '" << command << "' (discarded)" << endl;
+		}
+		p->latency_.AddReply(command, std::chrono::steady_clock::now() - sent);
+		return true;
+	}
+
+	GameProcess::GameProcess(Player *p1, Player *p2, int num_ends, int rule_type) : rule_type_(rule_type), log_file_(p1, p2), headless_(false), binary_dcp_(false), seeded_(false), seed_(0) {
 
 		// Initialize state of the game
 		memset(&gs_, 0, sizeof(GameState));
@@ -38,7 +94,7 @@ namespace digital_curling
 		sim = new b2simulator::Simulator();
 	}
 
-	GameProcess::GameProcess(Player *p1, Player *p2, int num_ends, int rule_type, unsigned int repetition, bool extended_end, SimulatorParams params) : rule_type_(rule_type), log_file_(p1, p2), repetition_(repetition), extended_end_(extended_end) {
+	GameProcess::GameProcess(Player *p1, Player *p2, int num_ends, int rule_type, unsigned int repetition, bool extended_end, SimulatorParams params) : rule_type_(rule_type), log_file_(p1, p2), repetition_(repetition), extended_end_(extended_end), headless_(false), binary_dcp_(false), seeded_(false), seed_(0) {
 
 		// Initialize state of the game
 		memset(&gs_, 0, sizeof(GameState));
@@ -67,23 +123,49 @@ namespace digital_curling
 		}
 	}
 
-	GameProcess::~GameProcess() {}
+	GameProcess::~GameProcess() {
+		delete sim;
+	}
 
-	// Recieve message with std::promise
-	void RecvThread(std::promise<std::string> p, Player* const player) {
-		
-		char msg[digital_curling::Player::kBufferSize];
-		player->Recv(msg);
-		p.set_value(std::string(msg));
-		
+	// Wait for player to process message
+	void GameProcess::Wait(unsigned int msec) const {
+		if (!headless_) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(msec));
+		}
 	}
-	void RecvThread2(std::string &p, Player* const player) {
 
-		std::cout << "recieve" << endl;
-		char msg[digital_curling::Player::kBufferSize];
-		player->Recv(msg);
-		p = std::string(msg);
+	// Record of binary log with current state of the game
+	BinaryLogRecord GameProcess::MakeRecord(uint32_t type) const {
+		BinaryLogRecord record(type);
+		record.cur_end = gs_.CurEnd;
+		record.last_end = gs_.LastEnd;
+		record.shot_num = gs_.ShotNum;
+		record.white_to_move = gs_.WhiteToMove;
+		memcpy(record.before, gs_.body, sizeof(record.before));
+		memcpy(record.after, gs_.body, sizeof(record.after));
+		record.time_remain[0] = player1_->time_remain_;
+		record.time_remain[1] = player2_->time_remain_;
+		return record;
+	}
 
+	// Noise of shot drawn from seed_ for current end and shot
+	// Uniform numbers from splitmix64 and Box-Muller transform give the same noise on any platform
+	void GameProcess::SeededNoise(float *r1, float *r2) const {
+		uint64_t state = (seed_ * 0x9E3779B97F4A7C15ULL) ^ (((uint64_t)gs_.CurEnd << 8) | gs_.ShotNum);
+		auto next = [&state]() {
+			uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+			return z ^ (z >> 31);
+		};
+		next();  // separate streams of near seeds
+
+		const double kTwoPi = 6.283185307179586;
+		double u1 = ((next() >> 11) + 1) * (1.0 / 9007199254740992.0);  // (0, 1]
+		double u2 = (next() >> 11) * (1.0 / 9007199254740992.0);        // [0, 1)
+		double r = std::sqrt(-2.0 * std::log(u1));
+		*r1 = (float)(r * std::cos(kTwoPi * u2));
+		*r2 = (float)(r * std::sin(kTwoPi * u2));
 	}
 
 	// Send 'ISREADY' command and wait for recieving 'READYOK' from a player
@@ -91,44 +173,21 @@ namespace digital_curling
 
 		char msg[Player::kBufferSize];
 
-		bool flag = true;  // TODO: delete
-
-		// Prepare recieve thread
-		std::string str;
-		std::future<void> f;
-		
-		RECIEVE_START:
-		f = std::async(std::launch::async, RecvThread2, std::ref(str), player);
-		Sleep(100);
-
-		if (flag)  // TODO: delete
-			player->Send("ISREADY");
-
-		// Wait for message is ready
-		std::future_status result = f.wait_for(std::chrono::milliseconds(time_out));
-
-		if (result != std::future_status::timeout) {
-			strcpy_s(msg, Player::kBufferSize, str.c_str());
-
-			// split message as token
-			std::vector<std::string> tokens = digital_curling::SpritAsTokens(msg, " ");
-			if (tokens.size() == 0) {
-				cerr << "Error: empty message" << endl;
-				return false;
-			}
-			if (tokens[0] != "READYOK") {
-				//cerr << "Error: invalid command '" << tokens[0] << "'" << endl;
-				//return false;
-
-				flag = false;  // TODO: delete
-				goto RECIEVE_START;  // TODO delete
-			}
+		// Offer binary DCP ('READYOK BIN1' if player accepts it)
+		if (binary_dcp_) {
+			player->OfferBinary();
 		}
-		else {
+		std::chrono::steady_clock::time_point sent = SendCommand(player, (binary_dcp_) ? "ISREADY BIN1" : "ISREADY");
+
+		// Wait for 'READYOK' (other messages are discarded)
+		if (!RecvReply(player, "ISREADY", sent, msg, time_out)) {
 			cerr << "Error: timeout for READYOK" << endl;
 			return false;
 		}
 
+		dcp::Tokens tokens(msg);
+		player->binary_ = binary_dcp_ && tokens[1] == dcp::kBinaryVersion;
+
 		return true;
 	}
 
@@ -141,8 +200,8 @@ namespace digital_curling
 		// Send 'NEWGAMWE p1->name_ p2->name_' command to both player
 		std::stringstream sstream;
 		sstream << "NEWGAME " << player1_->name_ << " " << player2_->name_;
-		player1_->Send(sstream.str().c_str());
-		player2_->Send(sstream.str().c_str());
+		SendCommand(player1_, sstream.str().c_str());
+		SendCommand(player2_, sstream.str().c_str());
 
 		// Clear sstream
 		sstream.str("");
@@ -150,9 +209,13 @@ namespace digital_curling
 
 		// Send 'GAMEINFO'
 		sstream << "GAMEINFO " << rule_type_ << " " << sim->random_type_;
-		player1_->Send(sstream.str().c_str());
-		player2_->Send(sstream.str().c_str());
+		SendCommand(player1_, sstream.str().c_str());
+		SendCommand(player2_, sstream.str().c_str());
 		log_file_.Write("GAMEINFO=" + sstream.str());
+		BinaryLogRecord record = MakeRecord(BinaryLogRecord::GAMEINFO);
+		record.value[0] = rule_type_;
+		record.value[1] = sim->random_type_;
+		log_file_.WriteRecord(record);
 
 		// Clear sstream
 		sstream.str("");
@@ -164,8 +227,8 @@ namespace digital_curling
 		//sstream << "RANDOMSIZE " << player1_->random_x_ << " " << player1_->random_y_ << endl;
 		//sstream2 << "RANDOMSIZE " << player2_->random_x_ << " " << player2_->random_y_ << endl;
 
-		player1_->Send(sstream.str().c_str());
-		player2_->Send(sstream2.str().c_str());
+		SendCommand(player1_, sstream.str().c_str());
+		SendCommand(player2_, sstream2.str().c_str());
 
 
 		return true;
@@ -176,30 +239,13 @@ namespace digital_curling
 
 		char msg[Player::kBufferSize];
 
-		// Prepare recieve thread
-		std::string str;
-		std::future<void> f = std::async(std::launch::async, RecvThread2, std::ref(str), p);
-		Sleep(100);
-
-		p->Send("SETORDER");
-
-		// Wait for message is ready
-		std::future_status result = f.wait_for(std::chrono::milliseconds(time_out));
-
-		std::vector<std::string> tokens;
-		if (result != std::future_status::timeout) {
-			strcpy_s(msg, Player::kBufferSize, str.c_str());
+		std::chrono::steady_clock::time_point sent = SendCommand(p, "SETORDER");
 
+		// Wait for message is ready ('SETORDER')
+		dcp::Tokens tokens;
+		if (RecvReply(p, "SETORDER", sent, msg, time_out)) {
 			// split message as token
-			tokens = digital_curling::SpritAsTokens(msg, " ");
-			if (tokens.size() == 0) {
-				cerr << "Error: empty message" << endl;
-				return false;
-			}
-			if (tokens[0] != "SETORDER") {
-				cerr << "Error: invalid command '" << tokens[0] << "'" << endl;
-				return false;
-			}
+			tokens.Split(msg);
 		}
 		else {
 			cerr << "Error: timeout for SETORDER" << endl;
@@ -209,15 +255,17 @@ namespace digital_curling
 		// Set Order
 		if (rule_type == 0) {
 			// set for normal rule
-			// ex 1 2 3 4 1 2 3 4
-			for (int i = 0; i < 4; i++) {
-				p->pinfo_.order[i] = atoi(tokens[i].c_str());
+			// ex 1 2 3 4 1 2 3 4 ('SETORDER m0 m1 m2 m3')
+			for (unsigned int i = 0; i < 4; i++) {
+				tokens.Get(i + 1, &p->pinfo_.order[i]);
 			}
 		}
 		else {
 			// set for Mix Doubles
 			// n n n 0 1 1 1 0 or n n n 1 0 0 0 1
-			if (atoi(tokens[1].c_str()) == 0) {
+			int first = 0;
+			tokens.Get(1, &first);
+			if (first == 0) {
 				p->pinfo_.order[0] = 0;
 				p->pinfo_.order[1] = 1;
 			}
@@ -255,31 +303,20 @@ namespace digital_curling
 
 			char msg[Player::kBufferSize];
 
-			// Prepare recieve thread
 			int putstone_type = 0;
 			if (player->mix_doubles) {
-				std::string str;
-				std::future<void> f = std::async(std::launch::async, RecvThread2, std::ref(str), player);
-				Sleep(100);
-
 				// Send "PUTSTONE" command
-				player->Send("PUTSTONE");
+				std::chrono::steady_clock::time_point sent = SendCommand(player, "PUTSTONE");
 
 				// Wait for message is ready
-				std::future_status result = f.wait_for(std::chrono::milliseconds(time_out));
-
-				std::vector<std::string> tokens;
-				if (result != std::future_status::timeout) {
-					strcpy_s(msg, Player::kBufferSize, str.c_str());
+				if (RecvReply(player, "PUTSTONE", sent, msg, time_out)) {
 					// set putstone_type
-					tokens = digital_curling::SpritAsTokens(msg, " ");
-					if (tokens.size() == 0) {
+					dcp::Tokens tokens(msg);
+					if (tokens.Size() == 0) {
 						cerr << "Error: too few aguments in message: '" << msg << "'" << endl;
 					}
-					if (tokens[0] == "PUTSTONE") {
-						if (tokens.size() >= 2) {
-							putstone_type = atoi(tokens[1].c_str());
-						}
+					if (tokens.Is("PUTSTONE")) {
+						tokens.Get(1, &putstone_type);
 					}
 				}
 				else {
@@ -325,6 +362,8 @@ namespace digital_curling
 
 			// Write dummy statements to logfile
 			std::stringstream sstream;
+			char position[Player::kBufferSize];
+			dcp::FormatPosition(gs_, position, sizeof(position));
 			for (int i = 0; i < 6; i++) {
 				// Clear sstream
 				sstream.str("");
@@ -334,17 +373,16 @@ namespace digital_curling
 				sstream << "[" << 
 					std::setfill('0') << std::setw(2) << gs_.CurEnd <<
 					std::setfill('0') << std::setw(2) << i << "]" << endl;
-				sstream << "POSITION=POSITION";
-				for (int i = 0; i < 16; i++) {
-					sstream << " " << gs_.body[i][0] << " " << gs_.body[i][1];
-				}
-				sstream << endl;
+				sstream << "POSITION=" << position << endl;
 				sstream << "SETSTATE=SETSTATE " << i << " " << gs_.CurEnd << " " << gs_.LastEnd << " " << gs_.WhiteToMove << endl;
 				sstream << "BESTSHOT=BESTSHOT 0 0 0" << endl;
 				sstream << "RUNSHOT=RUNSHOT 0 0 0";
 
 				// Write to logfile
 				log_file_.Write(sstream.str());
+				BinaryLogRecord record = MakeRecord(BinaryLogRecord::PLACED);
+				record.shot_num = i;
+				log_file_.WriteRecord(record);
 			}
 
 			// Set delivery order
@@ -374,34 +412,45 @@ namespace digital_curling
 			std::setfill('0') << std::setw(2) << gs_.ShotNum << "]";
 		log_file_.Write(sstream.str());
 
-		// Clear sstream
-		sstream.str("");
-		sstream.clear(std::stringstream::goodbit);
+		// Players which get the state directly (e.g. PluginPlayer) do not need messages
+		std::chrono::steady_clock::time_point sent = std::chrono::steady_clock::now();
+		bool direct1 = player1_->SetState(gs_);
+		if (direct1 && !player1_->Synchronous()) {
+			player1_->latency_.AddSend("STATE", std::chrono::steady_clock::now() - sent);
+		}
+		sent = std::chrono::steady_clock::now();
+		bool direct2 = (player1_ != player2_) ? player2_->SetState(gs_) : direct1;
+		if (direct2 && player1_ != player2_ && !player2_->Synchronous()) {
+			player2_->latency_.AddSend("STATE", std::chrono::steady_clock::now() - sent);
+		}
+
+		char msg[Player::kBufferSize];
 
 		// Send POSITION command ('POSITION body[0][0] body[0][1] body[1][0] body[1][1] ... body[15][0] body[15][0]')
-		sstream << "POSITION";
-		for (int i = 0; i < 16; i++) {
-			sstream << " " <<  gs_.body[i][0] << " " << gs_.body[i][1];
-		}
-		player1_->Send(sstream.str().c_str());
-		Sleep(100);  // wait for;
-		player2_->Send(sstream.str().c_str());
-		Sleep(100);  // wait for;
+		dcp::FormatPosition(gs_, msg, sizeof(msg));
+		if (!direct1) {
+			SendCommand(player1_, msg);
+			Wait(100);  // wait for;
+		}
+		if (!direct2) {
+			SendCommand(player2_, msg);
+			Wait(100);  // wait for;
+		}
 		// Write to logfile
-		log_file_.Write("POSITION=" + sstream.str());
-
-		// Clear sstream
-		sstream.str("");
-		sstream.clear(std::stringstream::goodbit);
+		log_file_.Write(std::string("POSITION=") + msg);
 
 		// Send SETSTATE command ('SETSTATE ShotNum CurEnd LastEnd WhiteToMove')
-		sstream << "SETSTATE " << gs_.ShotNum << " " << gs_.CurEnd << " " << gs_.LastEnd << " " << gs_.WhiteToMove;
-		player1_->Send(sstream.str().c_str());
-		Sleep(100);  // wait for;
-		player2_->Send(sstream.str().c_str());
-		Sleep(100);  // wait for;
+		dcp::FormatSetState(gs_, msg, sizeof(msg));
+		if (!direct1) {
+			SendCommand(player1_, msg);
+			Wait(100);  // wait for;
+		}
+		if (!direct2) {
+			SendCommand(player2_, msg);
+			Wait(100);  // wait for;
+		}
 		// Write to logfile
-		log_file_.Write("SETSTATE=" + sstream.str());
+		log_file_.Write(std::string("SETSTATE=") + msg);
 
 		return true;
 	}
@@ -413,71 +462,68 @@ namespace digital_curling
 			return ERR;
 		}
 		// Prepare "GO" command
-		std::stringstream sstream;
-		sstream << "GO " << player1_->time_remain_ << " " << player2_->time_remain_;
+		char go[Player::kBufferSize];
+		dcp::FormatGo(player1_->time_remain_, player2_->time_remain_, go, sizeof(go));
 		Player *next_player = (gs_.WhiteToMove == 0) ? player1_ : player2_;
 
-		// Prepare recieve thread
-		//char msg[digital_curling::Player::kBufferSize];
-		//next_player->Recv(msg);
 		char msg[Player::kBufferSize];
 
-		std::promise<std::string> p;
-		std::future<std::string> f = p.get_future();
-
-		std::thread th(RecvThread, std::move(p), next_player);
-
-		Sleep(100);
-
-		// Send "GO" command
-		time_t time_start = clock();
-		next_player->Send(sstream.str().c_str());
-
-		Sleep(100);  // wait for;
+		// Send "GO" command (wall time from here to arrival of reply is time used by player)
+		DiscardStale(next_player);
+		std::chrono::steady_clock::time_point time_start = std::chrono::steady_clock::now();
+		if (next_player->SendGo(player1_->time_remain_, player2_->time_remain_)) {
+			next_player->latency_.AddSend("GO", std::chrono::steady_clock::now() - time_start);
+		}
+		else {
+			time_start = SendCommand(next_player, go);
+		}
 
 		// Wait for message is ready
-		std::future_status result = f.wait_for(std::chrono::milliseconds(next_player->time_remain_ + 100));
-		th.join();
-
-		if (result != std::future_status::timeout) {
-			strcpy_s(msg, Player::kBufferSize, f.get().c_str());
-
+		unsigned int time_out = (next_player->time_remain_ > 0) ? next_player->time_remain_ : 0;
+		if (RecvReply(next_player, "GO", time_start, msg, time_out)) {
 			// Check timelimit
 			if (next_player->time_remain_ < Player::kTimeLimitInfinite) {
-				time_t time_used = clock() - time_start - 100;
+				// Round trip time of the transport is not counted as time used by player (measured by server, not with 'GO')
+				int64_t time_used = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - time_start).count();
+				time_used = (time_used + 500) / 1000 - next_player->RoundTrip();  // [msec]
+				if (time_used < 0) {
+					time_used = 0;
+				}
 				next_player->time_remain_ -= (int)time_used;
+
+				// Reply of a player which runs in the server (e.g. PluginPlayer) arrives even after time limit
+				if (next_player->time_remain_ < 0) {
+					cerr << "TimeOut" << endl;
+					log_file_.WriteRecord(MakeRecord(BinaryLogRecord::TIMEOUT));
+					return TIMEOUT;
+				}
 			}
 
 			// Split message as token
-			//char msg_tmp[digital_curling::Player::kBufferSize];
-			//std::char_traits<char>::copy(msg_tmp, msg.c_str(), msg.size() + 1);
-			std::vector<std::string> tokens;
-			tokens = digital_curling::SpritAsTokens(msg, " ");
-			if (tokens.size() == 0) {
+			dcp::Tokens tokens(msg);
+			if (tokens.Size() == 0) {
 				cerr << "Error: too few aguments in message: '" << msg << "'" << endl;
 				return ERR;
 			}
-			if (tokens[0] == "BESTSHOT") {
-				// Set best_shot_ if command is 'BESTSHOT'
-				if (tokens.size() < 4) {
-					cerr << "Error: too few aguments in message: '" << msg << "'" << endl;
+			if (tokens.Is("BESTSHOT")) {
+				// Set best_shot_ if command is 'BESTSHOT' (shot without arguments is delivered as ShotVec by plugin or frame)
+				bool parsed = (tokens.Size() == 1) ? next_player->TakeShot(&best_shot_) : dcp::ParseBestShot(tokens, &best_shot_);
+				if (!parsed) {
+					cerr << "Error: invalid aguments in message: '" << msg << "'" << endl;
 					return ERR;
 				}
-				best_shot_.x = (float)atof(tokens[1].c_str());
-				best_shot_.y = (float)atof(tokens[2].c_str());
-				best_shot_.angle = (bool)atoi(tokens[3].c_str());
 
 				// Write to logfile
-				std::stringstream sstream;
-				sstream << "BESTSHOT=BESTSHOT" << best_shot_.x << ' ' << best_shot_.y << ' ' << best_shot_.angle;
-				log_file_.Write(sstream.str());
+				dcp::FormatBestShot(best_shot_, msg, sizeof(msg));
+				log_file_.Write(std::string("BESTSHOT=") + msg);
 
 				return BESTSHOT;
 			}
-			else if (tokens[0] == "CONCEDE") {
+			else if (tokens.Is("CONCEDE")) {
 				// Jump to conseed and exit process if command is 'CONCEDE'
 				// TODO: jump to conseed and exit process
 				log_file_.Write("BESTSHOT=CONCEDE");
+				log_file_.WriteRecord(MakeRecord(BinaryLogRecord::CONCEDE));
 				cerr << "Concede" << endl;
 				return CONCEDE;
 			}
@@ -490,6 +536,7 @@ namespace digital_curling
 		else {
 				// TODO: jump to timeover and exit process
 				cerr << "TimeOut" << endl;
+				log_file_.WriteRecord(MakeRecord(BinaryLogRecord::TIMEOUT));
 				return TIMEOUT;
 		}
 
@@ -522,20 +569,48 @@ namespace digital_curling
 		cerr << "order = " << p->pinfo_.order[0] << " " << p->pinfo_.order[1] << " " << p->pinfo_.order[2] << " " << p->pinfo_.order[3] << endl;
 		cerr << "(rand1, rand2, shot_max) = ( " << rand_1 << ", " << rand_2 << ", " << shot_max << ")" << endl;
 
+		// Record of binary log (with the shot from player)
+		BinaryLogRecord record = MakeRecord(BinaryLogRecord::SHOT);
+		record.best_shot[0] = best_shot_.x;
+		record.best_shot[1] = best_shot_.y;
+		record.best_shot[2] = (float)best_shot_.angle;
+
 		// Check illegal shot
 		if (best_shot_.y > shot_max) {
 			best_shot_.x = 0.0f;
 			best_shot_.y = 0.0f;
 			best_shot_.angle = false;
 		}
-		sim->Simulation(&gs_, best_shot_, rand_1, rand_2, &run_shot_, nullptr, 0);
+		if (seeded_) {
+			// Noise for this end and shot is the same in every game with the same seed
+			float r1, r2;
+			SeededNoise(&r1, &r2);
+			ShotVec shot = best_shot_;
+			sim->AddNoise2Vec(r1 * rand_1, r2 * rand_2, &shot);
+			sim->Simulation(&gs_, shot, 0.0f, 0.0f, &run_shot_, nullptr, 0);
+		}
+		else {
+			sim->Simulation(&gs_, best_shot_, rand_1, rand_2, &run_shot_, nullptr, 0);
+		}
 
 		// Write to log file
 		std::stringstream sstream;
 		sstream << "PARAM=PARAM " << rand_1 << ' ' << rand_2 << ' ' << shot_max << endl;  // Parameters
-		sstream << "RUNSHOT=RUNSHOT " << run_shot_.x << ' ' << run_shot_.y << ' ' << run_shot_.angle;  // Runshot
+		char runshot[Player::kBufferSize];
+		dcp::Writer(runshot, sizeof(runshot)).Add("RUNSHOT=RUNSHOT").Add(run_shot_.x).Add(run_shot_.y).Add((run_shot_.angle) ? 1 : 0);
+		sstream << runshot;  // Runshot
 		log_file_.Write(sstream.str());
 
+		// Write to binary log
+		record.param[0] = rand_1;
+		record.param[1] = rand_2;
+		record.param[2] = shot_max;
+		record.run_shot[0] = run_shot_.x;
+		record.run_shot[1] = run_shot_.y;
+		record.run_shot[2] = (float)run_shot_.angle;
+		memcpy(record.after, gs_.body, sizeof(record.after));
+		log_file_.WriteRecord(record);
+
 		return true;
 	}
 
@@ -551,10 +626,9 @@ namespace digital_curling
 		sstream << "[" <<
 			std::setfill('0') << std::setw(2) << gs_.CurEnd <<
 			std::setfill('0') << std::setw(2) << gs_.ShotNum << "]" << endl;
-		sstream << "POSITION=POSITION";
-		for (int i = 0; i < 16; i++) {
-			sstream << " " << gs_.body[i][0] << " " << gs_.body[i][1];
-		}
+		char position[Player::kBufferSize];
+		dcp::FormatPosition(gs_, position, sizeof(position));
+		sstream << "POSITION=" << position;
 		log_file_.Write(sstream.str());
 
 		// Clear sstream
@@ -563,12 +637,16 @@ namespace digital_curling
 
 		// Sned "SCORE" command
 		sstream << "SCORE " << gs_.Score[gs_.CurEnd];
-		player1_->Send(sstream.str().c_str());
+		SendCommand(player1_, sstream.str().c_str());
 		if (player1_ != player2_) {
-			player2_->Send(sstream.str().c_str());
+			SendCommand(player2_, sstream.str().c_str());
 		}
 		// Write to logfile
 		log_file_.Write("SCORE=" + sstream.str());
+		BinaryLogRecord record = MakeRecord(BinaryLogRecord::SCORE);
+		record.value[0] = gs_.Score[gs_.CurEnd];
+		log_file_.WriteRecord(record);
+		log_file_.Flush(false);  // end of End
 
 		// Crear board of gs_
 		gs_.Clear();
@@ -577,7 +655,7 @@ namespace digital_curling
 		return true;
 	}
 
-	bool GameProcess::Exit() {
+	bool GameProcess::Exit(int end_state) {
 		if (player1_ == nullptr || player2_ == nullptr) {
 			return false;
 		}
@@ -596,9 +674,17 @@ namespace digital_curling
 		// Send "GAMEOVER" to each player
 		Player *p_won = nullptr;
 		Player *p_lost = nullptr;
-		if (score_p1 == score_p2) {
-			player1_->Send("GAMEOVER DRAW");
-			player2_->Send("GAMEOVER DRAW");
+		bool forfeit = (end_state == CONCEDE || end_state == TIMEOUT);
+		if (forfeit) {
+			// Player to move conceded or timed out
+			p_lost = (gs_.WhiteToMove == 0) ? player1_ : player2_;
+			p_won = (gs_.WhiteToMove == 0) ? player2_ : player1_;
+			SendCommand(p_won, "GAMEOVER WIN");
+			SendCommand(p_lost, "GAMEOVER LOSE");
+		}
+		else if (score_p1 == score_p2) {
+			SendCommand(player1_, "GAMEOVER DRAW");
+			SendCommand(player2_, "GAMEOVER DRAW");
 		}
 		else {
 			if (score_p1 > score_p2) {
@@ -609,14 +695,14 @@ namespace digital_curling
 				p_won = player2_;
 				p_lost = player1_;
 			}
-			p_won->Send("GAMEOVER WIN");
-			p_lost->Send("GAMEOVER LOSE");
+			SendCommand(p_won, "GAMEOVER WIN");
+			SendCommand(p_lost, "GAMEOVER LOSE");
 		}
 
 		// Write to log file
 		std::stringstream sstream;
 		sstream << "[GameOverInfo]" << endl;
-		sstream << "ENDSTATE=" << "NORMAL" << endl;
+		sstream << "ENDSTATE=" << ((end_state == CONCEDE) ? "CONCEDE" : (end_state == TIMEOUT) ? "TIMEOUT" : "NORMAL") << endl;
 
 		if (p_won != nullptr && p_lost != nullptr) {
 			sstream << "WIN=" << p_won->name_ << endl;
@@ -630,19 +716,13 @@ namespace digital_curling
 		sstream << "TOTALSCORE=TOTALSCORE " << score_p1 << " " << score_p2 << endl;
 
 		log_file_.Write(sstream.str());
+		BinaryLogRecord record = MakeRecord(BinaryLogRecord::GAMEOVER);
+		record.value[0] = score_p1;
+		record.value[1] = score_p2;
+		record.value[2] = (end_state == CONCEDE) ? BinaryLogRecord::CONCEDE : (end_state == TIMEOUT) ? BinaryLogRecord::TIMEOUT : 0;
+		log_file_.WriteRecord(record);
+		log_file_.Flush(true);  // end of game
 
 		return true;
 	}
-
-	// Split message as tokens (message will be destroyed)
-	std::vector<std::string> SpritAsTokens(char *message, const char* const delim) {
-		std::vector<std::string> tokens;
-		char *ctx;
-		char *token = strtok_s(message, delim, &ctx);
-		while (token != nullptr) {
-			tokens.push_back(token);
-			token = strtok_s(nullptr, delim, &ctx);
-		}
-		return tokens;
-	}
 }
\ No newline at end of file
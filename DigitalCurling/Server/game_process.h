@@ -1,7 +1,10 @@
 #pragma once
 
+#ifdef _WIN32
 #include <Windows.h>
+#endif
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -59,7 +62,8 @@ namespace digital_curling
 		bool SendScore();
 
 		// Exit game process
-		bool Exit();
+		// end_state : BESTSHOT (normal end), CONCEDE or TIMEOUT (player to move loses)
+		bool Exit(int end_state = BESTSHOT);
 
 		b2simulator::Simulator *sim;  // Simulator
 
@@ -76,8 +80,19 @@ namespace digital_curling
 
 		unsigned int repetition_;  // times repeat
 		bool extended_end_;     // do extended end if draw
-	};
+		bool headless_;         // do not wait between messages (fast match)
+		bool binary_dcp_;       // offer binary DCP to players with 'ISREADY BIN1'
+		bool seeded_;           // noise of shots is drawn from seed_ (otherwise from random_device)
+		uint64_t seed_;         // seed of noise of shots (same seed: same noise for each end and shot)
+
+	private:
+		// Wait for player to process message (skipped if headless_)
+		void Wait(unsigned int msec) const;
 
-	// Split message as tokens
-	std::vector<std::string> SpritAsTokens(char *message, const char* const delim);
+		// Record of binary log with current state of the game
+		BinaryLogRecord MakeRecord(uint32_t type) const;
+
+		// Noise of shot drawn from seed_ for current end and shot (r1, r2 ~ N(0, 1))
+		void SeededNoise(float *r1, float *r2) const;
+	};
 }
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include "latency_stats.h"
+
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+
+namespace digital_curling {
+
+	LatencyHistogram::LatencyHistogram() : count_(0), sum_(0), max_(0) {
+		memset(buckets_, 0, sizeof(buckets_));
+	}
+
+	// Add a latency
+	void LatencyHistogram::Add(std::chrono::steady_clock::duration latency) {
+		int64_t usec = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+		if (usec < 0) {
+			usec = 0;
+		}
+
+		// Index of bucket is number of bits of usec
+		int i = 0;
+		while (i < kBuckets - 1 && (usec >> i) != 0) {
+			i++;
+		}
+		buckets_[i]++;
+
+		count_++;
+		sum_ += usec;
+		if (usec > max_) {
+			max_ = usec;
+		}
+	}
+
+	// Add all latencies of other histogram
+	void LatencyHistogram::Merge(const LatencyHistogram &other) {
+		for (int i = 0; i < kBuckets; i++) {
+			buckets_[i] += other.buckets_[i];
+		}
+		count_ += other.count_;
+		sum_ += other.sum_;
+		if (other.max_ > max_) {
+			max_ = other.max_;
+		}
+	}
+
+	uint64_t LatencyHistogram::Count() const {
+		return count_;
+	}
+
+	int64_t LatencyHistogram::Mean() const {
+		return (count_ > 0) ? sum_ / (int64_t)count_ : 0;
+	}
+
+	int64_t LatencyHistogram::Max() const {
+		return max_;
+	}
+
+	// Upper bound of the bucket which contains p-th percentile
+	int64_t LatencyHistogram::Percentile(double p) const {
+		if (count_ == 0) {
+			return 0;
+		}
+		uint64_t rank = (uint64_t)std::ceil(p / 100.0 * (double)count_);
+		if (rank == 0) {
+			rank = 1;
+		}
+
+		uint64_t n = 0;
+		for (int i = 0; i < kBuckets; i++) {
+			n += buckets_[i];
+			if (n >= rank) {
+				int64_t upper = (int64_t)1 << i;
+				return (upper < max_) ? upper : max_;
+			}
+		}
+		return max_;
+	}
+
+	void LatencyStats::AddSend(std::string_view command, std::chrono::steady_clock::duration latency) {
+		if (!command.empty()) {
+			At(command).send.Add(latency);
+		}
+	}
+
+	void LatencyStats::AddReply(std::string_view command, std::chrono::steady_clock::duration latency) {
+		if (!command.empty()) {
+			At(command).reply.Add(latency);
+		}
+	}
+
+	// Add all latencies of other
+	void LatencyStats::Merge(const LatencyStats &other) {
+		for (const std::pair<const std::string, Entry> &command : other.commands_) {
+			Entry &entry = At(command.first);
+			entry.send.Merge(command.second.send);
+			entry.reply.Merge(command.second.reply);
+		}
+	}
+
+	// Entry of command
+	LatencyStats::Entry& LatencyStats::At(std::string_view command) {
+		std::map<std::string, Entry, std::less<>>::iterator it = commands_.find(command);
+		if (it == commands_.end()) {
+			it = commands_.emplace(std::string(command), Entry()).first;
+		}
+		return it->second;
+	}
+
+	// Print table of latencies
+	void LatencyStats::Print(std::ostream &os, const std::string &name) const {
+		os << "latency of " << name << " [usec]" << std::endl;
+		os << "  " << std::left << std::setw(10) << "command" << std::setw(7) << "" << std::right
+			<< std::setw(8) << "count" << std::setw(10) << "mean" << std::setw(10) << "p50"
+			<< std::setw(10) << "p99" << std::setw(10) << "max" << std::endl;
+
+		for (const std::pair<const std::string, Entry> &command : commands_) {
+			const LatencyHistogram *histograms[2] = { &command.second.send, &command.second.reply };
+			const char *labels[2] = { "send", "reply" };
+			for (int i = 0; i < 2; i++) {
+				const LatencyHistogram &h = *histograms[i];
+				if (h.Count() == 0) {
+					continue;
+				}
+				os << "  " << std::left << std::setw(10) << command.first << std::setw(7) << labels[i] << std::right
+					<< std::setw(8) << h.Count() << std::setw(10) << h.Mean() << std::setw(10) << h.Percentile(50)
+					<< std::setw(10) << h.Percentile(99) << std::setw(10) << h.Max() << std::endl;
+			}
+		}
+	}
+
+	// Clear all latencies
+	void LatencyStats::Clear() {
+		commands_.clear();
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace digital_curling {
+
+	// Histogram of latencies
+	// Bucket i counts latencies in [2^(i-1), 2^i) usec (bucket 0: less than 1 usec)
+	class LatencyHistogram {
+	public:
+		static const int kBuckets = 40;
+
+		LatencyHistogram();
+
+		// Add a latency
+		void Add(std::chrono::steady_clock::duration latency);
+		// Add all latencies of other histogram
+		void Merge(const LatencyHistogram &other);
+
+		// Number of latencies
+		uint64_t Count() const;
+		// Mean and maximum [usec]
+		int64_t Mean() const;
+		int64_t Max() const;
+		// Upper bound of the bucket which contains p-th percentile (0 < p <= 100) [usec]
+		int64_t Percentile(double p) const;
+
+	private:
+		uint64_t buckets_[kBuckets];
+		uint64_t count_;
+		int64_t  sum_;
+		int64_t  max_;
+	};
+
+	// Latencies of DCP commands of a player
+	//   send : time to send a command (transport)
+	//   reply: time from sending a command to receiving its reply (transport and AI)
+	class LatencyStats {
+	public:
+		// Add latency of command (the first token of message)
+		void AddSend(std::string_view command, std::chrono::steady_clock::duration latency);
+		void AddReply(std::string_view command, std::chrono::steady_clock::duration latency);
+
+		// Add all latencies of other (e.g. of the same player in another game)
+		void Merge(const LatencyStats &other);
+
+		// Print table of latencies of each command
+		void Print(std::ostream &os, const std::string &name) const;
+		// Clear all latencies (e.g. for next match)
+		void Clear();
+
+	private:
+		struct Entry {
+			LatencyHistogram send;
+			LatencyHistogram reply;
+		};
+		// Entry of command (created if not exists)
+		Entry& At(std::string_view command);
+
+		std::map<std::string, Entry, std::less<>> commands_;
+	};
+}
@@ -0,0 +1,181 @@
+#include "log_replay.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include "game_log_binary.h"
+
+using std::cout;
+using std::cerr;
+using std::endl;
+
+namespace digital_curling {
+
+	ReplayOptions::ReplayOptions() :
+		friction(12.009216f),  // friction_default of config.json
+		freeguard_num(5),
+		tolerance(-1.0f),  // 0 for .dcb, kTextLogTolerance for .dcl
+		output_trajectory(false),
+		trajectory_interval(1),
+		workers(0) {}
+
+	ReplayResult::ReplayResult() :
+		loaded(false),
+		shots(0),
+		max_error(0.0f) {}
+
+	// Replay shots of a log
+	ReplayResult ReplayLog(const std::string &path, const ReplayOptions &options, b2simulator::Simulator &sim) {
+		ReplayResult result;
+		result.path = path;
+
+		BinaryLogHeader header;
+		std::vector<BinaryLogRecord> records;
+		result.loaded = ReadLog(path, header, records);
+		if (!result.loaded) {
+			return result;
+		}
+
+		// Trajectories are written to csv of the same name, '[EESS]' before lines of each shot
+		std::ofstream ofs;
+		if (options.output_trajectory) {
+			ofs.open(path.substr(0, path.size() - LogExtension(path).size()) + ".csv");
+			if (!ofs.is_open()) {
+				cerr << "failed to create trajectory of " << path << endl;
+			}
+		}
+		b2simulator::StreamTrajectorySink sink(ofs, options.trajectory_interval);
+
+		// Positions of .dcb are exact, .dcl may have less digits than float
+		float tolerance = options.tolerance;
+		if (tolerance < 0.0f) {
+			tolerance = (LogExtension(path) == ".dcb") ? 0.0f : kTextLogTolerance;
+		}
+
+		// Rule of the game (freeguard rule of the server)
+		sim.num_freeguard_ = options.freeguard_num;
+		sim.area_freeguard_ = b2simulator::IN_FREEGUARD;
+
+		for (size_t i = 0; i < records.size(); i++) {
+			const BinaryLogRecord &record = records[i];
+			if (record.type == BinaryLogRecord::GAMEINFO && record.value[0] == 1) {
+				// Mix doubles
+				sim.num_freeguard_ = 9;
+				sim.area_freeguard_ = b2simulator::IN_PLAYAREA;
+			}
+			if (record.type != BinaryLogRecord::SHOT) {
+				continue;
+			}
+
+			GameState gs(record.last_end);
+			gs.ShotNum = record.shot_num;
+			gs.CurEnd = record.cur_end;
+			gs.WhiteToMove = (record.white_to_move != 0);
+			memcpy(gs.body, record.before, sizeof(gs.body));
+
+			// Shot with noise of the log (no more noise is added)
+			ShotVec run_shot(record.run_shot[0], record.run_shot[1], record.run_shot[2] != 0.0f);
+			if (ofs.is_open()) {
+				ofs << "[" << std::setfill('0') << std::setw(2) << record.cur_end <<
+					std::setfill('0') << std::setw(2) << record.shot_num << "]" << std::setfill(' ') << "\n";
+			}
+			sim.Simulation(&gs, run_shot, 0.0f, 0.0f, nullptr, (ofs.is_open()) ? &sink : nullptr);
+			result.shots++;
+
+			// Compare positions with the log
+			float error = 0.0f;
+			int stone = 0;
+			for (int k = 0; k < 16; k++) {
+				float e = std::max(std::fabs(gs.body[k][0] - record.after[k][0]), std::fabs(gs.body[k][1] - record.after[k][1]));
+				if (e > error) {
+					error = e;
+					stone = k;
+				}
+			}
+			result.max_error = std::max(result.max_error, error);
+			if (error > tolerance) {
+				std::ostringstream sstream;
+				sstream << "[" << std::setfill('0') << std::setw(2) << record.cur_end <<
+					std::setfill('0') << std::setw(2) << record.shot_num << "] stone " << stone <<
+					std::setfill(' ') << ": (" << gs.body[stone][0] << ", " << gs.body[stone][1] << ") in replay, (" <<
+					record.after[stone][0] << ", " << record.after[stone][1] << ") in log";
+				result.divergences.push_back(sstream.str());
+			}
+		}
+
+		return result;
+	}
+
+	// Replay logs in parallel
+	bool ReplayLogs(const std::vector<std::string> &paths, const ReplayOptions &options) {
+		// List up logs
+		std::vector<std::string> logs = ListLogs(paths);
+		if (logs.empty()) {
+			cerr << "no logs to replay." << endl;
+			return false;
+		}
+
+		unsigned int num_workers = (options.workers > 0) ? options.workers : std::max(1u, std::thread::hardware_concurrency());
+		num_workers = std::min(num_workers, (unsigned int)logs.size());
+		cout << "> replay " << logs.size() << " logs with " << num_workers << " workers." << endl;
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		std::atomic<size_t> next_log(0);
+		std::mutex mtx;  // for results below
+		size_t num_failed = 0;
+		size_t num_diverged = 0;
+		size_t num_shots = 0;
+		float max_error = 0.0f;
+
+		auto worker = [&]() {
+			// Simulator of each worker (initialization of tables takes time)
+			b2simulator::Simulator sim(options.friction);
+			size_t i;
+			while ((i = next_log++) < logs.size()) {
+				ReplayResult result = ReplayLog(logs[i], options, sim);
+
+				std::lock_guard<std::mutex> lock(mtx);
+				if (!result.loaded) {
+					num_failed++;
+					cout << "> failed to read '" << result.path << "'." << endl;
+					continue;
+				}
+				num_shots += result.shots;
+				max_error = std::max(max_error, result.max_error);
+				if (!result.divergences.empty()) {
+					num_diverged++;
+					cout << "> '" << result.path << "' diverged in " << result.divergences.size() << " shots:" << endl;
+					for (const std::string &divergence : result.divergences) {
+						cout << ">   " << divergence << endl;
+					}
+				}
+			}
+		};
+
+		std::vector<std::thread> workers;
+		for (unsigned int i = 0; i < num_workers; i++) {
+			workers.push_back(std::thread(worker));
+		}
+		for (unsigned int i = 0; i < num_workers; i++) {
+			workers[i].join();
+		}
+
+		double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		cout << "> replayed " << num_shots << " shots of " << logs.size() - num_failed << " logs in " << sec << " sec, " <<
+			num_diverged << " logs diverged (max error " << max_error << ")." << endl;
+		if (num_failed > 0) {
+			cout << "> " << num_failed << " logs could not be read." << endl;
+		}
+
+		return num_failed == 0 && num_diverged == 0;
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "dcurling_simulator.h"
+
+namespace digital_curling {
+
+	// Tolerance of positions in .dcl (error of shots rounded to 6 significant digits by older servers is less than 1 mm)
+	const float kTextLogTolerance = 1e-3f;
+
+	// Options of replay of logs
+	struct ReplayOptions {
+		float friction;                    // friction of simulator (same as the server)
+		unsigned int freeguard_num;        // number of shots of freeguard rule (normal rule)
+		float tolerance;                   // maximum difference of positions regarded as the same [m] (negative: by format of log)
+		bool output_trajectory;            // write trajectories of shots to FILE.csv
+		unsigned int trajectory_interval;  // interval of steps of trajectories
+		unsigned int workers;              // number of logs replayed at the same time (0: number of cores)
+
+		ReplayOptions();
+	};
+
+	// Result of replay of a log
+	struct ReplayResult {
+		std::string path;                  // path of the log
+		bool loaded;                       // false if the log could not be read
+		unsigned int shots;                // number of shots replayed
+		float max_error;                   // maximum difference from positions of the log [m]
+		std::vector<std::string> divergences;  // description of each shot which diverged
+
+		ReplayResult();
+	};
+
+	// Replay shots of a log (.dcl or .dcb)
+	// Each shot is simulated from the position of the log with RUNSHOT (the shot with noise) and without noise,
+	// and positions after it are compared with the log
+	ReplayResult ReplayLog(const std::string &path, const ReplayOptions &options, b2simulator::Simulator &sim);
+
+	// Replay logs in parallel (directories are replaced with logs in them) and print divergences and summary
+	// This function returns false if a log was not read or diverged
+	bool ReplayLogs(const std::vector<std::string> &paths, const ReplayOptions &options);
+}
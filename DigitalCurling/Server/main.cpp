@@ -1,22 +1,35 @@
+#ifdef _WIN32
 #include <windows.h>
+#endif
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <map>
+#include <mutex>
+#include <random>
 #include <string>
 #include <sstream>
 #include <thread>
+#include <utility>
 #include <vector>
 
 #include "lib/picojson.h"
 #include "game_process.h"
+#include "log_replay.h"
 
+#ifdef _MSC_VER
 #ifdef _DEBUG
 #pragma comment( lib, "../x64/Debug/Simulator.lib" )
 #endif
 #ifndef _DEBUG
 #pragma comment( lib, "../x64/Release/Simulator.lib" )
 #endif
+#endif
 
 using std::cout;
 using std::cerr;
@@ -33,10 +46,16 @@ namespace digital_curling {
 			int timeout_preend;      // timeout for "PUTSTONE" command
 			int timeout_setorder;    // timeout for "SETORDER" command
 			bool output_dcl;         // output log (.dcl) or not
-			bool output_json;        // output log (.json) *not implemented
+			bool output_json;        // output JSON log (.jsonl) or not
+			bool output_binary;      // output binary log (.dcb) or not
 			bool output_server_log;  // output server log *notimplemented
+			size_t log_buffer_size;  // maximum size of buffer of log [byte]
+			GameLog::Backpressure log_backpressure;  // what to do when buffer of log is full
 
 			int view_board_delay;    // interval for display board [msec]
+			bool headless;           // run without board view and waits (fast match)
+			bool binary_dcp;         // offer binary DCP to players
+			bool quiet;              // do not print progress of each shot (used by tournament)
 		};
 
 		// Print score board on console
@@ -179,16 +198,43 @@ namespace digital_curling {
 				pinfo.params[i].shot_max = pinfo.params[0].shot_max;
 			}
 
-			// Initialize player as LocalPlayer
-			Player *p = new LocalPlayer(
-				obj["path"].get<string>(),
-				(int)obj["timelimit"].get<double>(),
-				pinfo);
+			// Initialize player as LocalPlayer ("type": "local", default), PluginPlayer ("type": "plugin")
+			// or NetworkPlayer ("type": "network")
+			std::string type = (obj["type"].is<string>()) ? obj["type"].get<string>() : "local";
+			Player *p = nullptr;
+			if (type == "network") {
+				p = new NetworkPlayer(
+					(obj["host"].is<string>()) ? obj["host"].get<string>() : "127.0.0.1",
+					(int)obj["port"].get<double>(),
+					(int)obj["timelimit"].get<double>(),
+					pinfo);
+			}
+			else if (type == "plugin") {
+				p = new PluginPlayer(
+					obj["path"].get<string>(),
+					(int)obj["timelimit"].get<double>(),
+					pinfo);
+			}
+			else if (type == "local") {
+				p = new LocalPlayer(
+					obj["path"].get<string>(),
+					(int)obj["timelimit"].get<double>(),
+					pinfo);
+			}
+			else {
+				cerr << "invalid type of player '" << type << "'" << endl;
+				return 0;
+			}
 			if (p->InitProcess() == 0) {
 				cerr << "failed to create process for player" << endl;
+				delete p;
 				return 0;
 			}
 			p->mix_doubles = obj["md"].get<bool>();
+			// Name of player (default is name of .exe file)
+			if (obj["name"].is<string>()) {
+				p->name_ = obj["name"].get<string>();
+			}
 
 			/*  for debug
 			for (int i = 0; i < 4; i++) {
@@ -200,28 +246,52 @@ namespace digital_curling {
 			return p;
 		}
 
-		// Load config and initialize game process
-		GameProcess* Init(std::string config_path, std::string match_name, Options &options) {
+		// Load config file via picojson
+		bool LoadConfig(std::string config_path, picojson::object &obj_config) {
 			std::ifstream config_file(config_path);
 			if (!config_file.is_open()) {
 				cerr << "failed to open " << config_path << endl;
-				return 0;
+				return false;
 			}
 
 			// Perse json via picojson
 			picojson::value val;
 			config_file >> val;
 			config_file.close();
+			if (!val.is<picojson::object>()) {
+				cerr << "failed to perse " << config_path << ": " << picojson::get_last_error() << endl;
+				return false;
+			}
+			obj_config = val.get<picojson::object>();
 
-			// Get objects
-			picojson::object obj_server = val.get<picojson::object>()["server"].get<picojson::object>();  // Simulator
-			picojson::object obj_sim = val.get<picojson::object>()["simulator"].get<picojson::object>();  // Server
+			return true;
+		}
 
-			if (!val.get<picojson::object>()[match_name].is<picojson::object>()) {
-				cerr << "failed to find match '" << match_name << "' in " << config_path << "." << endl;
-				return 0;
+		// Get 'seed' of a match, a number or a string of decimal digits (exact for 64 bits)
+		// This function returns false if the match has no seed
+		bool GetSeed(const picojson::object &obj_match, uint64_t &seed) {
+			picojson::object::const_iterator it = obj_match.find("seed");
+			if (it == obj_match.end()) {
+				return false;
+			}
+			if (it->second.is<double>()) {
+				seed = (uint64_t)it->second.get<double>();
+				return true;
+			}
+			if (it->second.is<string>()) {
+				seed = std::strtoull(it->second.get<string>().c_str(), nullptr, 10);
+				return true;
 			}
-			picojson::object obj_match = val.get<picojson::object>()[match_name].get<picojson::object>();  // Match
+			return false;
+		}
+
+		// Set 'seed' of a match as a string (a double loses bits over 2^53)
+		void SetSeed(picojson::object &obj_match, uint64_t seed) {
+			obj_match["seed"] = picojson::value(std::to_string(seed));
+		}
+
+		// Initialize game process from objects of config
+		GameProcess* InitGameProcess(picojson::object obj_server, picojson::object obj_sim, picojson::object obj_match, Options &options) {
 			picojson::object obj_p1 = obj_match["player_1"].get<picojson::object>();  // player 1
 			picojson::object obj_p2 = obj_match["player_2"].get<picojson::object>();  // player 2
 
@@ -233,13 +303,25 @@ namespace digital_curling {
 			digital_curling::Player *p2;
 			p2 = SetPlayer(obj_p2);
 
+			if (p1 == nullptr || p2 == nullptr) {
+				delete p1;
+				delete p2;
+				return 0;
+			}
+
 			// Get server parameters
 			options.timeout_isready = (int)obj_server["timeout_isready"].get<double>();
 			options.timeout_preend = (int)obj_server["timeout_preend"].get<double>();
 			options.output_dcl = obj_server["output_dcl"].get<bool>();
 			options.output_json = obj_server["output_json"].get<bool>();
+			options.output_binary = obj_server["output_binary"].is<bool>() ? obj_server["output_binary"].get<bool>() : false;
 			options.output_server_log = obj_server["output_server_log"].get<bool>();
 			options.view_board_delay = (int)obj_server["view_board_delay"].get<double>();
+			options.headless = obj_server["headless"].is<bool>() ? obj_server["headless"].get<bool>() : false;
+			options.binary_dcp = obj_server["binary_dcp"].is<bool>() ? obj_server["binary_dcp"].get<bool>() : false;
+			options.quiet = false;
+			options.log_buffer_size = obj_server["log_buffer_size"].is<double>() ? (size_t)obj_server["log_buffer_size"].get<double>() : GameLog::kMaxBufferSize;
+			options.log_backpressure = (obj_server["log_backpressure"].is<string>() && obj_server["log_backpressure"].get<string>() == "write_through") ? GameLog::WRITE_THROUGH : GameLog::BLOCK;
 
 			// Get simulator parameters
 			SimulatorParams sim_params;
@@ -258,7 +340,7 @@ namespace digital_curling {
 				rule_type = 1;
 			}
 			else {
-				cerr << "invalid rule_type from " << config_path << ", set rule_type_ = 0" << endl;
+				cerr << "invalid rule_type '" << str << "', set rule_type_ = 0" << endl;
 				rule_type = 0;
 			}
 
@@ -275,10 +357,49 @@ namespace digital_curling {
 				extended_end,
 				sim_params
 			);
+			game_process->headless_ = options.headless;
+			game_process->binary_dcp_ = options.binary_dcp;
+			if (GetSeed(obj_match, game_process->seed_)) {
+				// Noise of shots is reproduced with seed
+				game_process->seeded_ = true;
+			}
+			game_process->log_file_.SetBuffer(options.log_buffer_size, options.log_backpressure);
+			game_process->log_file_.SetBinary(options.output_binary);
+			game_process->log_file_.SetJson(options.output_json);
 
 			return game_process;
 		}
 
+		// Load config and initialize game process
+		GameProcess* Init(std::string config_path, std::string match_name, Options &options) {
+			picojson::object obj_config;
+			if (!LoadConfig(config_path, obj_config)) {
+				return 0;
+			}
+
+			// Get objects
+			picojson::object obj_server = obj_config["server"].get<picojson::object>();  // Server
+			picojson::object obj_sim = obj_config["simulator"].get<picojson::object>();  // Simulator
+
+			if (!obj_config[match_name].is<picojson::object>()) {
+				cerr << "failed to find match '" << match_name << "' in " << config_path << "." << endl;
+				return 0;
+			}
+			picojson::object obj_match = obj_config[match_name].get<picojson::object>();  // Match
+
+			return InitGameProcess(obj_server, obj_sim, obj_match, options);
+		}
+
+		// Release game process and players created by Init()
+		void Release(GameProcess *gp) {
+			if (gp == nullptr) {
+				return;
+			}
+			delete gp->player1_;
+			delete gp->player2_;
+			delete gp;
+		}
+
 		// Run a match
 		int RunMatch(GameProcess &game_process, Options opt) {
 			// Send "NEWGAME" to players
@@ -288,30 +409,40 @@ namespace digital_curling {
 			while (game_process.gs_.CurEnd < game_process.gs_.LastEnd) {
 
 				// Prepare for End
-				cerr << "Preparing for end..." << endl;
+				if (!opt.quiet) {
+					cerr << "Preparing for end..." << endl;
+				}
 				game_process.PrepareEnd(opt.timeout_preend);
 
 				//do {
 				while (game_process.gs_.ShotNum < 16) {
 					// Send "SETSTATE" and "POSITION" to players
 					game_process.SendState();
-					Sleep(50);  // wait for
-					cerr << "==========================================" << endl;
-					PrintState(&game_process);
-					PrintBoard(&game_process.gs_);
-					PrintScoreBoard(&game_process);
-					cerr << "==========================================" << endl;
-					Sleep(opt.view_board_delay + 50);  // wait for
+					if (!opt.headless) {
+						std::this_thread::sleep_for(std::chrono::milliseconds(50));  // wait for
+						cerr << "==========================================" << endl;
+						PrintState(&game_process);
+						PrintBoard(&game_process.gs_);
+						PrintScoreBoard(&game_process);
+						cerr << "==========================================" << endl;
+						std::this_thread::sleep_for(std::chrono::milliseconds(opt.view_board_delay + 50));  // wait for
+					}
 
 								// Send "GO" to player
 					status = game_process.Go();
 					if (status != GameProcess::BESTSHOT) {
 						cerr << "status = " << status << endl;
+						if (status == GameProcess::CONCEDE || status == GameProcess::TIMEOUT) {
+							// Game is over by player to move
+							game_process.Exit(status);
+						}
 						return status;
 					}
-					cerr << "BESTSHOT: (" <<
-						game_process.best_shot_.x << ", " << game_process.best_shot_.y << ", " <<
-						game_process.best_shot_.angle << ")" << endl;
+					if (!opt.quiet) {
+						cerr << "BESTSHOT: (" <<
+							game_process.best_shot_.x << ", " << game_process.best_shot_.y << ", " <<
+							game_process.best_shot_.angle << ")" << endl;
+					}
 
 					// Simulation
 					game_process.RunSimulation();
@@ -319,21 +450,35 @@ namespace digital_curling {
 
 				// Send 'SCORE' to players
 				game_process.SendScore();
-				Sleep(50);  // wait for
-				cerr << "==========================================" << endl;
-				PrintBoard(&game_process.gs_);
-				PrintScoreBoard(&game_process);
-				cerr << "==========================================" << endl;
-				Sleep(50);  // wait for
+				if (!opt.headless) {
+					std::this_thread::sleep_for(std::chrono::milliseconds(50));  // wait for
+					cerr << "==========================================" << endl;
+					PrintBoard(&game_process.gs_);
+					PrintScoreBoard(&game_process);
+					cerr << "==========================================" << endl;
+					std::this_thread::sleep_for(std::chrono::milliseconds(50));  // wait for
+				}
 			}
 
 			// Exit Game
 			game_process.Exit();
-			cerr << "game_end" << endl;
+			if (!opt.quiet) {
+				cerr << "game_end" << endl;
+			}
 
 			return status;
 		}
 
+		// Print latencies of DCP commands of each player and clear them for next match
+		void PrintLatency(GameProcess &game_process) {
+			game_process.player1_->latency_.Print(cerr, game_process.player1_->name_);
+			game_process.player1_->latency_.Clear();
+			if (game_process.player2_ != game_process.player1_) {
+				game_process.player2_->latency_.Print(cerr, game_process.player2_->name_);
+				game_process.player2_->latency_.Clear();
+			}
+		}
+
 		// Simple game server for DigitalCurling
 		int SimpleServer(std::string match_name) {
 
@@ -342,15 +487,24 @@ namespace digital_curling {
 			Options opt;
 			
 			GameProcess *gp = Init(config_path, match_name, opt);
-			GameProcess game_process = *gp;
+			if (gp == nullptr) {
+				return 0;
+			}
+			GameProcess &game_process = *gp;
 
 			// Send "ISREADY" to both players
 			if (!game_process.IsReady(game_process.player1_, opt.timeout_isready)) {
 				cerr << "failed to recieve ISREADY from player 1" << endl;
+				game_process.player1_->ExitProcess();
+				game_process.player2_->ExitProcess();
+				Release(gp);
 				return 0;
 			}
 			if (!game_process.IsReady(game_process.player2_, opt.timeout_isready)) {
 				cerr << "failed to recieve ISREADY from player 2" << endl;
+				game_process.player1_->ExitProcess();
+				game_process.player2_->ExitProcess();
+				Release(gp);
 				return 0;
 			}
 
@@ -361,23 +515,302 @@ namespace digital_curling {
 					game_process.log_file_.Create(game_process.player1_, game_process.player2_);
 					// Reset GameState
 					game_process.gs_.ClearAll();
+					// Next seed for next game
+					game_process.seed_++;
 				}
 
 				// Run a match
 				RunMatch(game_process, opt);
+				PrintLatency(game_process);
 			}
 
 			// Exit Player Process
+			int ret = 1;
 			if (game_process.player1_->ExitProcess() == 0) {
 				cerr << "failed to player1_->ExitProcess()" << endl;
-				return  0;
+				ret = 0;
 			}
 			
 			if (game_process.player2_->ExitProcess() == 0) {
 				cerr << "failed to player2_->ExitProcess()" << endl;
+				ret = 0;
+			}
+
+			Release(gp);
+
+			return ret;
+		}
+
+		// Standing of a player in tournament
+		struct Standing {
+			int games;           // number of games finished
+			int wins;            // number of wins
+			int losses;          // number of losses
+			int draws;           // number of draws
+			int points_for;      // total score
+			int points_against;  // total score of opponents
+			int forfeits;        // number of losses by 'CONCEDE' or time out (included in losses)
+
+			Standing() : games(0), wins(0), losses(0), draws(0), points_for(0), points_against(0), forfeits(0) {}
+		};
+
+		// Play a game of tournament on a new game process
+		// - score1, score2 : scores of ends played (also of a game ended by 'CONCEDE' or time out)
+		// - end_state      : GameProcess::BESTSHOT (normal end), GameProcess::CONCEDE or GameProcess::TIMEOUT
+		// - loser          : player who conceded or timed out (1 or 2, 0 for normal end)
+		// - latency1, latency2 : latencies of DCP commands of each player in the game
+		// This function returns false if the game was not finished
+		bool PlayTournamentGame(picojson::object obj_server, picojson::object obj_sim, picojson::object obj_match,
+			string &name1, string &name2, int &score1, int &score2, int &end_state, int &loser,
+			LatencyStats &latency1, LatencyStats &latency2) {
+			Options opt;
+			GameProcess *gp = InitGameProcess(obj_server, obj_sim, obj_match, opt);
+			if (gp == nullptr) {
+				return false;
+			}
+			// Games of tournament are always fast and silent
+			opt.headless = gp->headless_ = true;
+			opt.quiet = true;
+
+			name1 = gp->player1_->name_;
+			name2 = gp->player2_->name_;
+			score1 = score2 = 0;
+			end_state = GameProcess::BESTSHOT;
+			loser = 0;
+
+			bool finished = false;
+			if (gp->IsReady(gp->player1_, opt.timeout_isready) && gp->IsReady(gp->player2_, opt.timeout_isready)) {
+				int status = RunMatch(*gp, opt);
+				if (status == GameProcess::BESTSHOT || status == GameProcess::CONCEDE || status == GameProcess::TIMEOUT) {
+					// Sum up scores of ends played
+					for (unsigned int i = 0; i < gp->gs_.CurEnd && i < kLastEndMax; i++) {
+						if (gp->gs_.Score[i] > 0) {
+							score1 += gp->gs_.Score[i];
+						}
+						else {
+							score2 -= gp->gs_.Score[i];
+						}
+					}
+					end_state = status;
+					if (status != GameProcess::BESTSHOT) {
+						// Player to move loses the game regardless of scores
+						loser = (gp->gs_.WhiteToMove) ? 2 : 1;
+					}
+					finished = true;
+				}
+			}
+			else {
+				cerr << "failed to recieve ISREADY from " << name1 << " or " << name2 << endl;
+			}
+			latency1 = gp->player1_->latency_;
+			if (gp->player2_ != gp->player1_) {
+				latency2 = gp->player2_->latency_;
+			}
+
+			gp->player1_->ExitProcess();
+			gp->player2_->ExitProcess();
+			Release(gp);
+
+			return finished;
+		}
+
+		// Run games of tournament in parallel
+		int TournamentServer(std::string tournament_name) {
+			std::string config_path = "config.json";
+			picojson::object obj_config;
+			if (!LoadConfig(config_path, obj_config)) {
+				return 0;
+			}
+			if (!obj_config[tournament_name].is<picojson::object>()) {
+				cerr << "failed to find tournament '" << tournament_name << "' in " << config_path << "." << endl;
+				return 0;
+			}
+			picojson::object obj_server = obj_config["server"].get<picojson::object>();  // Server
+			picojson::object obj_sim = obj_config["simulator"].get<picojson::object>();  // Simulator
+			picojson::object obj_tournament = obj_config[tournament_name].get<picojson::object>();  // Tournament
+
+			// Duplicate mode: each game is played again with first and second swapped and the same seed,
+			// so both players get the same noise for each end and shot (luck cancels out)
+			bool duplicate = obj_tournament["duplicate"].is<bool>() && obj_tournament["duplicate"].get<bool>();
+
+			// List up games (each game runs on its own game process)
+			std::vector<picojson::object> games;
+			auto add_game = [&](picojson::object obj_match, int index) {
+				uint64_t seed;
+				if (GetSeed(obj_match, seed)) {
+					// Seed of index-th game of the match
+					SetSeed(obj_match, seed + index);
+				}
+				games.push_back(obj_match);
+				if (duplicate) {
+					std::swap(obj_match["player_1"], obj_match["player_2"]);
+					games.push_back(obj_match);
+				}
+			};
+			auto seed_match = [&](picojson::object &obj_match) {
+				uint64_t seed;
+				if (duplicate && !GetSeed(obj_match, seed)) {
+					// Duplicate games need a seed (printed to reproduce them)
+					seed = std::random_device()();
+					SetSeed(obj_match, seed);
+					cout << "> seed " << seed << " for duplicate games." << endl;
+				}
+			};
+			if (obj_tournament["matches"].is<picojson::array>()) {
+				// Matches in config, 'repetition' games for each
+				picojson::array matches = obj_tournament["matches"].get<picojson::array>();
+				for (picojson::array::iterator it = matches.begin(); it != matches.end(); it++) {
+					string match_name = it->get<string>();
+					if (!obj_config[match_name].is<picojson::object>()) {
+						cerr << "failed to find match '" << match_name << "' in " << config_path << "." << endl;
+						return 0;
+					}
+					picojson::object obj_match = obj_config[match_name].get<picojson::object>();
+					int repetition = (int)obj_match["repetition"].get<double>();
+					obj_match["repetition"] = picojson::value(1.0);
+					seed_match(obj_match);
+					for (int i = 0; i < repetition; i++) {
+						add_game(obj_match, i);
+					}
+				}
+			}
+			if (obj_tournament["round_robin"].is<picojson::object>()) {
+				// All pairs of players with rules of a match, 'games' games for each pair (first and second are swapped by turns)
+				// In duplicate mode each pair plays each of 'games' seeds twice (seeds are the same for all pairs)
+				picojson::object obj_rr = obj_tournament["round_robin"].get<picojson::object>();
+				string match_name = obj_rr["match"].get<string>();
+				if (!obj_config[match_name].is<picojson::object>()) {
+					cerr << "failed to find match '" << match_name << "' in " << config_path << "." << endl;
+					return 0;
+				}
+				picojson::object obj_match = obj_config[match_name].get<picojson::object>();
+				obj_match["repetition"] = picojson::value(1.0);
+				seed_match(obj_match);
+				int num_games = (int)obj_rr["games"].get<double>();
+				picojson::array players = obj_rr["players"].get<picojson::array>();
+				for (size_t i = 0; i < players.size(); i++) {
+					for (size_t j = i + 1; j < players.size(); j++) {
+						for (int k = 0; k < num_games; k++) {
+							bool swapped = !duplicate && k % 2 != 0;
+							obj_match["player_1"] = (swapped) ? players[j] : players[i];
+							obj_match["player_2"] = (swapped) ? players[i] : players[j];
+							add_game(obj_match, k);
+						}
+					}
+				}
+			}
+			if (games.empty()) {
+				cerr << "no games in tournament '" << tournament_name << "'." << endl;
 				return 0;
 			}
 
+			// Number of workers (0: number of cores), each worker runs 2 AI processes at once
+			unsigned int num_workers = obj_tournament["workers"].is<double>() ? (unsigned int)obj_tournament["workers"].get<double>() : 0;
+			if (num_workers == 0) {
+				num_workers = std::max(1u, std::thread::hardware_concurrency());
+			}
+			unsigned int max_processes = obj_tournament["max_processes"].is<double>() ? (unsigned int)obj_tournament["max_processes"].get<double>() : 0;
+			if (max_processes == 1) {
+				cerr << "max_processes of tournament '" << tournament_name << "' must be 0 or at least 2 (a game runs 2 AI processes)." << endl;
+				return 0;
+			}
+			if (max_processes > 0) {
+				num_workers = std::min(num_workers, max_processes / 2);
+			}
+			num_workers = std::min(num_workers, (unsigned int)games.size());
+
+			cout << "> " << games.size() << " games with " << num_workers << " workers." << endl;
+
+			// Run games on workers
+			std::atomic<size_t> next_game(0);
+			std::mutex mtx;  // for results below
+			size_t num_finished = 0;
+			size_t num_aborted = 0;
+			std::map<string, Standing> standings;
+			std::map<string, LatencyStats> latencies;  // latencies of each player in all games
+
+			auto worker = [&]() {
+				size_t i;
+				while ((i = next_game++) < games.size()) {
+					string name1, name2;
+					int score1, score2, end_state, loser;
+					LatencyStats latency1, latency2;
+					bool finished = PlayTournamentGame(obj_server, obj_sim, games[i], name1, name2, score1, score2, end_state, loser,
+						latency1, latency2);
+
+					// Aggregate result
+					std::lock_guard<std::mutex> lock(mtx);
+					num_finished++;
+					latencies[name1].Merge(latency1);
+					latencies[name2].Merge(latency2);
+					if (!finished) {
+						num_aborted++;
+						cout << "> [" << num_finished << "/" << games.size() << "] " << name1 << " - " << name2 << " aborted" << endl;
+						continue;
+					}
+					Standing &s1 = standings[name1];
+					Standing &s2 = standings[name2];
+					s1.games++;
+					s2.games++;
+					s1.points_for += score1;
+					s1.points_against += score2;
+					s2.points_for += score2;
+					s2.points_against += score1;
+					if (loser == 2 || (loser == 0 && score1 > score2)) {
+						s1.wins++;
+						s2.losses++;
+						s2.forfeits += (loser == 2);
+					}
+					else if (loser == 1 || score1 < score2) {
+						s1.losses++;
+						s2.wins++;
+						s1.forfeits += (loser == 1);
+					}
+					else {
+						s1.draws++;
+						s2.draws++;
+					}
+					cout << "> [" << num_finished << "/" << games.size() << "] " <<
+						name1 << " " << score1 << " - " << score2 << " " << name2;
+					if (loser != 0) {
+						cout << " (" << ((end_state == GameProcess::CONCEDE) ? "CONCEDE" : "TIMEOUT") << " of " <<
+							((loser == 1) ? name1 : name2) << ")";
+					}
+					uint64_t seed;
+					if (GetSeed(games[i], seed)) {
+						cout << " (seed " << seed << ")";
+					}
+					cout << endl;
+				}
+			};
+
+			std::vector<std::thread> workers;
+			for (unsigned int i = 0; i < num_workers; i++) {
+				workers.push_back(std::thread(worker));
+			}
+			for (unsigned int i = 0; i < num_workers; i++) {
+				workers[i].join();
+			}
+
+			// Print standings
+			cout << "> === Tournament '" << tournament_name << "' ===" << endl;
+			cout << "> player : games win-loss-draw (win rate) points for-against, forfeits" << endl;
+			for (std::map<string, Standing>::iterator it = standings.begin(); it != standings.end(); it++) {
+				const Standing &s = it->second;
+				cout << "> " << it->first << " : " << s.games << " " << s.wins << "-" << s.losses << "-" << s.draws <<
+					" (" << std::fixed << std::setprecision(3) << (s.wins + 0.5 * s.draws) / s.games << ") " <<
+					s.points_for << "-" << s.points_against << ", " << s.forfeits << endl;
+			}
+			cout.unsetf(std::ios::floatfield);
+			if (num_aborted > 0) {
+				cout << "> " << num_aborted << " games aborted." << endl;
+			}
+
+			// Print latencies of each player in all games
+			for (std::map<string, LatencyStats>::iterator it = latencies.begin(); it != latencies.end(); it++) {
+				it->second.Print(cerr, it->first);
+			}
+
 			return 1;
 		}
 	
@@ -387,6 +820,10 @@ namespace digital_curling {
 			ss_help << "> Commands:" << endl;
 			ss_help << ">  'run' : run single match." << endl;
 			ss_help << ">  'run MATCH_NAME' : run single match named MATCH_NAME (default 'match_default')" << endl;
+			ss_help << ">  'tournament NAME' : run games of tournament named NAME in parallel (default 'tournament_default')" << endl;
+			ss_help << ">  'convert FILE' : convert log (.dcl) to binary log (.dcb), or binary log to log" << endl;
+			ss_help << ">  'replay PATH... [-t] [-e TOL]' : replay logs (files or directories) in parallel and verify positions" << endl;
+			ss_help << ">      -t : write trajectories to .csv, -e : tolerance of positions [m] (default 0 for .dcb, 1e-3 for .dcl)" << endl;
 			ss_help << ">  'q' or 'exit' : exit from server." << endl;
 			ss_help << ">  'h' or 'help' : show all commands." << endl;
 			ss_help << "> ==========================================" << endl;
@@ -429,6 +866,70 @@ namespace digital_curling {
 					cout << "> run single match '" << match_name << "'." << endl;
 					SimpleServer(match_name);
 				}
+				else if (tokens[0] == "tournament") {
+					std::string tournament_name;
+					if (tokens.size() == 1) {
+						tournament_name = "tournament_default";
+					}
+					else {
+						tournament_name = tokens[1];
+					}
+					cout << "> run tournament '" << tournament_name << "'." << endl;
+					TournamentServer(tournament_name);
+				}
+				else if (tokens[0] == "convert") {
+					if (tokens.size() < 2) {
+						cerr << "> file name is required." << endl;
+						continue;
+					}
+					// Convert to the other format (same name, different extension)
+					std::string path = tokens[1];
+					std::string ext = (path.size() > 4) ? path.substr(path.size() - 4) : "";
+					bool ret;
+					if (ext == ".dcb") {
+						ret = ConvertBinaryToDcl(path, path.substr(0, path.size() - 4) + ".dcl");
+					}
+					else if (ext == ".dcl") {
+						ret = ConvertDclToBinary(path, path.substr(0, path.size() - 4) + ".dcb");
+					}
+					else {
+						cerr << "> extension must be .dcl or .dcb." << endl;
+						continue;
+					}
+					cout << (ret ? "> converted '" : "> failed to convert '") << path << "'." << endl;
+				}
+				else if (tokens[0] == "replay") {
+					ReplayOptions options;
+					std::vector<std::string> paths;
+					for (size_t i = 1; i < tokens.size(); i++) {
+						if (tokens[i] == "-t") {
+							options.output_trajectory = true;
+						}
+						else if (tokens[i] == "-e" && i + 1 < tokens.size()) {
+							options.tolerance = (float)atof(tokens[++i].c_str());
+						}
+						else {
+							paths.push_back(tokens[i]);
+						}
+					}
+					if (paths.empty()) {
+						cerr << "> file name is required." << endl;
+						continue;
+					}
+
+					// Simulate with parameters of the server
+					picojson::object obj_config;
+					if (LoadConfig("config.json", obj_config) && obj_config["simulator"].is<picojson::object>()) {
+						picojson::object obj_sim = obj_config["simulator"].get<picojson::object>();
+						if (obj_sim["friction"].is<double>()) {
+							options.friction = (float)obj_sim["friction"].get<double>();
+						}
+						if (obj_sim["freeguard_num"].is<double>()) {
+							options.freeguard_num = (unsigned int)obj_sim["freeguard_num"].get<double>();
+						}
+					}
+					ReplayLogs(paths, options);
+				}
 				else if (tokens[0] == "help" || tokens[0] == "h") {
  					// Show help
 					cout << ss_help.str();
@@ -0,0 +1,103 @@
+#include "message_queue.h"
+
+#include <cstring>
+
+namespace digital_curling {
+
+	MessageQueue::MessageQueue() : head_(0), tail_(0), closed_(false), waiting_(false) {}
+
+	MessageQueue::~MessageQueue() {}
+
+	// Push a message
+	bool MessageQueue::Push(const char *message) {
+		size_t tail = tail_.load(std::memory_order_relaxed);
+		if (tail - head_.load(std::memory_order_acquire) >= kQueueSize) {
+			return false;  // full
+		}
+
+		char *slot = messages_[tail & (kQueueSize - 1)];
+		size_t len = strlen(message);
+		if (len > kMessageSize - 1) {
+			len = kMessageSize - 1;
+		}
+		memcpy(slot, message, len);
+		slot[len] = '\0';
+
+		// Publish the message (seq_cst to order with the load of waiting_ in Notify())
+		tail_.store(tail + 1);
+		Notify();
+
+		return true;
+	}
+
+	// Queue is full or not
+	bool MessageQueue::Full() const {
+		return tail_.load(std::memory_order_relaxed) - head_.load(std::memory_order_acquire) >= kQueueSize;
+	}
+
+	// Pop a message
+	bool MessageQueue::Pop(char *message) {
+		size_t head = head_.load(std::memory_order_relaxed);
+		if (head == tail_.load()) {
+			return false;  // empty
+		}
+
+		const char *slot = messages_[head & (kQueueSize - 1)];
+		memcpy(message, slot, strlen(slot) + 1);
+
+		// Release the slot to producer
+		head_.store(head + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	// Pop a message, or wait for it until deadline
+	bool MessageQueue::WaitPop(char *message, std::chrono::steady_clock::time_point deadline) {
+		while (!Pop(message)) {
+			std::unique_lock<std::mutex> lock(park_mutex_);
+
+			// Producer sees waiting_ after pushing, or we see the message here
+			waiting_.store(true);
+			if (head_.load(std::memory_order_relaxed) != tail_.load()) {
+				waiting_.store(false);
+				continue;
+			}
+			if (closed_.load()) {
+				waiting_.store(false);
+				return false;
+			}
+
+			std::cv_status status = park_cv_.wait_until(lock, deadline);
+			waiting_.store(false);
+			if (status == std::cv_status::timeout) {
+				lock.unlock();
+				return Pop(message);  // message may arrive just at the deadline
+			}
+		}
+
+		return true;
+	}
+
+	// Close queue
+	void MessageQueue::Close() {
+		closed_.store(true);
+		Notify();
+	}
+
+	// Clear messages and open queue again
+	void MessageQueue::Reset() {
+		head_.store(0);
+		tail_.store(0);
+		closed_.store(false);
+		waiting_.store(false);
+	}
+
+	// Wake up consumer if it is parked
+	void MessageQueue::Notify() {
+		if (waiting_.load()) {
+			// Lock so that the consumer is either before checking the queue or in wait_until()
+			std::lock_guard<std::mutex> lock(park_mutex_);
+			park_cv_.notify_one();
+		}
+	}
+}
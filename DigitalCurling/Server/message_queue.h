@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace digital_curling {
+
+	// Queue of messages for single producer and single consumer
+	// Push() and Pop() are lock-free, the mutex is used only to park the consumer while the queue is empty
+	class MessageQueue {
+	public:
+		static const size_t kQueueSize = 64;      // number of messages (power of 2)
+		static const size_t kMessageSize = 1024;  // size of a message including '\0'
+
+		MessageQueue();
+		~MessageQueue();
+
+		// Push a message (producer)
+		// This function returns false if the queue is full
+		bool Push(const char *message);
+
+		// Queue is full or not (producer)
+		bool Full() const;
+
+		// Pop a message (consumer)
+		// This function returns false if the queue is empty
+		bool Pop(char *message);
+
+		// Pop a message, or wait for it until deadline (consumer)
+		// This function returns false if no message arrived or the queue was closed
+		bool WaitPop(char *message, std::chrono::steady_clock::time_point deadline);
+
+		// Close queue (producer will push no more messages)
+		void Close();
+
+		// Clear messages and open queue again (no producer or consumer may be running)
+		void Reset();
+
+	private:
+		// Wake up consumer if it is parked
+		void Notify();
+
+		char messages_[kQueueSize][kMessageSize];
+
+		std::atomic<size_t> head_;    // number of messages popped (written by consumer)
+		std::atomic<size_t> tail_;    // number of messages pushed (written by producer)
+		std::atomic<bool> closed_;    // producer has exited
+		std::atomic<bool> waiting_;   // consumer is (going to be) parked
+
+		std::mutex park_mutex_;
+		std::condition_variable park_cv_;
+	};
+}
@@ -0,0 +1,458 @@
+//======================================================
+// Simulation service which keeps simulators warm on a pool of threads.
+// Batches of (state, shot) are read as frames from stdin and their results are written to stdout
+// (see sim_service.h), so tools avoid constructing a simulator for each simulation.
+//======================================================
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../Simulator/dcurling_simulator.h"
+#include "sim_service.h"
+
+#ifdef _MSC_VER
+#ifdef _DEBUG
+#pragma comment( lib, "../x64/Debug/Simulator.lib" )
+#endif
+#ifndef _DEBUG
+#pragma comment( lib, "../x64/Release/Simulator.lib" )
+#endif
+#endif
+
+using std::cerr;
+using std::endl;
+using std::string;
+
+namespace digital_curling {
+
+	namespace sim_service {
+
+		// Options of service
+		struct Options {
+			unsigned int threads;        // number of threads (0: number of cores)
+			float friction;              // friction of simulator
+			unsigned int freeguard_num;  // number of shots of freeguard rule
+
+			Options() :
+				threads(0),
+				friction(12.009216f),  // friction_default of config.json
+				freeguard_num(5) {}
+		};
+
+		// A simulation of request
+		struct Pair {
+			GameState gs;   // state (state after the shot when done)
+			ShotVec shot;   // shot (shot with noise when done)
+			float noise[2]; // noise already drawn (random_1 and random_2 are applied)
+		};
+
+		// Number of pairs taken by a thread at once
+		constexpr size_t kChunkPairs = 16;
+
+		// Pool of threads, each of them has a simulator
+		class SimulatorPool {
+		public:
+			SimulatorPool(const Options &options) :
+				generation_(0),
+				stop_(false),
+				pairs_(nullptr),
+				num_pairs_(0),
+				next_(0),
+				num_working_(0) {
+				unsigned int num_threads = (options.threads > 0) ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+				for (unsigned int i = 0; i < num_threads; i++) {
+					threads_.push_back(std::thread(&SimulatorPool::Work, this, options));
+				}
+			}
+			~SimulatorPool() {
+				{
+					std::lock_guard<std::mutex> lock(mtx_);
+					stop_ = true;
+				}
+				cv_start_.notify_all();
+				for (std::thread &thread : threads_) {
+					thread.join();
+				}
+			}
+
+			size_t NumThreads() const {
+				return threads_.size();
+			}
+
+			// Simulate all pairs (returns when all of them are done)
+			void Run(std::vector<Pair> &pairs) {
+				std::unique_lock<std::mutex> lock(mtx_);
+				pairs_ = pairs.data();
+				num_pairs_ = pairs.size();
+				next_ = 0;
+				num_working_ = threads_.size();
+				generation_++;
+				cv_start_.notify_all();
+				cv_done_.wait(lock, [this]() { return num_working_ == 0; });
+				pairs_ = nullptr;
+			}
+
+		private:
+			void Work(Options options) {
+				// Simulators are constructed in parallel (initialization of tables takes time)
+				b2simulator::Simulator sim(options.friction);
+				sim.num_freeguard_ = options.freeguard_num;
+				sim.area_freeguard_ = b2simulator::IN_FREEGUARD;
+
+				uint64_t generation = 0;
+				while (true) {
+					{
+						std::unique_lock<std::mutex> lock(mtx_);
+						cv_start_.wait(lock, [this, generation]() { return stop_ || generation_ != generation; });
+						if (stop_) {
+							return;
+						}
+						generation = generation_;
+					}
+
+					size_t begin;
+					while ((begin = next_.fetch_add(kChunkPairs)) < num_pairs_) {
+						size_t end = std::min(begin + kChunkPairs, num_pairs_);
+						for (size_t i = begin; i < end; i++) {
+							Pair &pair = pairs_[i];
+							sim.AddNoise2Vec(pair.noise[0], pair.noise[1], &pair.shot);
+							sim.Simulation(&pair.gs, pair.shot, 0.0f, 0.0f, nullptr, nullptr, 0);
+						}
+					}
+
+					std::lock_guard<std::mutex> lock(mtx_);
+					if (--num_working_ == 0) {
+						cv_done_.notify_one();
+					}
+				}
+			}
+
+			std::vector<std::thread> threads_;
+			std::mutex mtx_;                    // for members below
+			std::condition_variable cv_start_;  // new request or stop
+			std::condition_variable cv_done_;   // all threads finished request
+			uint64_t generation_;               // number of requests
+			bool stop_;
+			Pair *pairs_;
+			size_t num_pairs_;
+			std::atomic<size_t> next_;          // first pair not taken yet
+			size_t num_working_;                // number of threads working on request
+		};
+
+		static uint32_t GetU32(const char *p) {
+			const unsigned char *u = (const unsigned char*)p;
+			return (uint32_t)u[0] | ((uint32_t)u[1] << 8) | ((uint32_t)u[2] << 16) | ((uint32_t)u[3] << 24);
+		}
+		static float GetFloat(const char *p) {
+			uint32_t bits = GetU32(p);
+			float value;
+			memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+		static void PutU32(uint32_t value, char *p) {
+			for (int i = 0; i < 4; i++) {
+				p[i] = (char)((value >> (8 * i)) & 0xff);
+			}
+		}
+		static void PutFloat(float value, char *p) {
+			uint32_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			PutU32(bits, p);
+		}
+
+		// Decode FRAME_SIMULATE to pairs (returns reason of error, or empty string)
+		static string DecodeRequest(const dcp::Frame &frame, std::vector<Pair> &pairs) {
+			if (frame.type != FRAME_SIMULATE) {
+				return "unknown type of frame " + std::to_string(frame.type);
+			}
+			if (frame.size < kSimulateHeaderSize) {
+				return "too short request";
+			}
+			uint32_t count = GetU32(frame.data);
+			uint32_t seed = GetU32(frame.data + 4);
+			float random_1 = GetFloat(frame.data + 8);
+			float random_2 = GetFloat(frame.data + 12);
+			if (count > kMaxPairs || frame.size != kSimulateHeaderSize + (size_t)count * kPairSize) {
+				return "size of request does not match count " + std::to_string(count);
+			}
+
+			std::mt19937 engine(seed);
+			std::normal_distribution<float> normal(0.0f, 1.0f);
+			bool noise = (random_1 != 0.0f || random_2 != 0.0f);
+
+			pairs.resize(count);
+			const char *p = frame.data + kSimulateHeaderSize;
+			for (uint32_t i = 0; i < count; i++, p += kPairSize) {
+				Pair &pair = pairs[i];
+				pair.gs.ClearAll();
+				dcp::DecodeState(p, dcp::kStateSize, &pair.gs);
+				dcp::DecodeShot(p + dcp::kStateSize, dcp::kShotSize, &pair.shot);
+				if (pair.gs.ShotNum >= 16 || pair.gs.CurEnd >= kLastEndMax) {
+					return "invalid state of pair " + std::to_string(i);
+				}
+				pair.noise[0] = (noise) ? normal(engine) * random_1 : 0.0f;
+				pair.noise[1] = (noise) ? normal(engine) * random_2 : 0.0f;
+			}
+			return "";
+		}
+
+		// Write a frame to out
+		static bool WriteFrame(FILE *out, unsigned char type, uint32_t seq, const char *data, size_t size, std::vector<char> &buffer) {
+			buffer.resize(dcp::kFrameHeaderSize + size);
+			size_t n = dcp::WriteFrame(type, seq, data, size, buffer.data(), buffer.size());
+			return fwrite(buffer.data(), 1, n, out) == n && fflush(out) == 0;
+		}
+
+		// Read a frame from in (frame points to buffer)
+		static bool ReadFrame(FILE *in, std::vector<char> &buffer, dcp::Frame *frame) {
+			buffer.resize(4);
+			if (fread(buffer.data(), 1, 4, in) != 4) {
+				return false;
+			}
+			const unsigned char *u = (const unsigned char*)buffer.data();
+			uint32_t length = ((uint32_t)u[0] << 24) | ((uint32_t)u[1] << 16) | ((uint32_t)u[2] << 8) | u[3];
+			buffer.resize(4 + (size_t)length);
+			return fread(buffer.data() + 4, 1, length, in) == length && dcp::ReadFrame(buffer.data(), buffer.size(), frame) > 0;
+		}
+
+		// Serve requests until in is closed (stdin and stdout)
+		static int Serve(const Options &options, FILE *in, FILE *out) {
+			SimulatorPool pool(options);
+			cerr << "> SimService ready with " << pool.NumThreads() << " threads." << endl;
+
+			std::vector<char> request;
+			std::vector<char> result;
+			std::vector<char> reply;
+			std::vector<Pair> pairs;
+			uint64_t num_requests = 0;
+			uint64_t num_pairs = 0;
+			while (true) {
+				// Read length and rest of frame
+				request.resize(4);
+				if (fread(request.data(), 1, 4, in) != 4) {
+					break;
+				}
+				const unsigned char *u = (const unsigned char*)request.data();
+				uint32_t length = ((uint32_t)u[0] << 24) | ((uint32_t)u[1] << 16) | ((uint32_t)u[2] << 8) | u[3];
+				if (length > dcp::kFrameHeaderSize + kSimulateHeaderSize + (size_t)kMaxPairs * kPairSize) {
+					cerr << "too large frame (" << length << " bytes)." << endl;
+					return 1;
+				}
+				request.resize(4 + (size_t)length);
+				if (fread(request.data() + 4, 1, length, in) != length) {
+					cerr << "stdin was closed in a frame." << endl;
+					return 1;
+				}
+
+				dcp::Frame frame;
+				dcp::ReadFrame(request.data(), request.size(), &frame);
+				string error = DecodeRequest(frame, pairs);
+				if (!error.empty()) {
+					if (!WriteFrame(out, FRAME_ERROR, frame.seq, error.data(), error.size(), reply)) {
+						return 1;
+					}
+					continue;
+				}
+
+				pool.Run(pairs);
+
+				result.resize(pairs.size() * kPairSize);
+				for (size_t i = 0; i < pairs.size(); i++) {
+					dcp::EncodeState(pairs[i].gs, result.data() + i * kPairSize);
+					dcp::EncodeShot(pairs[i].shot, result.data() + i * kPairSize + dcp::kStateSize);
+				}
+				if (!WriteFrame(out, FRAME_RESULT, frame.seq, result.data(), result.size(), reply)) {
+					return 1;
+				}
+				num_requests++;
+				num_pairs += pairs.size();
+			}
+
+			cerr << "> SimService simulated " << num_pairs << " shots of " << num_requests << " requests." << endl;
+			return 0;
+		}
+
+		// Encode FRAME_SIMULATE of pairs
+		static std::vector<char> EncodeRequest(const std::vector<Pair> &pairs, uint32_t seed, float random_1, float random_2) {
+			std::vector<char> data(kSimulateHeaderSize + pairs.size() * kPairSize);
+			PutU32((uint32_t)pairs.size(), data.data());
+			PutU32(seed, data.data() + 4);
+			PutFloat(random_1, data.data() + 8);
+			PutFloat(random_2, data.data() + 12);
+			for (size_t i = 0; i < pairs.size(); i++) {
+				char *p = data.data() + kSimulateHeaderSize + i * kPairSize;
+				dcp::EncodeState(pairs[i].gs, p);
+				dcp::EncodeShot(pairs[i].shot, p + dcp::kStateSize);
+			}
+			return data;
+		}
+
+		// Round trip of requests through the protocol (sample client)
+		//  Requests are written to a file which is served as stdin, and replies in the file of stdout are checked:
+		//  results without noise are the same as Simulation() in this process, the same request with noise gets
+		//  the same results, and an invalid request gets FRAME_ERROR
+		static int Test(const Options &options, unsigned int num_pairs) {
+			b2simulator::Simulator sim(options.friction);
+			sim.num_freeguard_ = options.freeguard_num;
+			sim.area_freeguard_ = b2simulator::IN_FREEGUARD;
+
+			// States of random draw shots with noise, and random draw or hit shots from them
+			std::mt19937 engine(0);
+			std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+			std::vector<Pair> pairs(num_pairs);
+			for (Pair &pair : pairs) {
+				pair.gs = GameState(kLastEndMax);
+				pair.gs.CurEnd = engine() % kLastEndMax;
+				pair.gs.WhiteToMove = (engine() % 2 != 0);
+				unsigned int shots = engine() % 16;
+				for (unsigned int i = 0; i < shots; i++) {
+					ShotVec vec;
+					sim.CreateShot(ShotPos(kCenterX + kHouseR * (2.0f * uniform(engine) - 1.0f), kTeeY + kHouseR * (2.0f * uniform(engine) - 1.0f), engine() % 2 != 0), &vec);
+					sim.Simulation(&pair.gs, vec, 0.0725f, 0.29f, nullptr, nullptr, 0);
+				}
+				bool angle = (engine() % 2 != 0);
+				if (shots > 0 && engine() % 2 != 0) {
+					unsigned int i = engine() % shots;
+					sim.CreateHitShot(ShotPos(pair.gs.body[i][0], pair.gs.body[i][1], angle), 1.0f + 15.0f * uniform(engine), &pair.shot);
+				}
+				else {
+					sim.CreateShot(ShotPos(kCenterX + kHouseR * (2.0f * uniform(engine) - 1.0f), kTeeY + kHouseR * (2.0f * uniform(engine) - 1.0f), angle), &pair.shot);
+				}
+			}
+
+			// seq 1: without noise, seq 2 and 3: the same request with noise, seq 4: invalid (count does not match)
+			FILE *in = std::tmpfile();
+			FILE *out = std::tmpfile();
+			if (in == nullptr || out == nullptr) {
+				cerr << "failed to create temporary files." << endl;
+				return 1;
+			}
+			std::vector<char> buffer;
+			std::vector<char> exact = EncodeRequest(pairs, 0, 0.0f, 0.0f);
+			std::vector<char> noisy = EncodeRequest(pairs, 1, 0.0725f, 0.29f);
+			std::vector<char> invalid = EncodeRequest(pairs, 0, 0.0f, 0.0f);
+			PutU32(num_pairs + 1, invalid.data());
+			WriteFrame(in, FRAME_SIMULATE, 1, exact.data(), exact.size(), buffer);
+			WriteFrame(in, FRAME_SIMULATE, 2, noisy.data(), noisy.size(), buffer);
+			WriteFrame(in, FRAME_SIMULATE, 3, noisy.data(), noisy.size(), buffer);
+			WriteFrame(in, FRAME_SIMULATE, 4, invalid.data(), invalid.size(), buffer);
+			std::rewind(in);
+			if (Serve(options, in, out) != 0) {
+				cerr << "failed to serve requests." << endl;
+				return 1;
+			}
+			std::rewind(out);
+
+			// Replies in order
+			std::vector<char> replies[4];
+			dcp::Frame frames[4];
+			for (uint32_t i = 0; i < 4; i++) {
+				if (!ReadFrame(out, replies[i], &frames[i]) || frames[i].seq != i + 1) {
+					cerr << "reply " << i + 1 << " was not read." << endl;
+					return 1;
+				}
+			}
+			std::fclose(in);
+			std::fclose(out);
+
+			int failed = 0;
+			if (frames[0].type != FRAME_RESULT || frames[0].size != num_pairs * kPairSize) {
+				cerr << "reply 1 is not result of " << num_pairs << " pairs." << endl;
+				failed++;
+			}
+			else {
+				for (unsigned int i = 0; i < num_pairs; i++) {
+					GameState gs = pairs[i].gs;
+					ShotVec run_shot;
+					sim.Simulation(&gs, pairs[i].shot, 0.0f, 0.0f, &run_shot, nullptr, 0);
+
+					char expected[kPairSize];
+					dcp::EncodeState(gs, expected);
+					dcp::EncodeShot(run_shot, expected + dcp::kStateSize);
+					if (memcmp(frames[0].data + i * kPairSize, expected, kPairSize) != 0) {
+						cerr << "result of pair " << i << " differs from Simulation()." << endl;
+						failed++;
+					}
+				}
+			}
+			if (frames[1].type != FRAME_RESULT || frames[2].type != FRAME_RESULT || frames[1].size != frames[2].size ||
+				memcmp(frames[1].data, frames[2].data, frames[1].size) != 0) {
+				cerr << "results of the same request with noise differ." << endl;
+				failed++;
+			}
+			if (frames[3].type != FRAME_ERROR) {
+				cerr << "invalid request was not rejected." << endl;
+				failed++;
+			}
+
+			cerr << "> SimService test " << ((failed == 0) ? "passed" : "FAILED") << " (" << num_pairs << " pairs)." << endl;
+			return (failed == 0) ? 0 : 1;
+		}
+
+		static void PrintUsage() {
+			cerr << "usage: SimService [-t THREADS] [-f FRICTION] [-g FREEGUARD] [-test [PAIRS]]" << endl;
+			cerr << "  -t THREADS    : number of threads (default: number of cores)" << endl;
+			cerr << "  -f FRICTION   : friction of simulator (default: 12.009216)" << endl;
+			cerr << "  -g FREEGUARD  : number of shots of freeguard rule (default: 5)" << endl;
+			cerr << "  -test [PAIRS] : check replies of requests against Simulation() instead of serving (default: 256 pairs)" << endl;
+		}
+	}
+}
+
+int main(int argc, char* argv[]) {
+	using namespace digital_curling::sim_service;
+
+	Options options;
+	bool test = false;
+	unsigned int test_pairs = 256;
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		bool has_value = (i + 1 < argc);
+		if (arg == "-t" && has_value) {
+			options.threads = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+		}
+		else if (arg == "-f" && has_value) {
+			options.friction = std::strtof(argv[++i], nullptr);
+		}
+		else if (arg == "-g" && has_value) {
+			options.freeguard_num = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+		}
+		else if (arg == "-test") {
+			test = true;
+			if (has_value && argv[i + 1][0] != '-') {
+				test_pairs = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+			}
+		}
+		else {
+			PrintUsage();
+			return (arg == "-h" || arg == "--help") ? 0 : 1;
+		}
+	}
+
+	if (test) {
+		return Test(options, test_pairs);
+	}
+
+#ifdef _WIN32
+	_setmode(_fileno(stdin), _O_BINARY);
+	_setmode(_fileno(stdout), _O_BINARY);
+#endif
+	return Serve(options, stdin, stdout);
+}
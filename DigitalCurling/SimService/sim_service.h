@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../Simulator/dcurling_dcp.h"
+
+namespace digital_curling {
+
+	// Protocol of SimService (simulation service on stdin/stdout)
+	//  Requests and replies are frames of binary DCP (dcp::WriteFrame() / dcp::ReadFrame())
+	//  A reply has the same sequence number as its request, requests are answered in order
+	namespace sim_service {
+
+		// Type of frame (after types of dcp)
+		enum : unsigned char {
+			FRAME_SIMULATE = 16,  // request: SimulateHeader and pairs of state and shot
+			FRAME_RESULT   = 17,  // reply  : pairs of state after the shot and shot with noise
+			FRAME_ERROR    = 18   // reply  : reason of error (text without '\0')
+		};
+
+		// Header of FRAME_SIMULATE (little endian)
+		//  count (uint32), seed (uint32), random_1 (float), random_2 (float)
+		//  Noise of pairs is drawn from seed in order (the same request gets the same results), no noise if random_1 = random_2 = 0
+		constexpr size_t kSimulateHeaderSize = 16;
+
+		// Size of a pair of FRAME_SIMULATE and FRAME_RESULT
+		//  state (dcp::kStateSize, ShotNum < 16 and CurEnd < kLastEndMax) and shot (dcp::kShotSize)
+		constexpr size_t kPairSize = dcp::kStateSize + dcp::kShotSize;
+
+		// Maximum number of pairs of a request
+		constexpr uint32_t kMaxPairs = 1 << 20;
+	}
+}
@@ -22,8 +22,20 @@
 #include "Box2D/Collision/Shapes/b2ChainShape.h"
 #include "Box2D/Collision/Shapes/b2PolygonShape.h"
 
+#include <atomic>
+
 // GJK using Voronoi regions (Christer Ericson) and Barycentric coordinates.
-int32 b2_gjkCalls, b2_gjkIters, b2_gjkMaxIters;
+// Statistics are atomic as worlds may be stepped on several threads at the same time.
+std::atomic<int32> b2_gjkCalls, b2_gjkIters, b2_gjkMaxIters;
+
+// a = max(a, value)
+static void b2AtomicMax(std::atomic<int32>& a, int32 value)
+{
+	int32 current = a.load(std::memory_order_relaxed);
+	while (current < value && !a.compare_exchange_weak(current, value, std::memory_order_relaxed))
+	{
+	}
+}
 
 void b2DistanceProxy::Set(const b2Shape* shape, int32 index)
 {
@@ -451,7 +463,7 @@ void b2Distance(b2DistanceOutput* output,
 				b2SimplexCache* cache,
 				const b2DistanceInput* input)
 {
-	++b2_gjkCalls;
+	b2_gjkCalls.fetch_add(1, std::memory_order_relaxed);
 
 	const b2DistanceProxy* proxyA = &input->proxyA;
 	const b2DistanceProxy* proxyB = &input->proxyB;
@@ -533,7 +545,6 @@ void b2Distance(b2DistanceOutput* output,
 
 		// Iteration count is equated to the number of support point calls.
 		++iter;
-		++b2_gjkIters;
 
 		// Check for duplicate support points. This is the main termination criteria.
 		bool duplicate = false;
@@ -556,7 +567,8 @@ void b2Distance(b2DistanceOutput* output,
 		++simplex.m_count;
 	}
 
-	b2_gjkMaxIters = b2Max(b2_gjkMaxIters, iter);
+	b2_gjkIters.fetch_add(iter, std::memory_order_relaxed);
+	b2AtomicMax(b2_gjkMaxIters, iter);
 
 	// Prepare output.
 	simplex.GetWitnessPoints(&output->pointA, &output->pointB);
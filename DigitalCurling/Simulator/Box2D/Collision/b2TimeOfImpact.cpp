@@ -24,10 +24,31 @@
 #include "Box2D/Common/b2Timer.h"
 
 #include <stdio.h>
+#include <atomic>
 
-float32 b2_toiTime, b2_toiMaxTime;
-int32 b2_toiCalls, b2_toiIters, b2_toiMaxIters;
-int32 b2_toiRootIters, b2_toiMaxRootIters;
+// Statistics are atomic as worlds may be stepped on several threads at the same time.
+std::atomic<float32> b2_toiTime, b2_toiMaxTime;
+std::atomic<int32> b2_toiCalls, b2_toiIters, b2_toiMaxIters;
+std::atomic<int32> b2_toiRootIters, b2_toiMaxRootIters;
+
+// a = max(a, value)
+template <typename T>
+static void b2AtomicMax(std::atomic<T>& a, T value)
+{
+	T current = a.load(std::memory_order_relaxed);
+	while (current < value && !a.compare_exchange_weak(current, value, std::memory_order_relaxed))
+	{
+	}
+}
+
+// a += value
+static void b2AtomicAdd(std::atomic<float32>& a, float32 value)
+{
+	float32 current = a.load(std::memory_order_relaxed);
+	while (!a.compare_exchange_weak(current, current + value, std::memory_order_relaxed))
+	{
+	}
+}
 
 //
 struct b2SeparationFunction
@@ -255,7 +276,7 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 {
 	b2Timer timer;
 
-	++b2_toiCalls;
+	b2_toiCalls.fetch_add(1, std::memory_order_relaxed);
 
 	output->state = b2TOIOutput::e_unknown;
 	output->t = input->tMax;
@@ -422,7 +443,6 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 				}
 
 				++rootIterCount;
-				++b2_toiRootIters;
 
 				float32 s = fcn.Evaluate(indexA, indexB, t);
 
@@ -451,7 +471,8 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 				}
 			}
 
-			b2_toiMaxRootIters = b2Max(b2_toiMaxRootIters, rootIterCount);
+			b2_toiRootIters.fetch_add(rootIterCount, std::memory_order_relaxed);
+			b2AtomicMax(b2_toiMaxRootIters, rootIterCount);
 
 			++pushBackIter;
 
@@ -462,7 +483,6 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 		}
 
 		++iter;
-		++b2_toiIters;
 
 		if (done)
 		{
@@ -478,9 +498,10 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 		}
 	}
 
-	b2_toiMaxIters = b2Max(b2_toiMaxIters, iter);
+	b2_toiIters.fetch_add(iter, std::memory_order_relaxed);
+	b2AtomicMax(b2_toiMaxIters, iter);
 
 	float32 time = timer.GetMilliseconds();
-	b2_toiMaxTime = b2Max(b2_toiMaxTime, time);
-	b2_toiTime += time;
+	b2AtomicMax(b2_toiMaxTime, time);
+	b2AtomicAdd(b2_toiTime, time);
 }
@@ -18,10 +18,15 @@
 
 #include "Box2D/Common/b2Timer.h"
 
+#include <mutex>
+
 #if defined(_WIN32)
 
 float64 b2Timer::s_invFrequency = 0.0f;
 
+// Timers may be created on several threads at the same time
+static std::once_flag s_invFrequencyOnce;
+
 #ifndef WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN
 #endif
@@ -32,15 +37,16 @@ b2Timer::b2Timer()
 {
 	LARGE_INTEGER largeInteger;
 
-	if (s_invFrequency == 0.0f)
+	std::call_once(s_invFrequencyOnce, []()
 	{
-		QueryPerformanceFrequency(&largeInteger);
-		s_invFrequency = float64(largeInteger.QuadPart);
+		LARGE_INTEGER frequency;
+		QueryPerformanceFrequency(&frequency);
+		s_invFrequency = float64(frequency.QuadPart);
 		if (s_invFrequency > 0.0f)
 		{
 			s_invFrequency = 1000.0f / s_invFrequency;
 		}
-	}
+	});
 
 	QueryPerformanceCounter(&largeInteger);
 	m_start = float64(largeInteger.QuadPart);
@@ -0,0 +1,136 @@
+#include "dcsim_capi.h"
+
+#include <cstring>
+#include <new>
+
+#include "dcurling_simulator.h"
+
+using digital_curling::GameState;
+using digital_curling::ShotPos;
+using digital_curling::ShotVec;
+using digital_curling::b2simulator::Simulator;
+
+struct dcsim_simulator {
+	Simulator sim;
+
+	dcsim_simulator(float friction) : sim(friction) {}
+};
+
+// Copy positions of state i of batch to gs
+static void LoadPositions(const float *x, const float *y, size_t i, GameState *gs) {
+	for (size_t k = 0; k < 16; k++) {
+		gs->body[k][0] = x[i * 16 + k];
+		gs->body[k][1] = y[i * 16 + k];
+	}
+}
+
+// Copy positions of gs to state i of batch
+static void StorePositions(const GameState &gs, size_t i, float *x, float *y) {
+	for (size_t k = 0; k < 16; k++) {
+		x[i * 16 + k] = gs.body[k][0];
+		y[i * 16 + k] = gs.body[k][1];
+	}
+}
+
+int dcsim_api_version(void) {
+	return DCSIM_API_VERSION;
+}
+
+dcsim_simulator *dcsim_create(float friction, uint32_t freeguard_num) {
+	// Simulator has tables of shots (too large for stack of caller)
+	dcsim_simulator *sim = new (std::nothrow) dcsim_simulator(friction);
+	if (sim != nullptr) {
+		sim->sim.num_freeguard_ = freeguard_num;
+		sim->sim.area_freeguard_ = digital_curling::b2simulator::IN_FREEGUARD;
+	}
+	return sim;
+}
+
+void dcsim_destroy(dcsim_simulator *sim) {
+	delete sim;
+}
+
+int dcsim_simulate(
+	dcsim_simulator *sim, size_t n,
+	const uint32_t *shot_num, const float *x, const float *y,
+	const float *vx, const float *vy, const int32_t *curl,
+	const float *noise_1, const float *noise_2,
+	float *out_x, float *out_y) {
+	if (sim == nullptr || shot_num == nullptr || x == nullptr || y == nullptr ||
+		vx == nullptr || vy == nullptr || curl == nullptr || out_x == nullptr || out_y == nullptr ||
+		(noise_1 == nullptr) != (noise_2 == nullptr)) {
+		return DCSIM_INVALID_ARG;
+	}
+	for (size_t i = 0; i < n; i++) {
+		if (shot_num[i] >= 16) {
+			return DCSIM_INVALID_STATE;
+		}
+	}
+
+	GameState gs;
+	for (size_t i = 0; i < n; i++) {
+		gs.ShotNum = shot_num[i];
+		gs.CurEnd = 0;
+		LoadPositions(x, y, i, &gs);
+
+		ShotVec vec(vx[i], vy[i], curl[i] != 0);
+		if (noise_1 != nullptr) {
+			sim->sim.AddNoise2Vec(noise_1[i], noise_2[i], &vec);
+		}
+		sim->sim.Simulation(&gs, vec, 0.0f, 0.0f, nullptr, nullptr, 0);
+
+		StorePositions(gs, i, out_x, out_y);
+	}
+	return DCSIM_OK;
+}
+
+int dcsim_create_shot(
+	dcsim_simulator *sim, size_t n,
+	const float *target_x, const float *target_y, const int32_t *curl,
+	float *out_vx, float *out_vy) {
+	if (sim == nullptr || target_x == nullptr || target_y == nullptr || curl == nullptr ||
+		out_vx == nullptr || out_vy == nullptr) {
+		return DCSIM_INVALID_ARG;
+	}
+	for (size_t i = 0; i < n; i++) {
+		ShotVec vec;
+		sim->sim.CreateShot(ShotPos(target_x[i], target_y[i], curl[i] != 0), &vec);
+		out_vx[i] = vec.x;
+		out_vy[i] = vec.y;
+	}
+	return DCSIM_OK;
+}
+
+int dcsim_create_hit_shot(
+	dcsim_simulator *sim, size_t n,
+	const float *target_x, const float *target_y, const int32_t *curl, const float *weight,
+	float *out_vx, float *out_vy) {
+	if (sim == nullptr || target_x == nullptr || target_y == nullptr || curl == nullptr || weight == nullptr ||
+		out_vx == nullptr || out_vy == nullptr) {
+		return DCSIM_INVALID_ARG;
+	}
+	for (size_t i = 0; i < n; i++) {
+		ShotVec vec;
+		sim->sim.CreateHitShot(ShotPos(target_x[i], target_y[i], curl[i] != 0), weight[i], &vec);
+		out_vx[i] = vec.x;
+		out_vy[i] = vec.y;
+	}
+	return DCSIM_OK;
+}
+
+int dcsim_score(
+	size_t n, const uint32_t *shot_num, const float *x, const float *y, int32_t *out_score) {
+	if (shot_num == nullptr || x == nullptr || y == nullptr || out_score == nullptr) {
+		return DCSIM_INVALID_ARG;
+	}
+	GameState gs;
+	for (size_t i = 0; i < n; i++) {
+		if (shot_num[i] > 16) {
+			return DCSIM_INVALID_STATE;
+		}
+		gs.ShotNum = shot_num[i];
+		LoadPositions(x, y, i, &gs);
+		out_score[i] = Simulator::GetScore(&gs);
+	}
+	return DCSIM_OK;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+// C API of the simulator for other languages (libdcsim.so / dcsim.dll)
+//  All arrays are owned by the caller and are plain arrays of 4-byte numbers (structure of arrays)
+//  Positions of batch of n states are float[n * 16], stone k of state i at [i * 16 + k] ((0, 0) if removed)
+//  A dcsim_simulator must not be used by two threads at the same time (create one for each thread)
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#define DCSIM_API __declspec(dllexport)
+#else // _WIN32
+#define DCSIM_API __attribute__((visibility("default")))
+#endif // _WIN32
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+	// Version of this API (changed when functions or layouts of arrays are changed)
+	#define DCSIM_API_VERSION 1
+
+	// Return values
+	enum {
+		DCSIM_OK            =  0,
+		DCSIM_INVALID_ARG   = -1,  // null pointer which must not be null
+		DCSIM_INVALID_STATE = -2   // shot_num >= 16 (> 16 for dcsim_score())
+	};
+
+	typedef struct dcsim_simulator dcsim_simulator;
+
+	// DCSIM_API_VERSION of the library
+	DCSIM_API int dcsim_api_version(void);
+
+	// Create simulator (returns NULL if failed)
+	//  friction      : friction between stone and ice (12.009216 in config.json)
+	//  freeguard_num : number of shots which freeguard rule is applied (5 in config.json)
+	DCSIM_API dcsim_simulator *dcsim_create(float friction, uint32_t freeguard_num);
+	DCSIM_API void dcsim_destroy(dcsim_simulator *sim);
+
+	// Simulate a shot from each of n states
+	//  shot_num        : ShotNum of each state (n), the shot is stone shot_num
+	//  x, y            : positions of stones before the shot (n * 16)
+	//  vx, vy, curl    : shot of each state (n, curl is 0 or 1)
+	//  noise_1, noise_2: noise already drawn for each shot (n, random number * random_1 / random_2), or NULL for no noise
+	//  out_x, out_y    : positions of stones after the shot (n * 16, may be the same arrays as x, y)
+	DCSIM_API int dcsim_simulate(
+		dcsim_simulator *sim, size_t n,
+		const uint32_t *shot_num, const float *x, const float *y,
+		const float *vx, const float *vy, const int32_t *curl,
+		const float *noise_1, const float *noise_2,
+		float *out_x, float *out_y);
+
+	// Create shots which stop at targets (CreateShot())
+	//  target_x, target_y, curl : position where stone will stop and curl of each shot (n)
+	//  out_vx, out_vy           : shot (n)
+	DCSIM_API int dcsim_create_shot(
+		dcsim_simulator *sim, size_t n,
+		const float *target_x, const float *target_y, const int32_t *curl,
+		float *out_vx, float *out_vy);
+
+	// Create shots which pass through targets with weight (CreateHitShot())
+	DCSIM_API int dcsim_create_hit_shot(
+		dcsim_simulator *sim, size_t n,
+		const float *target_x, const float *target_y, const int32_t *curl, const float *weight,
+		float *out_vx, float *out_vy);
+
+	// Score for second player of each of n positions (GetScore())
+	//  shot_num : number of stones delivered (n)
+	//  x, y     : positions of stones (n * 16)
+	//  out_score: score (n)
+	DCSIM_API int dcsim_score(
+		size_t n, const uint32_t *shot_num, const float *x, const float *y, int32_t *out_score);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,356 @@
+#include "dcurling_dcp.h"
+
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace digital_curling {
+
+	namespace dcp {
+
+		// Parse number
+		bool Parse(std::string_view token, int *value) {
+			const char *end = token.data() + token.size();
+			std::from_chars_result result = std::from_chars(token.data(), end, *value);
+			return result.ec == std::errc() && result.ptr == end;
+		}
+		bool Parse(std::string_view token, unsigned int *value) {
+			const char *end = token.data() + token.size();
+			std::from_chars_result result = std::from_chars(token.data(), end, *value);
+			return result.ec == std::errc() && result.ptr == end;
+		}
+		bool Parse(std::string_view token, float *value) {
+			const char *end = token.data() + token.size();
+#ifdef __cpp_lib_to_chars
+			// '+' is not accepted by from_chars()
+			const char *begin = (token.size() > 1 && token[0] == '+') ? token.data() + 1 : token.data();
+			std::from_chars_result result = std::from_chars(begin, end, *value);
+			return result.ec == std::errc() && result.ptr == end;
+#else
+			// Without from_chars() for float (e.g. VS2017): strtof() to a copy terminated by '\0'
+			char copy[64];
+			if (token.empty() || token.size() >= sizeof(copy)) {
+				return false;
+			}
+			memcpy(copy, token.data(), token.size());
+			copy[token.size()] = '\0';
+			char *copy_end;
+			*value = strtof(copy, &copy_end);
+			return copy_end == copy + token.size();
+#endif
+		}
+
+		Tokens::Tokens() : size_(0) {}
+
+		Tokens::Tokens(std::string_view message) : size_(0) {
+			Split(message);
+		}
+
+		// Split message
+		void Tokens::Split(std::string_view message) {
+			size_ = 0;
+
+			size_t pos = 0;
+			while (size_ < kMaxTokens) {
+				// Skip spaces (and end of line)
+				while (pos < message.size() && (message[pos] == ' ' || message[pos] == '\t' || message[pos] == '\r' || message[pos] == '\n')) {
+					pos++;
+				}
+				if (pos >= message.size() || message[pos] == '\0') {
+					break;
+				}
+
+				size_t begin = pos;
+				while (pos < message.size() && message[pos] != ' ' && message[pos] != '\t' && message[pos] != '\r' && message[pos] != '\n' && message[pos] != '\0') {
+					pos++;
+				}
+				tokens_[size_++] = message.substr(begin, pos - begin);
+			}
+		}
+
+		size_t Tokens::Size() const {
+			return size_;
+		}
+
+		std::string_view Tokens::operator[](size_t i) const {
+			return (i < size_) ? tokens_[i] : std::string_view();
+		}
+
+		bool Tokens::Is(std::string_view command) const {
+			return size_ > 0 && tokens_[0] == command;
+		}
+
+		Writer::Writer(char *buffer, size_t size) : buffer_(buffer), capacity_(size - 1), size_(0), ok_(true) {
+			buffer_[0] = '\0';
+		}
+
+		// Start a new token
+		char *Writer::Begin() {
+			if (size_ > 0 && size_ < capacity_) {
+				buffer_[size_++] = ' ';
+			}
+			else if (size_ > 0) {
+				ok_ = false;
+			}
+			return buffer_ + size_;
+		}
+
+		// End token
+		void Writer::End(char *end) {
+			size_ = end - buffer_;
+			buffer_[size_] = '\0';
+		}
+
+		Writer& Writer::Add(std::string_view token) {
+			char *p = Begin();
+			size_t len = token.size();
+			if (len > capacity_ - size_) {
+				len = capacity_ - size_;
+				ok_ = false;
+			}
+			memcpy(p, token.data(), len);
+			End(p + len);
+			return *this;
+		}
+
+		Writer& Writer::Add(int value) {
+			char *p = Begin();
+			std::to_chars_result result = std::to_chars(p, buffer_ + capacity_, value);
+			if (result.ec != std::errc()) {
+				ok_ = false;
+				result.ptr = p;
+			}
+			End(result.ptr);
+			return *this;
+		}
+
+		Writer& Writer::Add(unsigned int value) {
+			char *p = Begin();
+			std::to_chars_result result = std::to_chars(p, buffer_ + capacity_, value);
+			if (result.ec != std::errc()) {
+				ok_ = false;
+				result.ptr = p;
+			}
+			End(result.ptr);
+			return *this;
+		}
+
+		Writer& Writer::Add(float value) {
+			char *p = Begin();
+#ifdef __cpp_lib_to_chars
+			// Shortest form which is parsed to the same value
+			std::to_chars_result result = std::to_chars(p, buffer_ + capacity_, value);
+			if (result.ec != std::errc()) {
+				ok_ = false;
+				result.ptr = p;
+			}
+			End(result.ptr);
+#else
+			// Without to_chars() for float (e.g. VS2017): 9 digits are enough to parse to the same value
+			char tmp[32];
+			int len = snprintf(tmp, sizeof(tmp), "%.9g", value);
+			if (len < 0 || (size_t)len > capacity_ - size_) {
+				ok_ = false;
+				len = 0;
+			}
+			memcpy(p, tmp, len);
+			End(p + len);
+#endif
+			return *this;
+		}
+
+		const char *Writer::CStr() const {
+			return buffer_;
+		}
+
+		size_t Writer::Size() const {
+			return size_;
+		}
+
+		bool Writer::Ok() const {
+			return ok_;
+		}
+
+		// Write 'POSITION x0 y0 ... x15 y15'
+		size_t FormatPosition(const GameState &gs, char *buffer, size_t size) {
+			Writer writer(buffer, size);
+			writer.Add("POSITION");
+			for (int i = 0; i < 16; i++) {
+				writer.Add(gs.body[i][0]).Add(gs.body[i][1]);
+			}
+			return writer.Size();
+		}
+
+		// Write 'SETSTATE shot c_end l_end move'
+		size_t FormatSetState(const GameState &gs, char *buffer, size_t size) {
+			Writer writer(buffer, size);
+			writer.Add("SETSTATE").Add(gs.ShotNum).Add(gs.CurEnd).Add(gs.LastEnd).Add((gs.WhiteToMove) ? 1 : 0);
+			return writer.Size();
+		}
+
+		// Write 'GO timelimit1 timelimit2'
+		size_t FormatGo(int time_remain1, int time_remain2, char *buffer, size_t size) {
+			Writer writer(buffer, size);
+			writer.Add("GO").Add(time_remain1).Add(time_remain2);
+			return writer.Size();
+		}
+
+		// Write 'BESTSHOT x y angle'
+		size_t FormatBestShot(const ShotVec &vec, char *buffer, size_t size) {
+			Writer writer(buffer, size);
+			writer.Add("BESTSHOT").Add(vec.x).Add(vec.y).Add((vec.angle) ? 1 : 0);
+			return writer.Size();
+		}
+
+		// Read 'POSITION x0 y0 ... x15 y15'
+		bool ParsePosition(const Tokens &tokens, GameState *gs) {
+			for (unsigned int i = 0; i < 16; i++) {
+				if (!tokens.Get(2 * i + 1, &gs->body[i][0]) || !tokens.Get(2 * i + 2, &gs->body[i][1])) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// Read 'SETSTATE shot c_end l_end move'
+		bool ParseSetState(const Tokens &tokens, GameState *gs) {
+			int move;
+			if (!tokens.Get(1, &gs->ShotNum) || !tokens.Get(2, &gs->CurEnd) || !tokens.Get(3, &gs->LastEnd) || !tokens.Get(4, &move)) {
+				return false;
+			}
+			gs->WhiteToMove = (move != 0);
+			return true;
+		}
+
+		// Read 'BESTSHOT x y angle'
+		bool ParseBestShot(const Tokens &tokens, ShotVec *vec) {
+			float angle;  // '1.0' is also accepted
+			if (!tokens.Get(1, &vec->x) || !tokens.Get(2, &vec->y) || !tokens.Get(3, &angle)) {
+				return false;
+			}
+			vec->angle = (angle != 0);
+			return true;
+		}
+
+		// Little endian numbers of binary DCP
+		static void PutU32(uint32_t value, char *p) {
+			for (int i = 0; i < 4; i++) {
+				p[i] = (char)(value >> (8 * i));
+			}
+		}
+		static uint32_t GetU32(const char *p) {
+			const unsigned char *u = (const unsigned char*)p;
+			return (uint32_t)u[0] | ((uint32_t)u[1] << 8) | ((uint32_t)u[2] << 16) | ((uint32_t)u[3] << 24);
+		}
+		static void PutFloat(float value, char *p) {
+			uint32_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			PutU32(bits, p);
+		}
+		static float GetFloat(const char *p) {
+			uint32_t bits = GetU32(p);
+			float value;
+			memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+
+		// Write a frame
+		size_t WriteFrame(unsigned char type, uint32_t seq, const void *data, size_t size, char *buffer, size_t buffer_size) {
+			if (buffer_size < kFrameHeaderSize + size) {
+				return 0;
+			}
+			uint32_t length = (uint32_t)(kFrameHeaderSize - 4 + size);
+			for (int i = 0; i < 4; i++) {
+				buffer[i] = (char)(length >> (24 - 8 * i));
+				buffer[5 + i] = (char)(seq >> (24 - 8 * i));
+			}
+			buffer[4] = (char)type;
+			memcpy(buffer + kFrameHeaderSize, data, size);
+			return kFrameHeaderSize + size;
+		}
+
+		// Read a frame
+		size_t ReadFrame(const char *buffer, size_t buffer_size, Frame *frame) {
+			if (buffer_size < 4) {
+				return 0;
+			}
+			const unsigned char *p = (const unsigned char*)buffer;
+			uint32_t length = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+			if (buffer_size < 4 + (size_t)length) {
+				return 0;
+			}
+
+			if (length < kFrameHeaderSize - 4) {
+				// Invalid frame (ignored)
+				frame->type = 0;
+				frame->seq = 0;
+				frame->data = buffer + 4;
+				frame->size = 0;
+			}
+			else {
+				frame->type = p[4];
+				frame->seq = ((uint32_t)p[5] << 24) | ((uint32_t)p[6] << 16) | ((uint32_t)p[7] << 8) | p[8];
+				frame->data = buffer + kFrameHeaderSize;
+				frame->size = length - (kFrameHeaderSize - 4);
+			}
+			return 4 + (size_t)length;
+		}
+
+		// Data of FRAME_STATE
+		void EncodeState(const GameState &gs, char *data) {
+			PutU32(gs.ShotNum, data);
+			PutU32(gs.CurEnd, data + 4);
+			PutU32(gs.LastEnd, data + 8);
+			PutU32((gs.WhiteToMove) ? 1 : 0, data + 12);
+			for (int i = 0; i < 16; i++) {
+				PutFloat(gs.body[i][0], data + 16 + 8 * i);
+				PutFloat(gs.body[i][1], data + 20 + 8 * i);
+			}
+		}
+		bool DecodeState(const char *data, size_t size, GameState *gs) {
+			if (size < kStateSize) {
+				return false;
+			}
+			gs->ShotNum = GetU32(data);
+			gs->CurEnd = GetU32(data + 4);
+			gs->LastEnd = GetU32(data + 8);
+			gs->WhiteToMove = (GetU32(data + 12) != 0);
+			for (int i = 0; i < 16; i++) {
+				gs->body[i][0] = GetFloat(data + 16 + 8 * i);
+				gs->body[i][1] = GetFloat(data + 20 + 8 * i);
+			}
+			return true;
+		}
+
+		// Data of FRAME_GO
+		void EncodeGo(int time_remain1, int time_remain2, char *data) {
+			PutU32((uint32_t)time_remain1, data);
+			PutU32((uint32_t)time_remain2, data + 4);
+		}
+		bool DecodeGo(const char *data, size_t size, int *time_remain1, int *time_remain2) {
+			if (size < kGoSize) {
+				return false;
+			}
+			*time_remain1 = (int)GetU32(data);
+			*time_remain2 = (int)GetU32(data + 4);
+			return true;
+		}
+
+		// Data of FRAME_BESTSHOT
+		void EncodeShot(const ShotVec &vec, char *data) {
+			PutFloat(vec.x, data);
+			PutFloat(vec.y, data + 4);
+			PutU32((vec.angle) ? 1 : 0, data + 8);
+		}
+		bool DecodeShot(const char *data, size_t size, ShotVec *vec) {
+			if (size < kShotSize) {
+				return false;
+			}
+			vec->x = GetFloat(data);
+			vec->y = GetFloat(data + 4);
+			vec->angle = (GetU32(data + 8) != 0);
+			return true;
+		}
+	}
+}
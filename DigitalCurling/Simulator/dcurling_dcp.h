@@ -0,0 +1,141 @@
+#pragma once
+
+#include "dcurling_simulator.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace digital_curling {
+
+	// Codec of DCP messages (shared by the server and AIs)
+	//  Tokens are views into the message and numbers are parsed/formatted without memory allocation
+	namespace dcp {
+
+		constexpr size_t kMaxTokens = 64;  // Maximum number of tokens of a message ('POSITION' has 33)
+
+		// Parse number (returns false if token is not a whole number)
+		DLLAPI bool Parse(std::string_view token, int *value);
+		DLLAPI bool Parse(std::string_view token, unsigned int *value);
+		DLLAPI bool Parse(std::string_view token, float *value);
+
+		// Tokens of a message split by spaces
+		//  The message must not be changed or destroyed while tokens are used
+		class DLLAPI Tokens {
+		public:
+			Tokens();
+			explicit Tokens(std::string_view message);
+
+			// Split message (tokens after kMaxTokens are ignored)
+			void Split(std::string_view message);
+
+			// Number of tokens
+			size_t Size() const;
+			// Token i (empty if i >= Size())
+			std::string_view operator[](size_t i) const;
+
+			// Token 0 is command
+			bool Is(std::string_view command) const;
+
+			// Parse token i (returns false if token i does not exist or is invalid)
+			template<class T>
+			bool Get(size_t i, T *value) const {
+				return i < size_ && Parse(tokens_[i], value);
+			}
+
+		private:
+			std::string_view tokens_[kMaxTokens];
+			size_t size_;
+		};
+
+		// Writer of a message to buffer of fixed size
+		//  Floats are written in shortest form which is parsed to the same value
+		class DLLAPI Writer {
+		public:
+			Writer(char *buffer, size_t size);  // size > 0
+
+			// Append token (separated by a space)
+			Writer& Add(std::string_view token);
+			Writer& Add(int value);
+			Writer& Add(unsigned int value);
+			Writer& Add(float value);
+
+			// Message terminated by '\0'
+			const char *CStr() const;
+			// Length of message
+			size_t Size() const;
+			// False if message was truncated as buffer is full
+			bool Ok() const;
+
+		private:
+			// Start a new token and return where to write
+			char *Begin();
+			// End token written until end
+			void End(char *end);
+
+			char *buffer_;
+			size_t capacity_;  // size of buffer without '\0'
+			size_t size_;
+			bool ok_;
+		};
+
+		// Write 'POSITION x0 y0 ... x15 y15'
+		DLLAPI size_t FormatPosition(const GameState &gs, char *buffer, size_t size);
+		// Write 'SETSTATE shot c_end l_end move'
+		DLLAPI size_t FormatSetState(const GameState &gs, char *buffer, size_t size);
+		// Write 'GO timelimit1 timelimit2'
+		DLLAPI size_t FormatGo(int time_remain1, int time_remain2, char *buffer, size_t size);
+		// Write 'BESTSHOT x y angle'
+		DLLAPI size_t FormatBestShot(const ShotVec &vec, char *buffer, size_t size);
+
+		// Read 'POSITION x0 y0 ... x15 y15' to gs->body
+		DLLAPI bool ParsePosition(const Tokens &tokens, GameState *gs);
+		// Read 'SETSTATE shot c_end l_end move' to gs
+		DLLAPI bool ParseSetState(const Tokens &tokens, GameState *gs);
+		// Read 'BESTSHOT x y angle' to vec
+		DLLAPI bool ParseBestShot(const Tokens &tokens, ShotVec *vec);
+
+		// Frames of binary DCP and network transport (see DCP.md)
+		//  Frame: length of rest (4 bytes) | type (1 byte) | sequence number (4 bytes) | data
+		//  Integers of header are big endian, numbers in data are little endian (float: IEEE 754 binary32)
+		constexpr size_t kFrameHeaderSize = 9;
+		constexpr char kBinaryVersion[] = "BIN1";  // 'ISREADY BIN1' and 'READYOK BIN1' to use binary DCP
+
+		// Type of frame
+		enum : unsigned char {
+			FRAME_MESSAGE  = 1,  // DCP message (text without '\0')
+			FRAME_ACK      = 2,  // acknowledgement of a frame (only network transport)
+			FRAME_STATE    = 3,  // instead of 'POSITION' and 'SETSTATE' (binary DCP)
+			FRAME_GO       = 4,  // instead of 'GO' (binary DCP)
+			FRAME_BESTSHOT = 5   // instead of 'BESTSHOT' (binary DCP)
+		};
+
+		// Size of data of frames
+		constexpr size_t kStateSize = 144;  // shot, c_end, l_end, move (uint32), x0, y0, ... x15, y15 (float)
+		constexpr size_t kGoSize = 8;       // timelimit1, timelimit2 (int32)
+		constexpr size_t kShotSize = 12;    // x, y (float), angle (uint32)
+
+		// Frame decoded by ReadFrame() (data points to the buffer)
+		struct Frame {
+			unsigned char type;
+			uint32_t seq;
+			const char *data;
+			size_t size;
+		};
+
+		// Write a frame to buffer (returns size of the frame, or 0 if buffer is too small)
+		DLLAPI size_t WriteFrame(unsigned char type, uint32_t seq, const void *data, size_t size, char *buffer, size_t buffer_size);
+		// Read a frame at the head of received bytes (returns size of the frame, or 0 if it is not received wholly)
+		DLLAPI size_t ReadFrame(const char *buffer, size_t buffer_size, Frame *frame);
+
+		// Data of FRAME_STATE
+		DLLAPI void EncodeState(const GameState &gs, char *data);
+		DLLAPI bool DecodeState(const char *data, size_t size, GameState *gs);
+		// Data of FRAME_GO
+		DLLAPI void EncodeGo(int time_remain1, int time_remain2, char *data);
+		DLLAPI bool DecodeGo(const char *data, size_t size, int *time_remain1, int *time_remain2);
+		// Data of FRAME_BESTSHOT
+		DLLAPI void EncodeShot(const ShotVec &vec, char *data);
+		DLLAPI bool DecodeShot(const char *data, size_t size, ShotVec *vec);
+	}
+}
@@ -0,0 +1,355 @@
+#include "dcurling_evaluator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <thread>
+
+namespace digital_curling {
+
+	namespace search {
+
+		// Inverse of standard normal CDF (Acklam's approximation, relative error < 1.2e-9)
+		double InverseNormalCdf(double p) {
+			static const double a[] = { -3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02, 1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00 };
+			static const double b[] = { -5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02, 6.680131188771972e+01, -1.328068155288572e+01 };
+			static const double c[] = { -7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00, -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00 };
+			static const double d[] = { 7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00, 3.754408661907416e+00 };
+			const double p_low = 0.02425;
+
+			if (p < p_low) {
+				double q = sqrt(-2.0 * log(p));
+				return (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+					((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+			}
+			else if (p <= 1.0 - p_low) {
+				double q = p - 0.5;
+				double r = q * q;
+				return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+					(((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+			}
+			else {
+				double q = sqrt(-2.0 * log(1.0 - p));
+				return -(((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+					((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+			}
+		}
+
+		// Keep u in (0, 1) for InverseNormalCdf()
+		inline double ClampUnit(double u) {
+			const double eps = 1e-12;
+			return std::min(std::max(u, eps), 1.0 - eps);
+		}
+
+		// First two dimensions of Sobol sequence
+		void Sobol2D(uint32_t index, double *u1, double *u2) {
+			uint32_t x1 = 0;
+			uint32_t x2 = 0;
+			uint32_t v1 = 1u << 31;  // direction number of dimension 1 (van der Corput)
+			uint32_t v2 = 1u << 31;  // direction number of dimension 2 (polynomial x + 1)
+			for (uint32_t i = index; i != 0; i >>= 1) {
+				if (i & 1) {
+					x1 ^= v1;
+					x2 ^= v2;
+				}
+				v1 >>= 1;
+				v2 ^= v2 >> 1;
+			}
+			*u1 = x1 / 4294967296.0;
+			*u2 = x2 / 4294967296.0;
+		}
+
+		/*** Member functions of class 'NoiseSamples' ***/
+
+		NoiseSamples::NoiseSamples() :
+			scheme_(INDEPENDENT) {}
+
+		NoiseSamples::NoiseSamples(unsigned int num, int scheme, unsigned int seed) {
+			Generate(num, scheme, seed);
+		}
+
+		NoiseSamples::~NoiseSamples() {}
+
+		// Generate num samples of (r1, r2) ~ N(0, 1)
+		void NoiseSamples::Generate(unsigned int num, int scheme, unsigned int seed) {
+			std::mt19937 engine(seed);
+			std::normal_distribution<float> normal(0.0f, 1.0f);
+			std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+			scheme_ = scheme;
+			if (scheme == ANTITHETIC) {
+				num += num % 2;
+			}
+			r1_.resize(num);
+			r2_.resize(num);
+
+			switch (scheme) {
+			case ANTITHETIC:
+				for (unsigned int k = 0; k < num; k += 2) {
+					r1_[k] = normal(engine);
+					r2_[k] = normal(engine);
+					r1_[k + 1] = -r1_[k];
+					r2_[k + 1] = -r2_[k];
+				}
+				break;
+			case STRATIFIED: {
+				// One sample in each of num strata for each axis
+				std::vector<unsigned int> perm(num);
+				std::iota(perm.begin(), perm.end(), 0);
+				std::shuffle(perm.begin(), perm.end(), engine);
+				for (unsigned int k = 0; k < num; k++) {
+					double u1 = (k + uniform(engine)) / num;
+					double u2 = (perm[k] + uniform(engine)) / num;
+					r1_[k] = (float)InverseNormalCdf(ClampUnit(u1));
+					r2_[k] = (float)InverseNormalCdf(ClampUnit(u2));
+				}
+				break;
+			}
+			case SOBOL: {
+				// Random shift (Cranley-Patterson rotation) keeps estimate unbiased
+				double shift1 = uniform(engine);
+				double shift2 = uniform(engine);
+				for (unsigned int k = 0; k < num; k++) {
+					double u1, u2;
+					Sobol2D(k, &u1, &u2);
+					u1 += shift1;
+					u2 += shift2;
+					r1_[k] = (float)InverseNormalCdf(ClampUnit(u1 - floor(u1)));
+					r2_[k] = (float)InverseNormalCdf(ClampUnit(u2 - floor(u2)));
+				}
+				break;
+			}
+			default:
+				for (unsigned int k = 0; k < num; k++) {
+					r1_[k] = normal(engine);
+					r2_[k] = normal(engine);
+				}
+				break;
+			}
+		}
+
+		// Number of samples
+		size_t NoiseSamples::Size() const {
+			return r1_.size();
+		}
+
+		// Add sample k to ShotVec
+		void NoiseSamples::Apply(b2simulator::Simulator *sim, size_t k, float random_1, float random_2, ShotVec* const vec) const {
+			sim->AddNoise2Vec(random_1 * r1_[k], random_2 * r2_[k], vec);
+		}
+
+		// Score of the end for the player who delivered the shot
+		float ScoreValue(const GameState &before, const GameState &after) {
+			// GetScore() is positive when odd-numbered (second player's) stones score
+			int score = b2simulator::Simulator::GetScore(&after);
+			return (float)((before.ShotNum % 2 == 1) ? score : -score);
+		}
+
+		// Get z value for two-sided confidence level
+		double ConfidenceZ(double confidence) {
+			return InverseNormalCdf(0.5 + 0.5 * confidence);
+		}
+
+		// Estimate mean of values
+		Estimate EstimateMean(const std::vector<float> &values, int scheme, double confidence) {
+			// Average antithetic pairs, which are independent of each other
+			std::vector<double> x;
+			if (scheme == ANTITHETIC) {
+				for (size_t k = 0; k + 1 < values.size(); k += 2) {
+					x.push_back(0.5 * ((double)values[k] + values[k + 1]));
+				}
+			}
+			else {
+				x.assign(values.begin(), values.end());
+			}
+
+			Estimate e;
+			e.num = (unsigned int)x.size();
+			e.mean = 0.0;
+			e.std_error = 0.0;
+			if (e.num > 0) {
+				e.mean = std::accumulate(x.begin(), x.end(), 0.0) / e.num;
+			}
+			if (e.num > 1) {
+				double ss = 0.0;
+				for (double v : x) {
+					ss += (v - e.mean) * (v - e.mean);
+				}
+				e.std_error = sqrt(ss / (e.num - 1) / e.num);
+			}
+			double z = ConfidenceZ(confidence);
+			e.lower = e.mean - z * e.std_error;
+			e.upper = e.mean + z * e.std_error;
+
+			return e;
+		}
+
+		// Estimate difference (a - b) of two shots evaluated with same samples
+		Estimate EstimateDifference(const ShotEvaluation &a, const ShotEvaluation &b, int scheme, double confidence) {
+			size_t num = std::min(a.values.size(), b.values.size());
+			std::vector<float> diff(num);
+			for (size_t k = 0; k < num; k++) {
+				diff[k] = a.values[k] - b.values[k];
+			}
+			return EstimateMean(diff, scheme, confidence);
+		}
+
+		// Evaluate candidate shots with same samples
+		void EvaluateShots(
+			b2simulator::Simulator *sim, const GameState &gs,
+			const ShotVec *shots, size_t num_shots,
+			float random_1, float random_2,
+			const NoiseSamples &samples, const ValueFunc &value,
+			double confidence, ShotEvaluation *results) {
+
+			for (size_t i = 0; i < num_shots; i++) {
+				ShotEvaluation &result = results[i];
+				result.shot = shots[i];
+				result.values.resize(samples.Size());
+
+				for (size_t k = 0; k < samples.Size(); k++) {
+					GameState gs_after = gs;
+					ShotVec vec = shots[i];
+					samples.Apply(sim, k, random_1, random_2, &vec);
+					sim->Simulation(&gs_after, vec, 0.0f, 0.0f, nullptr, nullptr);
+					result.values[k] = value(gs, gs_after);
+				}
+
+				result.estimate = EstimateMean(result.values, samples.scheme_, confidence);
+			}
+		}
+	
+		RaceOptions::RaceOptions() :
+			batch(16),
+			max_samples(256),
+			time_limit(1000),
+			num_threads(0),
+			min_survivors(1),
+			scheme(ANTITHETIC),
+			confidence(0.95),
+			halving(false),
+			seed(std::random_device()()) {}
+
+		// Run fn(0) ... fn(num_tasks - 1) on threads
+		void ParallelFor(size_t num_tasks, unsigned int num_threads, const std::function<void(size_t)> &fn) {
+			std::atomic<size_t> next(0);
+			auto worker = [&]() {
+				for (size_t t = next++; t < num_tasks; t = next++) {
+					fn(t);
+				}
+			};
+
+			std::vector<std::thread> threads;
+			for (unsigned int i = 1; i < num_threads; i++) {
+				threads.emplace_back(worker);
+			}
+			worker();
+			for (std::thread &th : threads) {
+				th.join();
+			}
+		}
+
+		// Evaluate candidates in rounds and drop candidates which are dominated by the best
+		std::vector<RaceResult> RaceShots(
+			b2simulator::Simulator *sim, const GameState &gs,
+			const std::vector<ShotVec> &candidates,
+			float random_1, float random_2,
+			const ValueFunc &value, const RaceOptions &options) {
+
+			auto time_start = std::chrono::steady_clock::now();
+			auto elapsed = [&time_start]() {
+				return std::chrono::duration_cast<std::chrono::milliseconds>(
+					std::chrono::steady_clock::now() - time_start).count();
+			};
+
+			unsigned int num_threads = options.num_threads;
+			if (num_threads == 0) {
+				num_threads = std::max(1u, std::thread::hardware_concurrency());
+			}
+			unsigned int batch = std::max(1u, options.batch);
+			if (options.scheme == ANTITHETIC) {
+				batch += batch % 2;  // keep pairs in a round
+			}
+
+			// Samples are shared by all candidates in each round
+			NoiseSamples samples(std::max(options.max_samples, batch), options.scheme, options.seed);
+
+			std::vector<ShotEvaluation> evals(candidates.size());
+			std::vector<size_t> survivors(candidates.size());
+			std::iota(survivors.begin(), survivors.end(), 0);
+			for (size_t i = 0; i < candidates.size(); i++) {
+				evals[i].shot = candidates[i];
+				evals[i].estimate = EstimateMean(evals[i].values, options.scheme, options.confidence);
+			}
+
+			size_t num_samples = 0;
+			while (survivors.size() > options.min_survivors &&
+				num_samples < samples.Size() &&
+				elapsed() < (long long)options.time_limit) {
+
+				// Run simulations of this round
+				size_t begin = num_samples;
+				size_t end = std::min(num_samples + batch, samples.Size());
+				for (size_t i : survivors) {
+					evals[i].values.resize(end);
+				}
+				ParallelFor(survivors.size() * (end - begin), num_threads, [&](size_t t) {
+					size_t i = survivors[t / (end - begin)];
+					size_t k = begin + t % (end - begin);
+					GameState gs_after = gs;
+					ShotVec vec = candidates[i];
+					samples.Apply(sim, k, random_1, random_2, &vec);
+					sim->Simulation(&gs_after, vec, 0.0f, 0.0f, nullptr, nullptr);
+					evals[i].values[k] = value(gs, gs_after);
+				});
+				num_samples = end;
+
+				for (size_t i : survivors) {
+					evals[i].estimate = EstimateMean(evals[i].values, options.scheme, options.confidence);
+				}
+
+				// Sort survivors by mean (best first)
+				std::stable_sort(survivors.begin(), survivors.end(), [&evals](size_t a, size_t b) {
+					return evals[a].estimate.mean > evals[b].estimate.mean;
+				});
+
+				// Drop candidates which are worse than the best with confidence (paired by samples)
+				const ShotEvaluation &best = evals[survivors[0]];
+				std::vector<size_t> next;
+				next.push_back(survivors[0]);
+				for (size_t n = 1; n < survivors.size(); n++) {
+					Estimate diff = EstimateDifference(best, evals[survivors[n]], options.scheme, options.confidence);
+					if (!(diff.lower > 0.0)) {
+						next.push_back(survivors[n]);
+					}
+				}
+				if (options.halving && next.size() > options.min_survivors) {
+					size_t half = std::max<size_t>((next.size() + 1) / 2, std::max(1u, options.min_survivors));
+					next.resize(std::min(next.size(), half));
+				}
+				survivors.swap(next);
+			}
+
+			// Survivors first, then dropped candidates (each in order of mean)
+			std::vector<RaceResult> results(candidates.size());
+			for (size_t i = 0; i < candidates.size(); i++) {
+				results[i].index = i;
+				results[i].shot = candidates[i];
+				results[i].estimate = evals[i].estimate;
+				results[i].survived = std::find(survivors.begin(), survivors.end(), i) != survivors.end();
+			}
+			std::stable_sort(results.begin(), results.end(), [](const RaceResult &a, const RaceResult &b) {
+				if (a.survived != b.survived) {
+					return a.survived;
+				}
+				return a.estimate.mean > b.estimate.mean;
+			});
+
+			return results;
+		}
+	}
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "dcurling_simulator.h"
+
+#include <functional>
+#include <vector>
+
+namespace digital_curling {
+
+	// Search utilities with the simulator
+	namespace search {
+
+		// Scheme of sampling random numbers
+		enum {
+			INDEPENDENT,  // independent normal random numbers
+			ANTITHETIC,   // pairs of (r1, r2) and (-r1, -r2)
+			STRATIFIED,   // latin hypercube in (r1, r2) space
+			SOBOL         // Sobol sequence with random shift in (r1, r2) space
+		};
+
+		// Standard normal random numbers which are shared by all candidate shots (common random numbers)
+		class DLLAPI NoiseSamples {
+		public:
+			NoiseSamples();
+			NoiseSamples(unsigned int num, int scheme, unsigned int seed);
+			~NoiseSamples();
+
+			// Generate num samples of (r1, r2) ~ N(0, 1) with scheme
+			//  (num is rounded up to even number for ANTITHETIC)
+			void Generate(unsigned int num, int scheme, unsigned int seed);
+
+			// Number of samples
+			size_t Size() const;
+
+			// Add sample k to ShotVec (random_1, random_2 : size of random number of the player)
+			void Apply(b2simulator::Simulator *sim, size_t k, float random_1, float random_2, ShotVec* const vec) const;
+
+			int scheme_;             // Scheme of sampling
+			std::vector<float> r1_;  // random number for random_1 (x or v)
+			std::vector<float> r2_;  // random number for random_2 (y or theta)
+		};
+
+		// Mean with confidence interval
+		struct Estimate {
+			double mean;       // mean of values
+			double std_error;  // standard error of mean
+			double lower;      // lower bound of confidence interval
+			double upper;      // upper bound of confidence interval
+			unsigned int num;  // number of samples
+		};
+
+		// Value of state after a shot for the player who delivered it
+		typedef std::function<float(const GameState &before, const GameState &after)> ValueFunc;
+
+		// Score of the end for the player who delivered the shot (default ValueFunc)
+		DLLAPI float ScoreValue(const GameState &before, const GameState &after);
+
+		// Evaluation of a candidate shot
+		struct ShotEvaluation {
+			ShotVec shot;               // candidate shot
+			std::vector<float> values;  // value for each sample (same order as NoiseSamples)
+			Estimate estimate;          // mean of values
+		};
+
+		// Get z value for two-sided confidence level (e.g. 0.95 -> 1.96)
+		DLLAPI double ConfidenceZ(double confidence);
+
+		// Estimate mean of values (pairs are averaged at first for ANTITHETIC)
+		//  Note: interval is conservative for STRATIFIED and SOBOL (treated as independent)
+		DLLAPI Estimate EstimateMean(const std::vector<float> &values, int scheme, double confidence);
+
+		// Estimate difference (a - b) of two shots evaluated with same samples
+		DLLAPI Estimate EstimateDifference(const ShotEvaluation &a, const ShotEvaluation &b, int scheme, double confidence);
+
+		// Evaluate candidate shots with same samples
+		// - GameState gs                 : state before the shot
+		// - ShotVec* shots, num_shots    : candidate shots
+		// - float random_1, random_2     : size of random number of the player
+		// - NoiseSamples samples         : random numbers shared by all candidates
+		// - ValueFunc value              : value of state after the shot
+		// - ShotEvaluation* results      : result for each candidate (pass ShotEvaluation[num_shots])
+		DLLAPI void EvaluateShots(
+			b2simulator::Simulator *sim, const GameState &gs,
+			const ShotVec *shots, size_t num_shots,
+			float random_1, float random_2,
+			const NoiseSamples &samples, const ValueFunc &value,
+			double confidence, ShotEvaluation *results);
+
+		// Run fn(0) ... fn(num_tasks - 1) on num_threads threads (including the caller)
+		//  Simulation(), CreateShot() and CreateHitShot() of a simulator do not change it, so these threads may call them
+		//  at the same time (Box2D builds its shared tables once and its statistics are atomic, see Box2D/Collision)
+		//  Members of the simulator (e.g. random_type_) must not be changed while they are running
+		DLLAPI void ParallelFor(size_t num_tasks, unsigned int num_threads, const std::function<void(size_t)> &fn);
+
+		// Options for RaceShots()
+		struct DLLAPI RaceOptions {
+			RaceOptions();
+
+			unsigned int batch;          // samples added to each survivor in a round
+			unsigned int max_samples;    // max number of samples for a candidate
+			unsigned int time_limit;     // time budget [msec]
+			unsigned int num_threads;    // number of threads (0: number of cores)
+			unsigned int min_survivors;  // stop if number of survivors is less than or equal to this
+			int scheme;                  // scheme of sampling
+			double confidence;           // confidence level to drop candidates
+			bool halving;                // drop worse half of survivors in each round (successive halving)
+			unsigned int seed;           // seed for NoiseSamples
+		};
+
+		// Result of RaceShots() for a candidate
+		struct RaceResult {
+			size_t index;       // index in candidates
+			ShotVec shot;       // candidate shot
+			Estimate estimate;  // mean of values with confidence interval
+			bool survived;      // true if not dropped
+		};
+
+		// Evaluate candidates in rounds and drop candidates which are dominated by the best
+		//  returns results of all candidates (survivors first, in order of mean)
+		DLLAPI std::vector<RaceResult> RaceShots(
+			b2simulator::Simulator *sim, const GameState &gs,
+			const std::vector<ShotVec> &candidates,
+			float random_1, float random_2,
+			const ValueFunc &value, const RaceOptions &options);
+	}
+}
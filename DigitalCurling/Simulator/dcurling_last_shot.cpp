@@ -0,0 +1,303 @@
+#include "dcurling_last_shot.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <thread>
+
+namespace digital_curling {
+
+	namespace search {
+
+		LastShotOptions::LastShotOptions() :
+			draw_spacing(2.0f * kStoneR),
+			hit_weights{ 8.0f, 16.0f, 32.0f, 48.0f },
+			hit_offsets{ -0.5f * kStoneR, 0.0f, 0.5f * kStoneR },
+			path_margin(kStoneR),
+			screen_samples(4),
+			refine_top(8),
+			race_candidates(16) {
+			race.time_limit = 3000;
+		}
+
+		namespace {
+
+			// Candidate of last shot
+			struct Candidate {
+				ShotPos target;  // position where stone stops (draw) or passes (hit)
+				float weight;    // weight of hit shot (0: draw shot)
+				int stone;       // stone to hit (-1: draw shot)
+				ShotVec vec;
+				bool pruned;
+				float value;     // mean of values of screening
+			};
+
+			// Points of trajectory of the delivered stone
+			class PathSink : public b2simulator::TrajectorySink {
+			public:
+				PathSink() : TrajectorySink(5) {}
+				void OnStep(int, const float *positions, unsigned int num_stones) {
+					points.push_back(ShotPos(positions[2 * (num_stones - 1)], positions[2 * (num_stones - 1) + 1], false));
+				}
+				std::vector<ShotPos> points;
+			};
+
+			// Path of a shot without other stones, and the point of it which is moved to target of candidates
+			struct ReferencePath {
+				std::vector<ShotPos> points;
+				ShotPos anchor;
+			};
+
+			// Trajectory of vec on an empty sheet until it passes anchor (or stops)
+			ReferencePath MakeReferencePath(b2simulator::Simulator *sim, const ShotVec &vec, const ShotPos &anchor) {
+				GameState gs(1);
+				PathSink sink;
+				sim->Simulation(&gs, vec, 0.0f, 0.0f, nullptr, &sink);
+
+				ReferencePath path;
+				path.anchor = anchor;
+				for (const ShotPos &p : sink.points) {
+					path.points.push_back(p);
+					if (p.y < anchor.y) {
+						break;
+					}
+				}
+				return path;
+			}
+
+			// Distance from p to segment ab
+			float SegmentDistance(const ShotPos &p, const ShotPos &a, const ShotPos &b) {
+				float dx = b.x - a.x;
+				float dy = b.y - a.y;
+				float len2 = dx * dx + dy * dy;
+				float t = (len2 > 0.0f) ? std::clamp(((p.x - a.x) * dx + (p.y - a.y) * dy) / len2, 0.0f, 1.0f) : 0.0f;
+				float ex = a.x + t * dx - p.x;
+				float ey = a.y + t * dy - p.y;
+				return std::sqrt(ex * ex + ey * ey);
+			}
+
+			// True if a stone other than the target is on the path to the target
+			//  The reference path is rotated and scaled around its start so that its anchor is on the target
+			//  (the shape of curl is nearly the same for shots of similar speed)
+			bool IsBlocked(const GameState &gs, const Candidate &c, const ReferencePath &ref, float margin) {
+				if (ref.points.size() < 2) {
+					return false;
+				}
+				const ShotPos &s = ref.points[0];
+				float ax = ref.anchor.x - s.x, ay = ref.anchor.y - s.y;
+				float tx = c.target.x - s.x, ty = c.target.y - s.y;
+				float a2 = ax * ax + ay * ay;
+				if (a2 == 0.0f) {
+					return false;
+				}
+				// Complex multiplication by (t / a)
+				float re = (tx * ax + ty * ay) / a2;
+				float im = (ty * ax - tx * ay) / a2;
+
+				const float block = 2.0f * kStoneR - margin;
+				const float contact = 2.0f * kStoneR;
+				ShotPos prev = s;
+				for (size_t n = 1; n < ref.points.size(); n++) {
+					float px = ref.points[n].x - s.x, py = ref.points[n].y - s.y;
+					ShotPos p(s.x + px * re - py * im, s.y + px * im + py * re, false);
+
+					for (unsigned int i = 0; i < gs.ShotNum; i++) {
+						ShotPos stone(gs.body[i][0], gs.body[i][1], false);
+						if ((int)i == c.stone || !(b2simulator::GetStoneArea(stone) & b2simulator::IN_PLAYAREA)) {
+							continue;
+						}
+						if (SegmentDistance(stone, prev, p) < block) {
+							return true;
+						}
+					}
+					// Stop at contact with the target stone
+					if (c.stone >= 0 && std::hypot(p.x - c.target.x, p.y - c.target.y) < contact) {
+						break;
+					}
+					prev = p;
+				}
+				return false;
+			}
+		}
+
+		// Best shot for the last stone by expected score of the end
+		LastShotResult SolveLastShot(
+			b2simulator::Simulator *sim, const GameState &gs,
+			float random_1, float random_2, const LastShotOptions &options) {
+
+			auto time_start = std::chrono::steady_clock::now();
+			auto elapsed = [&time_start]() {
+				return std::chrono::duration_cast<std::chrono::milliseconds>(
+					std::chrono::steady_clock::now() - time_start).count();
+			};
+			// Screening may use half of time, the rest is for race
+			const long long screen_limit = options.race.time_limit / 2;
+
+			unsigned int num_threads = options.race.num_threads;
+			if (num_threads == 0) {
+				num_threads = std::max(1u, std::thread::hardware_concurrency());
+			}
+
+			// Reference paths of draw shots (to the tee) and hit shots (through the tee) for each curl
+			const ShotPos tee(kCenterX, kTeeY, false);
+			ReferencePath draw_path[2];
+			std::vector<ReferencePath> hit_path[2];
+			for (int angle = 0; angle < 2; angle++) {
+				ShotVec vec;
+				sim->CreateShot(ShotPos(kCenterX, kTeeY, angle != 0), &vec);
+				draw_path[angle] = MakeReferencePath(sim, vec, tee);
+				for (float weight : options.hit_weights) {
+					sim->CreateHitShot(ShotPos(kCenterX, kTeeY, angle != 0), weight, &vec);
+					hit_path[angle].push_back(MakeReferencePath(sim, vec, tee));
+				}
+			}
+
+			// Enumerate draw shots on grid in the house, and hit shots to stones in play
+			std::vector<Candidate> candidates;
+			auto add_draw = [&candidates](float x, float y, bool angle) {
+				candidates.push_back({ ShotPos(x, y, angle), 0.0f, -1, ShotVec(), false, 0.0f });
+			};
+			auto add_hit = [&candidates](float x, float y, bool angle, float weight, int stone) {
+				candidates.push_back({ ShotPos(x, y, angle), weight, stone, ShotVec(), false, 0.0f });
+			};
+			float spacing = std::max(options.draw_spacing, 0.01f);
+			int grid = (int)std::ceil((kHouseR + kStoneR) / spacing);
+			for (int angle = 0; angle < 2; angle++) {
+				for (int gx = -grid; gx <= grid; gx++) {
+					for (int gy = -grid; gy <= grid; gy++) {
+						if (std::hypot(gx * spacing, gy * spacing) < kHouseR + kStoneR) {
+							add_draw(kCenterX + gx * spacing, kTeeY + gy * spacing, angle != 0);
+						}
+					}
+				}
+				for (unsigned int i = 0; i < gs.ShotNum && i < 16; i++) {
+					ShotPos stone(gs.body[i][0], gs.body[i][1], angle != 0);
+					if (!(b2simulator::GetStoneArea(stone) & b2simulator::IN_PLAYAREA)) {
+						continue;
+					}
+					for (float weight : options.hit_weights) {
+						for (float offset : options.hit_offsets) {
+							add_hit(stone.x + offset, stone.y, angle != 0, weight, (int)i);
+						}
+					}
+				}
+			}
+
+			LastShotResult result;
+			result.num_pruned = 0;
+			result.num_simulations = 0;
+			std::atomic<unsigned int> num_simulations(0);
+
+			// Create shots, prune blocked paths and screen candidates [begin, end) with samples
+			//  Candidates are screened in shuffled order, so the time limit does not cut off a whole kind of shots
+			NoiseSamples samples(std::max(1u, options.screen_samples), ANTITHETIC, options.race.seed);
+			std::mt19937 engine(options.race.seed);
+			auto screen = [&](size_t begin, size_t end) {
+				std::vector<size_t> shuffled(end - begin);
+				std::iota(shuffled.begin(), shuffled.end(), begin);
+				std::shuffle(shuffled.begin(), shuffled.end(), engine);
+				ParallelFor(shuffled.size(), num_threads, [&](size_t t) {
+					Candidate &c = candidates[shuffled[t]];
+					int angle = (c.target.angle) ? 1 : 0;
+					const ReferencePath *ref = &draw_path[angle];
+					if (c.stone < 0) {
+						sim->CreateShot(c.target, &c.vec);
+					}
+					else {
+						sim->CreateHitShot(c.target, c.weight, &c.vec);
+						size_t weight_index = std::min_element(options.hit_weights.begin(), options.hit_weights.end(), [&c](float a, float b) {
+							return std::fabs(a - c.weight) < std::fabs(b - c.weight);
+						}) - options.hit_weights.begin();
+						ref = &hit_path[angle][weight_index];
+					}
+					c.pruned = (c.vec.x == 0.0f && c.vec.y == 0.0f) || IsBlocked(gs, c, *ref, options.path_margin);
+					if (c.pruned || elapsed() >= screen_limit) {
+						c.value = -std::numeric_limits<float>::infinity();
+						return;
+					}
+
+					double sum = 0.0;
+					for (size_t k = 0; k < samples.Size(); k++) {
+						GameState after = gs;
+						ShotVec vec = c.vec;
+						samples.Apply(sim, k, random_1, random_2, &vec);
+						sim->Simulation(&after, vec, 0.0f, 0.0f, nullptr, nullptr);
+						sum += ScoreValue(gs, after);
+					}
+					c.value = (float)(sum / samples.Size());
+					num_simulations += (unsigned int)samples.Size();
+				});
+				for (size_t i = begin; i < end; i++) {
+					result.num_pruned += (candidates[i].pruned) ? 1 : 0;
+				}
+			};
+			auto by_value = [&candidates](size_t a, size_t b) {
+				return candidates[a].value > candidates[b].value;
+			};
+			screen(0, candidates.size());
+
+			// Neighbours of the best candidates (target moved by half of spacing, or offset and weight of hit)
+			std::vector<size_t> order(candidates.size());
+			std::iota(order.begin(), order.end(), 0);
+			size_t num_top = std::min<size_t>(options.refine_top, order.size());
+			std::partial_sort(order.begin(), order.begin() + num_top, order.end(), by_value);
+			size_t num_screened = candidates.size();
+			for (size_t n = 0; n < num_top; n++) {
+				Candidate c = candidates[order[n]];
+				if (c.pruned) {
+					break;
+				}
+				if (c.stone < 0) {
+					float d = 0.5f * spacing;
+					add_draw(c.target.x - d, c.target.y, c.target.angle);
+					add_draw(c.target.x + d, c.target.y, c.target.angle);
+					add_draw(c.target.x, c.target.y - d, c.target.angle);
+					add_draw(c.target.x, c.target.y + d, c.target.angle);
+				}
+				else {
+					float d = 0.25f * kStoneR;
+					add_hit(c.target.x - d, c.target.y, c.target.angle, c.weight, c.stone);
+					add_hit(c.target.x + d, c.target.y, c.target.angle, c.weight, c.stone);
+					add_hit(c.target.x, c.target.y, c.target.angle, c.weight * 0.8f, c.stone);
+					add_hit(c.target.x, c.target.y, c.target.angle, c.weight * 1.25f, c.stone);
+				}
+			}
+			screen(num_screened, candidates.size());
+			result.num_candidates = (unsigned int)candidates.size();
+
+			// Race the best candidates in the rest of time
+			order.resize(candidates.size());
+			std::iota(order.begin(), order.end(), 0);
+			std::stable_sort(order.begin(), order.end(), by_value);
+			std::vector<ShotVec> finalists;
+			for (size_t n = 0; n < order.size() && finalists.size() < std::max(1u, options.race_candidates); n++) {
+				if (!candidates[order[n]].pruned || finalists.empty()) {
+					finalists.push_back(candidates[order[n]].vec);
+				}
+			}
+			if (finalists.empty()) {
+				// No stone in play and no draw (e.g. draw_spacing too large)
+				sim->CreateShot(ShotPos(kCenterX, kTeeY, false), &result.shot);
+				result.estimate = EstimateMean(std::vector<float>(), options.race.scheme, options.race.confidence);
+				return result;
+			}
+
+			RaceOptions race = options.race;
+			race.num_threads = num_threads;
+			race.time_limit = (unsigned int)std::max(0LL, (long long)options.race.time_limit - elapsed());
+			std::vector<RaceResult> results = RaceShots(sim, gs, finalists, random_1, random_2, ScoreValue, race);
+
+			result.shot = results[0].shot;
+			result.estimate = results[0].estimate;
+			result.num_simulations = num_simulations;
+			for (const RaceResult &r : results) {
+				result.num_simulations += r.estimate.num * ((race.scheme == ANTITHETIC) ? 2 : 1);
+			}
+			return result;
+		}
+	}
+}
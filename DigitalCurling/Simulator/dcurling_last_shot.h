@@ -0,0 +1,45 @@
+#pragma once
+
+#include "dcurling_simulator.h"
+#include "dcurling_evaluator.h"
+
+#include <vector>
+
+namespace digital_curling {
+
+	namespace search {
+
+		// Options for SolveLastShot()
+		struct DLLAPI LastShotOptions {
+			LastShotOptions();
+
+			float draw_spacing;               // spacing of grid of draw shots in the house [m]
+			std::vector<float> hit_weights;   // weights of hit shots to each stone
+			std::vector<float> hit_offsets;   // offsets of hit shots in x from center of stone [m]
+			float path_margin;                // path is blocked if a stone is closer than 2 * kStoneR - path_margin [m]
+			unsigned int screen_samples;      // samples to screen each candidate
+			unsigned int refine_top;          // number of best candidates whose neighbours are screened
+			unsigned int race_candidates;     // number of best candidates raced at last
+			RaceOptions race;                 // options of race (time_limit is for whole search, num_threads and seed are shared)
+		};
+
+		// Result of SolveLastShot()
+		struct LastShotResult {
+			ShotVec shot;                     // best shot
+			Estimate estimate;                // expected score of the end with the best shot
+			unsigned int num_candidates;      // number of candidates enumerated (including neighbours)
+			unsigned int num_pruned;          // number of candidates pruned by paths
+			unsigned int num_simulations;     // number of simulations
+		};
+
+		// Best shot for the last stone (ShotNum 15) by expected score of the end
+		//  1. Draw shots on a grid over the house and hit shots to every stone in play (with weights and offsets)
+		//  2. Candidates whose path to the target is blocked by a stone are pruned (without simulation)
+		//  3. Candidates are screened with a few samples of noise, neighbours of the best are added
+		//  4. The best candidates are raced with RaceShots() in the rest of time
+		// - float random_1, random_2 : size of random number of the player
+		DLLAPI LastShotResult SolveLastShot(
+			b2simulator::Simulator *sim, const GameState &gs,
+			float random_1, float random_2, const LastShotOptions &options);
+	}
+}
@@ -0,0 +1,429 @@
+#include "dcurling_mcts.h"
+#include "dcurling_evaluator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <tuple>
+
+namespace digital_curling {
+
+	namespace search {
+
+		namespace {
+			const uint32_t kNoNode = 0xFFFFFFFF;
+
+			// Node of tree (shot from parent, statistics for the player who delivered the shot)
+			struct Node {
+				ShotVec shot;
+				uint32_t first_child;
+				uint32_t next_sibling;
+				uint32_t num_children;
+				uint32_t visits;
+				uint32_t virtual_loss;  // visits in progress
+				double value_sum;
+			};
+
+			Node NewNode(const ShotVec &shot) {
+				return { shot, kNoNode, kNoNode, 0, 0, 0, 0.0 };
+			}
+
+			// Max distance of stones of two states
+			float StateDistance(const GameState &a, const GameState &b) {
+				float distance = 0.0f;
+				for (unsigned int i = 0; i < std::min(a.ShotNum, 16u); i++) {
+					distance = std::max(distance, std::hypot(a.body[i][0] - b.body[i][0], a.body[i][1] - b.body[i][1]));
+				}
+				return distance;
+			}
+
+			// True if gs is same position as root (positions are rounded in DCP messages)
+			bool SameState(const GameState &root, const GameState &gs) {
+				return root.ShotNum == gs.ShotNum && root.CurEnd == gs.CurEnd && root.LastEnd == gs.LastEnd &&
+					root.WhiteToMove == gs.WhiteToMove && StateDistance(root, gs) < 1e-3f;
+			}
+		}
+
+		// Arena of nodes (nodes[0] is root) and state of root
+		struct Mcts::Tree {
+			std::vector<Node> nodes;
+			uint32_t size;
+			GameState state;
+			std::mutex mutex;
+			std::mt19937 root_rng;  // shots of root are same in all trees of ROOT_PARALLEL
+		};
+
+		ShotVec RandomShot(b2simulator::Simulator *sim, const GameState &gs, std::mt19937 &rng) {
+			std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+			bool angle = uniform(rng) < 0.5f;
+
+			unsigned int in_play[16];
+			unsigned int num_in_play = 0;
+			for (unsigned int i = 0; i < gs.ShotNum && i < 16; i++) {
+				if (b2simulator::GetStoneArea(ShotPos(gs.body[i][0], gs.body[i][1], angle)) & b2simulator::IN_PLAYAREA) {
+					in_play[num_in_play++] = i;
+				}
+			}
+
+			ShotVec vec;
+			if (num_in_play > 0 && uniform(rng) < 0.5f) {
+				unsigned int i = in_play[std::uniform_int_distribution<unsigned int>(0, num_in_play - 1)(rng)];
+				float x = gs.body[i][0] + (uniform(rng) - 0.5f) * kStoneR;
+				sim->CreateHitShot(ShotPos(x, gs.body[i][1], angle), 8.0f + 24.0f * uniform(rng), &vec);
+				if (vec.x != 0.0f || vec.y != 0.0f) {
+					return vec;
+				}
+			}
+			// Draw to the house or guard zone in front of it
+			float x = kCenterX + (2.0f * uniform(rng) - 1.0f) * kHouseR;
+			float y = kTeeY - kHouseR + uniform(rng) * (2.0f * kHouseR + 2.0f);
+			sim->CreateShot(ShotPos(x, y, angle), &vec);
+			return vec;
+		}
+
+		MctsOptions::MctsOptions() :
+			mode(TREE_PARALLEL),
+			num_threads(0),
+			time_limit(1000),
+			max_iterations(0),
+			max_nodes(1 << 18),
+			exploration(1.0f),
+			widening_c(1.0f),
+			widening_alpha(0.5f),
+			virtual_loss(1.0f),
+			rollout_shots(4),
+			reuse_tolerance(kHouse4FootR),
+			win_table(nullptr),
+			generator(RandomShot),
+			seed(std::random_device()()) {}
+
+		Mcts::Mcts(b2simulator::Simulator *sim, float random_1, float random_2, const MctsOptions &options) :
+			sim_(sim), random_1_(random_1), random_2_(random_2), options_(options), num_searches_(0) {
+			num_threads_ = options.num_threads;
+			if (num_threads_ == 0) {
+				num_threads_ = std::max(1u, std::thread::hardware_concurrency());
+			}
+			if (!options_.generator) {
+				options_.generator = RandomShot;
+			}
+			options_.max_nodes = std::max(options_.max_nodes, 2u);
+			trees_.resize((options_.mode == ROOT_PARALLEL) ? num_threads_ : 1);
+		}
+
+		Mcts::~Mcts() {}
+
+		Mcts::Tree &Mcts::GetTree(unsigned int t) {
+			std::unique_ptr<Tree> &tree = trees_[(options_.mode == ROOT_PARALLEL) ? t : 0];
+			if (!tree) {
+				tree.reset(new Tree);
+				tree->nodes.resize(options_.max_nodes);
+				tree->size = 0;
+			}
+			return *tree;
+		}
+
+		MctsResult Mcts::Search(const GameState &gs) {
+			auto time_start = std::chrono::steady_clock::now();
+			auto elapsed = [&time_start]() {
+				return std::chrono::duration_cast<std::chrono::milliseconds>(
+					std::chrono::steady_clock::now() - time_start).count();
+			};
+
+			MctsResult result;
+			result.value = 0.0f;
+			result.visits = 0;
+			result.iterations = 0;
+			result.reused = 0;
+			if (gs.ShotNum >= 16) {
+				// End is over, nothing to search
+				sim_->CreateShot(ShotPos(kCenterX, kTeeY, false), &result.shot);
+				result.nodes = NumNodes();
+				return result;
+			}
+
+			// Reuse trees whose root is gs, the others start from gs
+			for (unsigned int t = 0; t < trees_.size(); t++) {
+				Tree &tree = GetTree(t);
+				if (tree.size == 0 || !SameState(tree.state, gs)) {
+					tree.nodes[0] = NewNode(ShotVec());
+					tree.size = 1;
+				}
+				tree.state = gs;
+				tree.root_rng.seed(options_.seed + num_searches_);
+				result.reused += tree.nodes[0].visits;
+			}
+
+			std::atomic<unsigned int> iterations(0);
+			auto stop = [&]() {
+				if (elapsed() >= options_.time_limit) {
+					return true;
+				}
+				return options_.max_iterations > 0 && iterations++ >= options_.max_iterations;
+			};
+			ParallelFor(num_threads_, num_threads_, [&](size_t t) {
+				std::mt19937 rng(options_.seed + 1000003u * (num_searches_ + 1) + (unsigned int)t);
+				Run(GetTree((unsigned int)t), rng, stop);
+			});
+			num_searches_++;
+			for (std::unique_ptr<Tree> &tree : trees_) {
+				result.iterations += tree->nodes[0].visits;
+			}
+			result.iterations -= result.reused;
+
+			// Merge children of roots by shot (shots of root are same in trees unless they are reused)
+			std::map<std::tuple<float, float, bool>, std::pair<uint32_t, double>> children;
+			for (std::unique_ptr<Tree> &tree : trees_) {
+				for (uint32_t c = tree->nodes[0].first_child; c != kNoNode; c = tree->nodes[c].next_sibling) {
+					const Node &child = tree->nodes[c];
+					auto &stat = children[std::make_tuple(child.shot.x, child.shot.y, child.shot.angle)];
+					stat.first += child.visits;
+					stat.second += child.value_sum;
+				}
+			}
+			auto best = std::max_element(children.begin(), children.end(), [](const auto &a, const auto &b) {
+				return a.second.first < b.second.first;
+			});
+			if (best == children.end() || best->second.first == 0) {
+				sim_->CreateShot(ShotPos(kCenterX, kTeeY, false), &result.shot);
+			}
+			else {
+				result.shot = ShotVec(std::get<0>(best->first), std::get<1>(best->first), std::get<2>(best->first));
+				result.visits = best->second.first;
+				result.value = (float)(best->second.second / best->second.first);
+			}
+			result.nodes = NumNodes();
+			return result;
+		}
+
+		// Selection and expansion under lock, simulations without lock, and backup under lock
+		void Mcts::Run(Tree &tree, std::mt19937 &rng, const std::function<bool()> &stop) {
+			std::normal_distribution<float> normal(0.0f, 1.0f);
+			std::vector<uint32_t> path;
+			const GameState &root = tree.state;
+			const unsigned int max_depth = 16 - root.ShotNum;
+
+			while (!stop()) {
+				path.clear();
+				bool expand = false;
+				ShotVec shot;
+				{
+					std::lock_guard<std::mutex> lock(tree.mutex);
+					uint32_t n = 0;
+					path.push_back(n);
+					tree.nodes[n].virtual_loss++;
+					while (path.size() <= max_depth) {
+						const Node &node = tree.nodes[n];
+						// Progressive widening
+						double visits = (double)node.visits + node.virtual_loss;
+						double width = std::max(1.0, options_.widening_c * std::pow(visits, (double)options_.widening_alpha));
+						if (node.num_children < width && tree.size < tree.nodes.size()) {
+							expand = true;
+							break;
+						}
+						if (node.first_child == kNoNode) {
+							break;
+						}
+
+						// UCT with virtual loss
+						double log_n = std::log(std::max(visits, 1.0));
+						double best_score = -std::numeric_limits<double>::infinity();
+						uint32_t best = kNoNode;
+						for (uint32_t c = node.first_child; c != kNoNode; c = tree.nodes[c].next_sibling) {
+							const Node &child = tree.nodes[c];
+							double child_n = (double)child.visits + child.virtual_loss;
+							double score = std::numeric_limits<double>::infinity();
+							if (child_n > 0.0) {
+								score = (child.value_sum - child.virtual_loss * (double)options_.virtual_loss) / child_n +
+									options_.exploration * std::sqrt(log_n / child_n);
+							}
+							if (score > best_score) {
+								best_score = score;
+								best = c;
+							}
+						}
+						n = best;
+						path.push_back(n);
+						tree.nodes[n].virtual_loss++;
+					}
+					// State of root is fixed, so shots of root are generated here
+					if (expand && n == 0) {
+						shot = options_.generator(sim_, root, tree.root_rng);
+					}
+				}
+
+				// Shots of path with new random numbers
+				GameState gs = root;
+				auto play = [&](ShotVec vec) {
+					sim_->AddNoise2Vec(random_1_ * normal(rng), random_2_ * normal(rng), &vec);
+					sim_->Simulation(&gs, vec, 0.0f, 0.0f, nullptr, nullptr);
+				};
+				for (size_t i = 1; i < path.size(); i++) {
+					play(tree.nodes[path[i]].shot);
+				}
+
+				if (expand) {
+					if (path.size() > 1) {
+						shot = options_.generator(sim_, gs, rng);
+					}
+					play(shot);
+
+					std::lock_guard<std::mutex> lock(tree.mutex);
+					if (tree.size < tree.nodes.size()) {
+						uint32_t c = tree.size++;
+						Node &parent = tree.nodes[path.back()];
+						tree.nodes[c] = NewNode(shot);
+						tree.nodes[c].next_sibling = parent.first_child;
+						tree.nodes[c].virtual_loss = 1;
+						parent.first_child = c;
+						parent.num_children++;
+						path.push_back(c);
+					}
+				}
+
+				// Rollout
+				for (unsigned int k = 0; k < options_.rollout_shots && gs.ShotNum < 16; k++) {
+					play(options_.generator(sim_, gs, rng));
+				}
+
+				// Backup (value of node is for the player who delivered its shot, who is the player at root at odd depth)
+				float value = Evaluate(root, gs);
+				std::lock_guard<std::mutex> lock(tree.mutex);
+				for (size_t i = 0; i < path.size(); i++) {
+					Node &node = tree.nodes[path[i]];
+					node.value_sum += (i % 2 == 1) ? value : -value;
+					node.visits++;
+					node.virtual_loss--;
+				}
+			}
+		}
+
+		// Value of gs for the player to move at root
+		float Mcts::Evaluate(const GameState &root, const GameState &gs) const {
+			// Score for the player who has hammer (second player of the end)
+			int score = b2simulator::Simulator::GetScore(&gs);
+			if (options_.win_table == nullptr) {
+				return (float)((root.ShotNum % 2 == 1) ? score : -score);
+			}
+
+			GameState end = gs;
+			if (end.ShotNum < 16) {
+				// Finish the end as it stands (same as Simulation() at ShotNum 16)
+				bool hammer = (end.ShotNum % 2 == 1) ? end.WhiteToMove : !end.WhiteToMove;
+				end.ShotNum = 16;
+				end.Score[end.CurEnd] = (hammer) ? -score : score;
+				end.WhiteToMove = hammer ^ (score <= 0);
+			}
+			// First player is to move at root if WhiteToMove is false
+			return 2.0f * options_.win_table->WinProbability(end, !root.WhiteToMove) - 1.0f;
+		}
+
+		bool Mcts::Advance(const ShotVec &shot, const GameState &after) {
+			bool reused = false;
+			for (std::unique_ptr<Tree> &tree : trees_) {
+				if (!tree || tree->size == 0) {
+					continue;
+				}
+				// Nearest shot with same angle
+				uint32_t best = kNoNode;
+				float best_distance = std::numeric_limits<float>::infinity();
+				for (uint32_t c = tree->nodes[0].first_child; c != kNoNode; c = tree->nodes[c].next_sibling) {
+					const ShotVec &s = tree->nodes[c].shot;
+					float distance = std::hypot(s.x - shot.x, s.y - shot.y);
+					if (s.angle == shot.angle && distance < best_distance) {
+						best = c;
+						best_distance = distance;
+					}
+				}
+				// Stones without random number must be near
+				if (best != kNoNode && tree->state.ShotNum < 16) {
+					GameState a = tree->state;
+					GameState b = tree->state;
+					sim_->Simulation(&a, shot, 0.0f, 0.0f, nullptr, nullptr);
+					sim_->Simulation(&b, tree->nodes[best].shot, 0.0f, 0.0f, nullptr, nullptr);
+					if (StateDistance(a, b) > options_.reuse_tolerance) {
+						best = kNoNode;
+					}
+				}
+				Reroot(*tree, best, after);
+				reused |= (tree->size > 0);
+			}
+			return reused;
+		}
+
+		bool Mcts::Advance(const GameState &after) {
+			bool reused = false;
+			for (std::unique_ptr<Tree> &tree : trees_) {
+				if (!tree || tree->size == 0) {
+					continue;
+				}
+				uint32_t best = kNoNode;
+				float best_distance = options_.reuse_tolerance;
+				if (tree->state.ShotNum < 16) {
+					for (uint32_t c = tree->nodes[0].first_child; c != kNoNode; c = tree->nodes[c].next_sibling) {
+						GameState gs = tree->state;
+						sim_->Simulation(&gs, tree->nodes[c].shot, 0.0f, 0.0f, nullptr, nullptr);
+						float distance = StateDistance(gs, after);
+						if (distance <= best_distance) {
+							best = c;
+							best_distance = distance;
+						}
+					}
+				}
+				Reroot(*tree, best, after);
+				reused |= (tree->size > 0);
+			}
+			return reused;
+		}
+
+		// Copy subtree of child to the front of arena
+		void Mcts::Reroot(Tree &tree, uint32_t child, const GameState &after) {
+			if (child == kNoNode || after.ShotNum != tree.state.ShotNum + 1 || after.CurEnd != tree.state.CurEnd) {
+				tree.size = 0;
+				return;
+			}
+
+			std::vector<Node> kept(1, tree.nodes[child]);
+			for (size_t k = 0; k < kept.size(); k++) {
+				uint32_t last = kNoNode;
+				uint32_t c = kept[k].first_child;
+				kept[k].first_child = kNoNode;
+				for (; c != kNoNode; c = tree.nodes[c].next_sibling) {
+					uint32_t n = (uint32_t)kept.size();
+					kept.push_back(tree.nodes[c]);
+					kept[n].next_sibling = kNoNode;
+					if (last == kNoNode) {
+						kept[k].first_child = n;
+					}
+					else {
+						kept[last].next_sibling = n;
+					}
+					last = n;
+				}
+			}
+			std::copy(kept.begin(), kept.end(), tree.nodes.begin());
+			tree.size = (uint32_t)kept.size();
+			tree.state = after;
+		}
+
+		void Mcts::Clear() {
+			for (std::unique_ptr<Tree> &tree : trees_) {
+				if (tree) {
+					tree->size = 0;
+				}
+			}
+		}
+
+		size_t Mcts::NumNodes() const {
+			size_t num = 0;
+			for (const std::unique_ptr<Tree> &tree : trees_) {
+				num += (tree) ? tree->size : 0;
+			}
+			return num;
+		}
+	}
+}
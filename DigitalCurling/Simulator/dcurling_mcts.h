@@ -0,0 +1,116 @@
+#pragma once
+
+#include "dcurling_simulator.h"
+#include "dcurling_win_table.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace digital_curling {
+
+	namespace search {
+
+		// Mode of parallel search
+		enum {
+			ROOT_PARALLEL,  // a tree for each thread, statistics of the root are merged at last
+			TREE_PARALLEL   // a tree shared by all threads with virtual loss
+		};
+
+		// Generator of candidate shots for a state (used for expansion and rollout)
+		typedef std::function<ShotVec(b2simulator::Simulator *sim, const GameState &gs, std::mt19937 &rng)> ShotGenerator;
+
+		// Random draw shot to the house or a guard, or random hit shot to a stone in play (default ShotGenerator)
+		DLLAPI ShotVec RandomShot(b2simulator::Simulator *sim, const GameState &gs, std::mt19937 &rng);
+
+		// Options for Mcts
+		struct DLLAPI MctsOptions {
+			MctsOptions();
+
+			int mode;                     // ROOT_PARALLEL or TREE_PARALLEL
+			unsigned int num_threads;     // number of threads (0: number of cores)
+			unsigned int time_limit;      // time budget of Search() [msec]
+			unsigned int max_iterations;  // max number of iterations of Search() (0: no limit)
+			unsigned int max_nodes;       // size of node arena of each tree (no expansion if full)
+			float exploration;            // constant of UCT (in unit of value)
+			float widening_c;             // a node may have widening_c * visits ^ widening_alpha children
+			float widening_alpha;
+			float virtual_loss;           // value counted for each visit in progress (TREE_PARALLEL)
+			unsigned int rollout_shots;   // max shots of rollout, end is scored as it stands after them (a shot takes milliseconds)
+			float reuse_tolerance;        // max distance of stones to match a shot for reuse [m]
+			const WinTable *win_table;    // value is 2 * probability of winning - 1 if set, score of the end if nullptr
+			ShotGenerator generator;      // candidate shots (RandomShot by default)
+			unsigned int seed;            // seed of random numbers
+		};
+
+		// Result of Mcts::Search()
+		struct MctsResult {
+			ShotVec shot;               // shot of the most visited child of root
+			float value;                // mean value of the shot for the player to move
+			unsigned int visits;        // visits of the shot
+			unsigned int iterations;    // iterations in this search
+			unsigned int reused;        // visits of root reused from previous search
+			size_t nodes;               // nodes in all trees
+		};
+
+		// Monte Carlo tree search in the current end
+		//  Open loop: a node is a sequence of shots, and each iteration simulates them again with new random numbers,
+		//  so the continuous space of ShotVec is searched by progressive widening of shots from the generator.
+		//  Nodes are allocated from an arena of fixed size and linked by index.
+		//
+		//  Tree is reused across 'GO' commands by following the shots played after the search:
+		//   own shot (BESTSHOT)  -> (after 'POSITION') Advance(shot, position)
+		//   shot of the opponent -> (after 'POSITION') Advance(position)  (DCP does not send RUNSHOT, so the shot is
+		//                           matched by stones), or Advance(run_shot, position) if it is known
+		//   'GO'                 -> Search(position) continues from the subtree if position is the root
+		class DLLAPI Mcts {
+		public:
+			// - float random_1, random_2 : size of random number of players
+			Mcts(b2simulator::Simulator *sim, float random_1, float random_2, const MctsOptions &options);
+			~Mcts();
+			Mcts(const Mcts &) = delete;
+			Mcts &operator=(const Mcts &) = delete;
+
+			// Search best shot for gs within time_limit (and max_iterations)
+			MctsResult Search(const GameState &gs);
+
+			// Move root to the child of shot (nearest shot with same angle) and set root state to after
+			//  returns false (and tree is cleared) if no child matches
+			bool Advance(const ShotVec &shot, const GameState &after);
+
+			// Move root to the child whose shot (without random number) results in stones nearest to after
+			bool Advance(const GameState &after);
+
+			// Clear trees
+			void Clear();
+
+			// Number of nodes in all trees
+			size_t NumNodes() const;
+
+		private:
+			struct Tree;
+
+			// Tree for thread t
+			Tree &GetTree(unsigned int t);
+
+			// Run iterations on tree with rng until stop() returns true
+			void Run(Tree &tree, std::mt19937 &rng, const std::function<bool()> &stop);
+
+			// Value of state (end is scored as it stands) for the player to move at root
+			float Evaluate(const GameState &root, const GameState &gs) const;
+
+			// Make child the root of tree
+			void Reroot(Tree &tree, uint32_t child, const GameState &after);
+
+			b2simulator::Simulator *sim_;
+			float random_1_;
+			float random_2_;
+			MctsOptions options_;
+			unsigned int num_threads_;
+			unsigned int num_searches_;
+			std::vector<std::unique_ptr<Tree>> trees_;
+		};
+	}
+}
@@ -2,6 +2,8 @@
 
 #include <random>
 #include <cmath>
+#include <cstdint>
+#include <vector>
 
 // Include for debug TODO: Delete in Release build
 #include <bitset>
@@ -16,12 +18,14 @@
 #define DLLAPI
 #endif // _WIN32
 
+#ifdef _MSC_VER
 #ifdef _DEBUG
 #pragma comment( lib, "Box2D/bin/Box2D_d.lib" )
 #endif
 #ifndef _DEBUG
 #pragma comment( lib, "Box2D/bin/Box2D.lib" )
 #endif
+#endif
 
 namespace digital_curling {
 
@@ -77,14 +81,21 @@ namespace digital_curling {
 				// Set shot_num_
 				shot_num_ = gs.ShotNum;
 				// Create bodies by positions of stone in GameState
+				//  (stones already removed from play get no body)
 				for (unsigned int i = 0; i < gs.ShotNum; i++) {
+					if (!(GetStoneArea(ShotPos(gs.body[i][0], gs.body[i][1], false)) & IN_PLAYAREA)) {
+						body_[i] = nullptr;
+						continue;
+					}
 					body_[i] = CreateBody(gs.body[i][0], gs.body[i][1], world_);
+					body_[i]->SetUserData(reinterpret_cast<void*>(static_cast<uintptr_t>(i)));
 				}
 
 				// Set ShotVec
 				assert(shot_num_ < 16);
 				// Create body
 				body_[shot_num_] = CreateBody(kCenterX, kHackY, world_);
+				body_[shot_num_]->SetUserData(reinterpret_cast<void*>(static_cast<uintptr_t>(shot_num_)));
 				// Set verocity
 				body_[shot_num_]->SetLinearVelocity(b2Vec2(vec.x, vec.y));
 				if (vec.angle) {
@@ -202,32 +213,112 @@ namespace digital_curling {
 			}
 		}
 
-		// Main loop for simulation (with recording trajectory)
-		int MainLoop(const float time_step, const int loop_count, Board &board, const float friction, float *trajectory, size_t traj_size) {
+		// TrajectorySink which records to dense array (compatible with old Simulation())
+		class ArrayTrajectorySink : public TrajectorySink {
+		public:
+			ArrayTrajectorySink(float *trajectory, size_t traj_size) :
+				TrajectorySink(1),
+				trajectory_(trajectory),
+				traj_size_(traj_size) {}
+
+			void OnStep(int step, const float *positions, unsigned int num_stones) {
+				if ((size_t)step >= traj_size_) {
+					return;
+				}
+				memcpy(&trajectory_[step * 32], positions, num_stones * 2 * sizeof(float));
+			}
+
+		private:
+			float *trajectory_;  // float[traj_size_][16][2]
+			size_t traj_size_;   // number of steps
+		};
+
+		// Send live positions of stones to sink
+		void RecordTrajectory(int step, const Board &board, TrajectorySink* const sink) {
+			float positions[16][2];
+			for (unsigned int i = 0; i < board.shot_num_ + 1; i++) {
+				if (board.body_[i] != nullptr) {
+					b2Vec2 vec = board.body_[i]->GetPosition();
+					positions[i][0] = vec.x;
+					positions[i][1] = vec.y;
+				}
+				else {
+					positions[i][0] = 0.0f;
+					positions[i][1] = 0.0f;
+				}
+			}
+			sink->OnStep(step, &positions[0][0], board.shot_num_ + 1);
+		}
+
+		// Contact listener which records collisions of stones to ShotEventLog
+		class EventListener : public b2ContactListener {
+		public:
+			EventListener(ShotEventLog* const event_log, float time_step) :
+				event_log_(event_log),
+				time_step_(time_step),
+				step_(0) {}
+
+			// Called when two stones begin to touch (before solving collision)
+			void BeginContact(b2Contact *contact) {
+				b2Body *body_a = contact->GetFixtureA()->GetBody();
+				b2Body *body_b = contact->GetFixtureB()->GetBody();
+
+				// Get relative speed along normal
+				b2WorldManifold manifold;
+				contact->GetWorldManifold(&manifold);
+				b2Vec2 v_rel = body_b->GetLinearVelocity() - body_a->GetLinearVelocity();
+
+				ShotEvent event;
+				event.type = ShotEvent::COLLISION;
+				event.stone_a = static_cast<unsigned char>(reinterpret_cast<uintptr_t>(body_a->GetUserData()));
+				event.stone_b = static_cast<unsigned char>(reinterpret_cast<uintptr_t>(body_b->GetUserData()));
+				event.step = step_;
+				event.time = step_ * time_step_;
+				event.impact_speed = std::abs(b2Dot(v_rel, manifold.normal));
+				event_log_->Add(event);
+			}
+
+			// Record stone which is removed from play
+			void StoneRemoved(unsigned int stone) {
+				ShotEvent event;
+				event.type = ShotEvent::OUT_OF_PLAY;
+				event.stone_a = static_cast<unsigned char>(stone);
+				event.stone_b = static_cast<unsigned char>(stone);
+				event.step = step_;
+				event.time = step_ * time_step_;
+				event.impact_speed = 0.0f;
+				event_log_->Add(event);
+			}
+
+			ShotEventLog *event_log_;
+			float time_step_;
+			int step_;  // current step
+		};
+
+		// Main loop for simulation (with recording trajectory and events)
+		int MainLoop(const float time_step, const int loop_count, Board &board, const float friction, TrajectorySink* const sink, EventListener* const listener) {
 			int num_steps;
+			int last_step = -1;      // last step taken
+			int last_recorded = -1;  // last step sent to sink
+			const unsigned int interval = (sink != nullptr && sink->interval_ > 0) ? sink->interval_ : 1;
 
 			// Add friction 0.5 step at first
 			FrictionAll(friction * time_step * 0.5f, board);
 
 			for (num_steps = 0; num_steps < loop_count || loop_count == -1; num_steps++) {
+				if (listener != nullptr) {
+					listener->step_ = num_steps;
+				}
+
 				// Calclate friction
 				board.world_.Step(time_step, kVelocityIterations, kPositionIterations);
 				FrictionAll(friction * time_step, board);
+				last_step = num_steps;
 
-				// Record to trajectory array
-				if (trajectory != nullptr) {
-					b2Vec2 vec;
-					for (unsigned int i = 0; i < board.shot_num_ + 1 && i < traj_size; i++) {
-						if (board.body_[i] != nullptr) {
-							vec = board.body_[i]->GetPosition();
-							trajectory[num_steps * 32 + i * 2] = vec.x;
-							trajectory[num_steps * 32 + i * 2 + 1] = vec.y;
-						}
-						else {
-							trajectory[num_steps * 32 + i * 2] = vec.x;
-							trajectory[num_steps * 32 + i * 2 + 1] = vec.y;
-						}
-					}
+				// Send trajectory to sink
+				if (sink != nullptr && num_steps % interval == 0) {
+					RecordTrajectory(num_steps, board, sink);
+					last_recorded = num_steps;
 				}
 
 				// Check state of each stone
@@ -240,6 +331,9 @@ namespace digital_curling {
 							//  Destroy body if a stone is out from Rink
 							board.world_.DestroyBody(board.body_[i]);
 							board.body_[i] = nullptr;
+							if (listener != nullptr) {
+								listener->StoneRemoved(i);
+							}
 						}
 						else if (vec.x != 0.0f || vec.y != 0.0f) {
 							// Continue first loop if a stone is awake
@@ -255,6 +349,11 @@ namespace digital_curling {
 
 		LOOP_END:
 
+			// Send last step to sink if it was skipped by interval
+			if (sink != nullptr && last_recorded != last_step) {
+				RecordTrajectory(last_step, board, sink);
+			}
+
 			// Remove all stones if not in playarea
 			for (unsigned int i = 0; i < board.shot_num_ + 1; i++) {
 				if (board.body_[i] != nullptr) {
@@ -264,6 +363,9 @@ namespace digital_curling {
 						//  Destroy body if a stone is out from playarea
 						board.world_.DestroyBody(board.body_[i]);
 						board.body_[i] = nullptr;
+						if (listener != nullptr) {
+							listener->StoneRemoved(i);
+						}
 					}
 				}
 			}
@@ -344,37 +446,64 @@ namespace digital_curling {
 			}
 		}
 
+		/*** Member functions of class 'StreamTrajectorySink' ***/
+
+		// Write step and positions of 16 stones as a line of csv
+		void StreamTrajectorySink::OnStep(int step, const float *positions, unsigned int num_stones) {
+			std::ostream &os = *os_;
+			os << step << ",";
+			for (unsigned int i = 0; i < 16; i++) {
+				if (i < num_stones) {
+					os << std::fixed << std::setprecision(6) << positions[2 * i] << "," <<
+						std::fixed << std::setprecision(6) << positions[2 * i + 1];
+				}
+				else {
+					os << "0.000000,0.000000";
+				}
+				if (i < 15) {
+					os << ",";
+				}
+			}
+			os << "\n";
+		}
+
 		/*** Member functions of class 'Simulator' ***/
 
 		Simulator::Simulator() :
 			num_freeguard_(3),
 			area_freeguard_(IN_FREEGUARD),
 			random_type_(RECTANGULAR),
+			noise_model_(EXACT_NOISE),
 			friction_(kFriction) {
 
-			// initialize shot_table
+			// initialize shot_table and noise_table
 			init_shot_table();
+			init_noise_table();
 		}
 
 		Simulator::Simulator(float friction) :
 			num_freeguard_(3),
 			area_freeguard_(IN_FREEGUARD),
 			random_type_(RECTANGULAR),
+			noise_model_(EXACT_NOISE),
 			friction_(friction) {
 
-			// initialize shot_table
+			// initialize shot_table and noise_table
 			init_shot_table();
+			init_noise_table();
 		}
 
 		Simulator::Simulator(float friction, float friction_stone) :
 			num_freeguard_(3),
 			area_freeguard_(IN_FREEGUARD),
 			random_type_(RECTANGULAR),
+			noise_model_(EXACT_NOISE),
 			friction_(friction),
 			friction_stone(friction_stone){
 
-			// initialize shot_table
+			// initialize shot_table and noise_table
 			init_shot_table();
+			init_noise_table();
 		}
 
 		// Simulation with Box2D (compatible with Simulation() in CurlingSimulator.h)
@@ -385,6 +514,47 @@ namespace digital_curling {
 			ShotVec* const run_shot, 
 			float *trajectory, size_t traj_size) {
 
+			if (trajectory == nullptr) {
+				return Simulation(game_state, shot_vec, random_x, random_y, run_shot, nullptr);
+			}
+
+			// Record trajectory to array via sink
+			ArrayTrajectorySink sink(trajectory, traj_size);
+			return Simulation(game_state, shot_vec, random_x, random_y, run_shot, &sink);
+		}
+
+		// Simulation with Box2D (streaming trajectory to sink)
+		int Simulator::Simulation(
+			GameState* const game_state,
+			ShotVec shot_vec,
+			float random_x, float random_y,
+			ShotVec* const run_shot,
+			TrajectorySink* const sink) {
+
+			return run_simulation(game_state, shot_vec, random_x, random_y, run_shot, sink, nullptr);
+		}
+
+		// Simulation with Box2D (recording events to event_log)
+		int Simulator::Simulation(
+			GameState* const game_state,
+			ShotVec shot_vec,
+			float random_x, float random_y,
+			ShotVec* const run_shot,
+			TrajectorySink* const sink,
+			ShotEventLog &event_log) {
+
+			event_log.Clear();
+			return run_simulation(game_state, shot_vec, random_x, random_y, run_shot, sink, &event_log);
+		}
+
+		int Simulator::run_simulation(
+			GameState* const game_state,
+			ShotVec shot_vec,
+			float random_x, float random_y,
+			ShotVec* const run_shot,
+			TrajectorySink* const sink,
+			ShotEventLog* const event_log) {
+
 			if (game_state->ShotNum > 15) {
 				return -1;
 			}
@@ -393,18 +563,34 @@ namespace digital_curling {
 			AddRandom2Vec(random_x, random_y, &shot_vec);
 			if (run_shot != nullptr) {
 				// Copy random-added shot_vec to run_shot
-				memcpy_s(run_shot, sizeof(ShotVec), &shot_vec, sizeof(ShotVec));
+				*run_shot = shot_vec;
 			}
 
 			// Create board
 			Board board(*game_state, shot_vec);
 
+			// Install contact listener only if events are recorded
+			EventListener listener(event_log, kTimeStep);
+			if (event_log != nullptr) {
+				board.world_.SetContactListener(&listener);
+			}
+
 			// Run mainloop of simulation
 			int steps;
-			steps = MainLoop(kTimeStep, -1, board, friction_, trajectory, traj_size);
+			steps = MainLoop(kTimeStep, -1, board, friction_, sink, (event_log != nullptr) ? &listener : nullptr);
 
 			// Check freeguard zone rule
 			if (IsFreeguardFoul(board, game_state, num_freeguard_, area_freeguard_)) {
+				if (event_log != nullptr) {
+					ShotEvent event;
+					event.type = ShotEvent::FREEGUARD_FOUL;
+					event.stone_a = static_cast<unsigned char>(game_state->ShotNum);
+					event.stone_b = static_cast<unsigned char>(game_state->ShotNum);
+					event.step = steps;
+					event.time = steps * kTimeStep;
+					event.impact_speed = 0.0f;
+					event_log->Add(event);
+				}
 				game_state->ShotNum++;
 				game_state->WhiteToMove ^= 1;
 				return 0;
@@ -579,8 +765,6 @@ namespace digital_curling {
 			std::random_device seed_gen;
 			std::default_random_engine engine(seed_gen());
 
-			ShotPos tee_pos(kCenterX, kTeeY, vec->angle);
-			ShotVec tee_shot, add_rand_tee_shot;
 			float r1 = 0.0f;
 			float r2 = 0.0f;
 
@@ -594,14 +778,75 @@ namespace digital_curling {
 				r2 = dist_2(engine);
 			}
 
+			AddNoise2Vec(r1, r2, vec);
+		}
+
+		// Add random number to each ShotVec in array (normal distribution)
+		void Simulator::AddRandom2Vecs(float random_1, float random_2, ShotVec* const vecs, size_t num) {
+			if ((random_1 == 0.0f && random_2 == 0.0f) || num == 0) {
+				return;
+			}
+
+			// Prepare random
+			std::random_device seed_gen;
+			std::default_random_engine engine(seed_gen());
+
+			// Draw all random numbers at first
+			std::vector<float> r1(num, 0.0f);
+			std::vector<float> r2(num, 0.0f);
+			if (random_1 != 0.0f) {
+				std::normal_distribution<float> dist_1(0, random_1);
+				for (size_t i = 0; i < num; i++) {
+					r1[i] = dist_1(engine);
+				}
+			}
+			if (random_2 != 0.0f) {
+				std::normal_distribution<float> dist_2(0, random_2);
+				for (size_t i = 0; i < num; i++) {
+					r2[i] = dist_2(engine);
+				}
+			}
+
+			if (random_type_ == RECTANGULAR && noise_model_ == LINEAR_NOISE) {
+				// Apply affine transform to all ShotVec in single pass
+				const float (*j)[2][2] = noise_table_.jacobian;
+				for (size_t i = 0; i < num; i++) {
+					const int a = vecs[i].angle ? 1 : 0;
+					vecs[i].x -= j[a][0][0] * r1[i] + j[a][0][1] * r2[i];
+					vecs[i].y -= j[a][1][0] * r1[i] + j[a][1][1] * r2[i];
+				}
+			}
+			else {
+				for (size_t i = 0; i < num; i++) {
+					AddNoise2Vec(r1[i], r2[i], &vecs[i]);
+				}
+			}
+		}
+
+		// Add random number which is already drawn to ShotVec
+		void Simulator::AddNoise2Vec(float r1, float r2, ShotVec* const vec) {
+			if (r1 == 0.0f && r2 == 0.0f) {
+				return;
+			}
+
 			// for rectangular coordinate system
 			if (random_type_ == RECTANGULAR) {
-				// Create shot to center of house
-				CreateShot(tee_pos, &tee_shot);
-				CreateShot(tee_pos + ShotPos(r1, r2, vec->angle), &add_rand_tee_shot);
+				const int a = vec->angle ? 1 : 0;
+				if (noise_model_ == LINEAR_NOISE) {
+					// Add -(Jacobian * r) as (tee_shot - add_rand_tee_shot)
+					const float (*j)[2] = noise_table_.jacobian[a];
+					vec->x -= j[0][0] * r1 + j[0][1] * r2;
+					vec->y -= j[1][0] * r1 + j[1][1] * r2;
+				}
+				else {
+					// Create shot to center of house with random
+					ShotPos tee_pos(kCenterX, kTeeY, vec->angle);
+					ShotVec add_rand_tee_shot;
+					CreateShot(tee_pos + ShotPos(r1, r2, vec->angle), &add_rand_tee_shot);
 
-				// Add random to vecCon
-				*vec += tee_shot - add_rand_tee_shot;
+					// Add random to vecCon
+					*vec += noise_table_.tee_shot[a] - add_rand_tee_shot;
+				}
 			} 
 			// for polar coordinate system
 			else if (random_type_ == POLAR) {
@@ -613,6 +858,31 @@ namespace digital_curling {
 			}
 		}
 
+		// Initialize noise_table (shot to the tee and Jacobian of CreateShot() at the tee)
+		int Simulator::init_noise_table() {
+			// Step for central difference [m]
+			const float h = 0.01f;
+
+			for (int a = 0; a < 2; a++) {
+				const bool angle = (a == 1);
+				ShotPos tee_pos(kCenterX, kTeeY, angle);
+				CreateShot(tee_pos, &noise_table_.tee_shot[a]);
+
+				ShotVec x_p, x_m, y_p, y_m;
+				CreateShot(tee_pos + ShotPos(h, 0.0f, angle), &x_p);
+				CreateShot(tee_pos - ShotPos(h, 0.0f, angle), &x_m);
+				CreateShot(tee_pos + ShotPos(0.0f, h, angle), &y_p);
+				CreateShot(tee_pos - ShotPos(0.0f, h, angle), &y_m);
+
+				noise_table_.jacobian[a][0][0] = (x_p.x - x_m.x) / (2.0f * h);
+				noise_table_.jacobian[a][0][1] = (y_p.x - y_m.x) / (2.0f * h);
+				noise_table_.jacobian[a][1][0] = (x_p.y - x_m.y) / (2.0f * h);
+				noise_table_.jacobian[a][1][1] = (y_p.y - y_m.y) / (2.0f * h);
+			}
+
+			return 0;
+		}
+
 		// Initialize shot_table
 		int Simulator::init_shot_table() {
 
@@ -8,6 +8,8 @@
 #endif // _WIN32
 #endif // _DLLAPI
 
+#include <ostream>
+
 namespace digital_curling {
 
 		// Constant values
@@ -133,6 +135,80 @@ namespace digital_curling {
 				POLAR         // polar coordinate system
 			};
 
+			// Model to convert random number to ShotVec (for RECTANGULAR)
+			enum {
+				EXACT_NOISE,  // CreateShot() for position of tee with random number
+				LINEAR_NOISE  // Jacobian of CreateShot() at the tee (cached)
+			};
+
+			// Receiver of trajectory while simulation (override OnStep())
+			class DLLAPI TrajectorySink {
+			public:
+				TrajectorySink();
+				TrajectorySink(unsigned int interval);
+				virtual ~TrajectorySink();
+
+				// Called every interval_ steps (and at the last step) with live positions of stones
+				// - int step                : number of step
+				// - const float *positions  : positions of stones (float[num_stones][2], (0, 0) if removed)
+				// - unsigned int num_stones : number of stones in simulation (ShotNum + 1)
+				virtual void OnStep(int step, const float *positions, unsigned int num_stones) = 0;
+
+				unsigned int interval_;  // Interval of steps to call OnStep() (1: every step)
+			};
+
+			// TrajectorySink which writes step and positions of all 16 stones as a line of csv to std::ostream
+			//  (steps are not contiguous if interval_ > 1, and the last step may be off the interval)
+			class DLLAPI StreamTrajectorySink : public TrajectorySink {
+			public:
+				StreamTrajectorySink(std::ostream &os);
+				StreamTrajectorySink(std::ostream &os, unsigned int interval);
+				~StreamTrajectorySink();
+
+				void OnStep(int step, const float *positions, unsigned int num_stones);
+
+			private:
+				std::ostream *os_;
+			};
+
+			// Event while simulation
+			struct ShotEvent {
+				enum {
+					COLLISION,      // two stones collided
+					OUT_OF_PLAY,    // stone was removed from play
+					FREEGUARD_FOUL  // shot was cancelled by freeguard rule
+				};
+
+				unsigned char type;     // type of event
+				unsigned char stone_a;  // number of stone (index of GameState::body)
+				unsigned char stone_b;  // number of other stone (COLLISION only)
+				int step;               // step when event occurred
+				float time;             // time when event occurred [sec]
+				float impact_speed;     // relative normal speed of two stones (COLLISION only)
+			};
+
+			// Events of a shot
+			class DLLAPI ShotEventLog {
+			public:
+				ShotEventLog();
+				~ShotEventLog();
+
+				// Clear all events
+				void Clear();
+
+				// Add an event (counted in num_dropped_ if full)
+				void Add(const ShotEvent &event);
+
+				// Get number of collisions of stone
+				unsigned int NumCollisions(unsigned int stone) const;
+
+				static const unsigned int kMaxEvents = 64;
+
+				unsigned int num_events_;       // Number of events recorded
+				unsigned int num_dropped_;      // Number of events over kMaxEvents
+				ShotEvent events_[kMaxEvents];  // Events in order of time
+			};
+
 			class DLLAPI Simulator {
 			public:
 				Simulator();
@@ -144,13 +220,27 @@ namespace digital_curling {
 				// - ShotVec* shot_vec        : Shot Vector
 				// - float random_x, random_y : Size of random number (v, theta when random_type_ = POLAR)
 				// - ShotVec* run_shot        : Shot Vector which with random numbers (pass nullptr if you don't need)
-				// - float trajectory         : trajectory log (pass float[traj_size][2], or nullptr if you don't need)
+				// - float trajectory         : trajectory log (pass float[traj_size][16][2], or nullptr if you don't need)
 				// - float traj_size          : size of trajectory log (number of steps)
 				int Simulation(
 					GameState* const game_state, ShotVec shot_vec,
 					float random_x, float random_y,
 					ShotVec* const run_shot, float *trajectory, size_t traj_size);
 
+				// Simulation with Box2D, streaming trajectory to sink, returns number of steps taken
+				// - TrajectorySink* sink     : receiver of trajectory (pass nullptr if you don't need)
+				int Simulation(
+					GameState* const game_state, ShotVec shot_vec,
+					float random_x, float random_y,
+					ShotVec* const run_shot, TrajectorySink* const sink);
+
+				// Simulation with Box2D, recording collisions and removed stones to event_log
+				// - ShotEventLog& event_log  : events of this shot (cleared at first)
+				int Simulation(
+					GameState* const game_state, ShotVec shot_vec,
+					float random_x, float random_y,
+					ShotVec* const run_shot, TrajectorySink* const sink, ShotEventLog &event_log);
+
 				// Create ShotVec from ShotPos which stone will stop at
 				void CreateShot(ShotPos pos, ShotVec* const vec);
 
@@ -162,15 +252,31 @@ namespace digital_curling {
 				//  random_2 : y (rectangular), theta (polar)
 				void AddRandom2Vec(float random_1, float random_2, ShotVec* const vec);
 
+				// Add random number to each ShotVec in array (draws all random numbers at once)
+				void AddRandom2Vecs(float random_1, float random_2, ShotVec* const vecs, size_t num);
+
+				// Add random number which is already drawn to ShotVec
+				//  r1 : x (rectangular), v (polar)
+				//  r2 : y (rectangular), theta (polar)
+				void AddNoise2Vec(float r1, float r2, ShotVec* const vec);
+
 				// Get score for second player (which has last shot in this end)
 				static int GetScore(const GameState* const game_state);
 
 				unsigned int num_freeguard_;   // Number of shots which freeguard rule is applied
 				StoneArea area_freeguard_;     // Area of freeguard
 				unsigned int random_type_;      // Type of random number generator (0: )
+				unsigned int noise_model_;      // Model of random number for RECTANGULAR (EXACT_NOISE or LINEAR_NOISE)
 			
 			private:
 				int init_shot_table();
+				int init_noise_table();
+
+				// Simulation with Box2D (event_log is nullptr if disabled)
+				int run_simulation(
+					GameState* const game_state, ShotVec shot_vec,
+					float random_x, float random_y,
+					ShotVec* const run_shot, TrajectorySink* const sink, ShotEventLog* const event_log);
 
 				float friction_;       // friction between stone and ice
 				float friction_stone;  // friction between 2 stones
@@ -181,6 +287,12 @@ namespace digital_curling {
 					ShotPos pos[kTableSize];
 					ShotVec vec[kTableSize];
 				} shot_table_;
+
+				// Shot to the tee and its Jacobian for each curl angle ([0]: false, [1]: true)
+				struct NoiseTable {
+					ShotVec tee_shot[2];      // CreateShot() for the tee
+					float jacobian[2][2][2];  // d(tee_shot.x, tee_shot.y)/d(x, y)
+				} noise_table_;
 			};
 		}
 
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <cassert>
+#include <cstring>
 
 namespace digital_curling {
 	// Constructors
@@ -75,6 +76,56 @@ namespace digital_curling {
 		angle(angle) {}
 	ShotVecP::~ShotVecP() {}
 
+	namespace b2simulator {
+		TrajectorySink::TrajectorySink() :
+			interval_(1) {}
+		TrajectorySink::TrajectorySink(unsigned int interval) :
+			interval_(interval) {}
+		TrajectorySink::~TrajectorySink() {}
+
+		StreamTrajectorySink::StreamTrajectorySink(std::ostream &os) :
+			TrajectorySink(1),
+			os_(&os) {}
+		StreamTrajectorySink::StreamTrajectorySink(std::ostream &os, unsigned int interval) :
+			TrajectorySink(interval),
+			os_(&os) {}
+		StreamTrajectorySink::~StreamTrajectorySink() {}
+
+		ShotEventLog::ShotEventLog() :
+			num_events_(0),
+			num_dropped_(0),
+			events_() {}
+		ShotEventLog::~ShotEventLog() {}
+
+		// Clear all events
+		void ShotEventLog::Clear() {
+			num_events_ = 0;
+			num_dropped_ = 0;
+		}
+
+		// Add an event
+		void ShotEventLog::Add(const ShotEvent &event) {
+			if (num_events_ < kMaxEvents) {
+				events_[num_events_++] = event;
+			}
+			else {
+				num_dropped_++;
+			}
+		}
+
+		// Get number of collisions of stone
+		unsigned int ShotEventLog::NumCollisions(unsigned int stone) const {
+			unsigned int num = 0;
+			for (unsigned int i = 0; i < num_events_; i++) {
+				if (events_[i].type == ShotEvent::COLLISION &&
+					(events_[i].stone_a == stone || events_[i].stone_b == stone)) {
+					num++;
+				}
+			}
+			return num;
+		}
+	}
+
 	// Operators
 	ShotPos operator+(ShotPos pos_l, ShotPos pos_r) {
 		return ShotPos(
@@ -0,0 +1,160 @@
+#include "dcurling_win_table.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace digital_curling {
+
+	namespace {
+		const char     kWinTableMagic[4] = { 'D', 'C', 'W', '1' };
+		const uint32_t kWinTableVersion = 1;
+
+		// Header of table file (all fields are 4 bytes)
+		struct WinTableHeader {
+			char     magic[4];
+			uint32_t version;
+			uint32_t header_size;
+			uint32_t max_end_score;
+			uint32_t max_diff;
+			uint32_t max_ends;
+		};
+	}
+
+	WinTable::WinTable() : loaded_(false) {
+		// No distribution: every end is blank
+		double blank[kNumEndScores] = {};
+		blank[kMaxEndScore] = 1.0;
+		Solve(blank);
+		loaded_ = false;
+	}
+
+	// Solve table by dynamic programming from the last end
+	void WinTable::Solve(const double distribution[kNumEndScores]) {
+		double sum = 0.0;
+		for (int i = 0; i < kNumEndScores; i++) {
+			sum += std::max(distribution[i], 0.0);
+		}
+		for (int i = 0; i < kNumEndScores; i++) {
+			distribution_[i] = (sum > 0.0) ? (float)(std::max(distribution[i], 0.0) / sum) : ((i == kMaxEndScore) ? 1.0f : 0.0f);
+		}
+
+		// Game is over
+		for (int d = -kMaxDiff; d <= kMaxDiff; d++) {
+			float win = (d > 0) ? 1.0f : ((d == 0) ? 0.5f : 0.0f);
+			table_[0][0][d + kMaxDiff] = win;
+			table_[0][1][d + kMaxDiff] = win;
+		}
+
+		auto next = [this](unsigned int ends_left, int score_diff, int hammer) {
+			return table_[ends_left][hammer][std::clamp(score_diff, -kMaxDiff, kMaxDiff) + kMaxDiff];
+		};
+		for (unsigned int e = 1; e <= kLastEndMax; e++) {
+			for (int d = -kMaxDiff; d <= kMaxDiff; d++) {
+				double with_hammer = 0.0;     // the player has hammer
+				double without_hammer = 0.0;  // the other player has hammer
+				for (int s = -kMaxEndScore; s <= kMaxEndScore; s++) {
+					double p = distribution_[s + kMaxEndScore];
+					if (p == 0.0) {
+						continue;
+					}
+					// Player who scored gives hammer to the other, hammer is kept at a blank end
+					with_hammer += p * next(e - 1, d + s, (s > 0) ? 0 : 1);
+					without_hammer += p * next(e - 1, d - s, (s > 0) ? 1 : 0);
+				}
+				table_[e][1][d + kMaxDiff] = (float)with_hammer;
+				table_[e][0][d + kMaxDiff] = (float)without_hammer;
+			}
+		}
+		loaded_ = true;
+	}
+
+	bool WinTable::Load(const std::string &path) {
+		std::ifstream ifs(path, std::ios::binary);
+		if (!ifs.is_open()) {
+			std::cerr << "failed to open " << path << std::endl;
+			return false;
+		}
+
+		WinTableHeader header;
+		float distribution[kNumEndScores];
+		float table[kLastEndMax + 1][2][kNumDiffs];
+		ifs.read(reinterpret_cast<char*>(&header), sizeof(header));
+		if (!ifs || memcmp(header.magic, kWinTableMagic, sizeof(header.magic)) != 0 ||
+			header.version != kWinTableVersion || header.header_size != sizeof(WinTableHeader) ||
+			header.max_end_score != kMaxEndScore || header.max_diff != kMaxDiff || header.max_ends != kLastEndMax) {
+			std::cerr << path << " is not a win table of this version" << std::endl;
+			return false;
+		}
+		ifs.read(reinterpret_cast<char*>(distribution), sizeof(distribution));
+		ifs.read(reinterpret_cast<char*>(table), sizeof(table));
+		if (!ifs) {
+			std::cerr << path << " is truncated" << std::endl;
+			return false;
+		}
+
+		memcpy(distribution_, distribution, sizeof(distribution_));
+		memcpy(table_, table, sizeof(table_));
+		loaded_ = true;
+		return true;
+	}
+
+	bool WinTable::Save(const std::string &path) const {
+		std::ofstream ofs(path, std::ios::binary);
+		if (!ofs.is_open()) {
+			std::cerr << "failed to create " << path << std::endl;
+			return false;
+		}
+
+		WinTableHeader header;
+		memcpy(header.magic, kWinTableMagic, sizeof(header.magic));
+		header.version = kWinTableVersion;
+		header.header_size = sizeof(WinTableHeader);
+		header.max_end_score = kMaxEndScore;
+		header.max_diff = kMaxDiff;
+		header.max_ends = kLastEndMax;
+		ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		ofs.write(reinterpret_cast<const char*>(distribution_), sizeof(distribution_));
+		ofs.write(reinterpret_cast<const char*>(table_), sizeof(table_));
+		return (bool)ofs;
+	}
+
+	bool WinTable::IsLoaded() const {
+		return loaded_;
+	}
+
+	float WinTable::WinProbability(int score_diff, unsigned int ends_left, bool hammer) const {
+		return table_[std::min(ends_left, kLastEndMax)][(hammer) ? 1 : 0][std::clamp(score_diff, -kMaxDiff, kMaxDiff) + kMaxDiff];
+	}
+
+	float WinTable::WinProbability(const GameState &gs, bool first) const {
+		unsigned int cur_end = std::min(gs.CurEnd, kLastEndMax);
+		int score_diff = 0;  // for first player
+		for (unsigned int i = 0; i < cur_end; i++) {
+			score_diff += gs.Score[i];
+		}
+
+		bool first_has_hammer;
+		unsigned int ends_left = (gs.LastEnd > cur_end) ? gs.LastEnd - cur_end : 0;
+		// WhiteToMove is false if first player is to move (same as the server)
+		if (gs.ShotNum >= 16 && cur_end < kLastEndMax) {
+			// Current end is over (WhiteToMove is the player who shoots first in next end, without hammer)
+			score_diff += gs.Score[cur_end];
+			ends_left = (ends_left > 0) ? ends_left - 1 : 0;
+			first_has_hammer = gs.WhiteToMove;
+		}
+		else {
+			// Player to move has hammer at odd ShotNum
+			first_has_hammer = (gs.ShotNum % 2 == 0) ? gs.WhiteToMove : !gs.WhiteToMove;
+		}
+
+		return (first) ?
+			WinProbability(score_diff, ends_left, first_has_hammer) :
+			WinProbability(-score_diff, ends_left, !first_has_hammer);
+	}
+
+	const float *WinTable::Distribution() const {
+		return distribution_;
+	}
+}
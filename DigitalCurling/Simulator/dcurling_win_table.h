@@ -0,0 +1,50 @@
+#pragma once
+
+#include "dcurling_simulator.h"
+
+#include <cstdint>
+#include <string>
+
+namespace digital_curling {
+
+	// Table of probability of winning by score difference, ends remaining and hammer
+	//  Solved from distribution of score of an end, so lookups need no simulation
+	//  A draw counts as half a win (the server plays no extra end)
+	class DLLAPI WinTable {
+	public:
+		static constexpr int kMaxEndScore = 8;   // maximum score of an end
+		static constexpr int kMaxDiff = 16;      // score differences beyond are clamped
+		static constexpr int kNumEndScores = 2 * kMaxEndScore + 1;
+		static constexpr int kNumDiffs = 2 * kMaxDiff + 1;
+
+		WinTable();
+
+		// Solve table from distribution of score of an end for the player with hammer
+		//  distribution[s + kMaxEndScore] : probability of score s (s < 0: stolen by the other player, normalized here)
+		void Solve(const double distribution[kNumEndScores]);
+
+		// Read and write table (.dcw)
+		//  Header (magic 'DCW1', version, header_size, max_end_score, max_diff, max_ends),
+		//  distribution (float[kNumEndScores]) and table (float[kLastEndMax + 1][2][kNumDiffs]), 4 bytes each
+		bool Load(const std::string &path);
+		bool Save(const std::string &path) const;
+		bool IsLoaded() const;
+
+		// Probability of winning
+		//  score_diff : own total score - total score of the other player
+		//  ends_left  : number of ends not finished (0: game is over)
+		//  hammer     : true if the player has last shot of next end
+		float WinProbability(int score_diff, unsigned int ends_left, bool hammer) const;
+
+		// Probability of winning of first player (first = true) or second player at the start of current end of gs
+		float WinProbability(const GameState &gs, bool first) const;
+
+		// Distribution solved from (probability of score s at [s + kMaxEndScore])
+		const float *Distribution() const;
+
+	private:
+		bool loaded_;
+		float distribution_[kNumEndScores];
+		float table_[kLastEndMax + 1][2][kNumDiffs];  // [ends_left][hammer][score_diff + kMaxDiff]
+	};
+}
@@ -1,10 +1,23 @@
 //#include "Box2D/Box2D.h"
 #include "dcurling_simulator.h"
+#include "dcurling_evaluator.h"
+#include "dcurling_dcp.h"
+#include "dcurling_win_table.h"
+#include "dcurling_last_shot.h"
+#include "dcurling_mcts.h"
+#include "dcsim_capi.h"
 
 #include <fstream>
 #include <iostream>
 #include <iomanip>
 #include <ctime>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
 
 using digital_curling::GameState;
 using digital_curling::ShotPos;
@@ -48,33 +61,20 @@ void simulation_test() {
 	GameState gs(8);
 	ShotVec vec(-0.99074f, -29.559774f, false);
 
-	const size_t traj_size = 4096;
-	float trajectory[32 * traj_size];
-	memset(trajectory, 0, sizeof(float) * 32 * traj_size);
-
 	time_t time_start = clock();
 	Simulator sim;
 	time_t time_spent = clock() - time_start;
 	cout << "time spent for initializing Simulator = " << time_spent << " [ms]" << endl;
 
-	int steps = sim.Simulation(&gs, vec, 0, 0, nullptr, trajectory, traj_size);
+	// Stream trajectory to file while simulation
+	std::ofstream ofs("trajectory_log.txt");
+	digital_curling::b2simulator::StreamTrajectorySink sink(ofs);
+	int steps = sim.Simulation(&gs, vec, 0, 0, nullptr, &sink);
+	cout << "steps = " << steps << endl;
 
 	PrintGameState(gs);
 
-	std::ofstream ofs("trajectory_log.txt");
-	for (int i = 0; i < steps; i++) {
-		for (unsigned int j = 0; j < 16; j++) {
-			ofs <<
-				std::fixed << std::setprecision(6) << trajectory[32 * i + 2 * j] << "," <<
-				std::fixed << std::setprecision(6) << trajectory[32 * i + 2 * j + 1];
-			if (j < 15) {
-				ofs << ",";
-			}
-		}
-		ofs << endl;
-	}
-
-	steps = sim.Simulation(&gs, vec, 0, 0, nullptr, trajectory, traj_size);
+	steps = sim.Simulation(&gs, vec, 0, 0, nullptr, nullptr);
 
 	PrintGameState(gs);
 }
@@ -131,6 +131,38 @@ void create_shot_test() {
 	cout << "pos = (" << pos.x << "," << pos.y << ")" << endl;
 }
 
+void event_test() {
+	using namespace digital_curling;
+	GameState gs(8);
+	ShotVec vec;
+	b2simulator::ShotEventLog event_log;
+
+	Simulator sim;
+
+	// Draw to the tee, then hit it
+	sim.CreateShot(ShotPos(kCenterX, kTeeY, false), &vec);
+	sim.Simulation(&gs, vec, 0, 0, nullptr, nullptr, event_log);
+	sim.CreateHitShot(ShotPos(gs.body[0][0], gs.body[0][1], false), 16, &vec);
+	sim.Simulation(&gs, vec, 0, 0, nullptr, nullptr, event_log);
+
+	for (unsigned int i = 0; i < event_log.num_events_; i++) {
+		const b2simulator::ShotEvent &e = event_log.events_[i];
+		cout << "type = " << (int)e.type << ", stones = (" << (int)e.stone_a << ", " << (int)e.stone_b <<
+			"), time = " << e.time << ", impact_speed = " << e.impact_speed << endl;
+	}
+	cout << "collisions of stone 0 = " << event_log.NumCollisions(0) << endl;
+
+	// Stones 0, 1, 3 and 4 are removed (at (0,0)), draw touches nothing: no events
+	gs.Clear();
+	gs.ShotNum = 6;
+	gs.Set(2, kCenterX + 1.0f, kTeeY + 3.0f);
+	gs.Set(5, kCenterX + 1.2f, kTeeY - 1.0f);
+	sim.CreateShot(ShotPos(kCenterX - 0.8f, kTeeY, false), &vec);
+	sim.Simulation(&gs, vec, 0, 0, nullptr, nullptr, event_log);
+	cout << "events with removed stones = " << event_log.num_events_ <<
+		" (dropped " << event_log.num_dropped_ << ")" << endl;
+}
+
 void random_test() {
 	using namespace digital_curling;
 
@@ -169,6 +201,109 @@ void random_test() {
 	cout << "Time spent = " << time_spent << endl;
 }
 
+void noise_test() {
+	using namespace digital_curling;
+	const int loop = 100000;
+	const float random = 0.145f;
+
+	Simulator sim;
+	ShotVec vec;
+	sim.CreateShot(ShotPos(kCenterX, kTeeY, false), &vec);
+
+	// Compare exact and linear model with same random numbers
+	float diff_max = 0.0f;
+	for (int i = -10; i <= 10; i++) {
+		for (int j = -10; j <= 10; j++) {
+			ShotVec vec_exact = vec;
+			ShotVec vec_linear = vec;
+			sim.noise_model_ = b2simulator::EXACT_NOISE;
+			sim.AddNoise2Vec(0.3f * random * i, 0.3f * random * j, &vec_exact);
+			sim.noise_model_ = b2simulator::LINEAR_NOISE;
+			sim.AddNoise2Vec(0.3f * random * i, 0.3f * random * j, &vec_linear);
+			diff_max = std::max(diff_max, std::abs(vec_exact.x - vec_linear.x));
+			diff_max = std::max(diff_max, std::abs(vec_exact.y - vec_linear.y));
+		}
+	}
+	cout << "max difference (exact - linear) in 3 sigma = " << diff_max << endl;
+
+	// Time for each model
+	std::vector<ShotVec> vecs(loop, vec);
+	sim.noise_model_ = b2simulator::EXACT_NOISE;
+	time_t start = clock();
+	for (int i = 0; i < loop; i++) {
+		sim.AddRandom2Vec(random, random, &vecs[i]);
+	}
+	cout << "Time spent (exact, AddRandom2Vec) = " << clock() - start << endl;
+
+	sim.noise_model_ = b2simulator::LINEAR_NOISE;
+	start = clock();
+	sim.AddRandom2Vecs(random, random, vecs.data(), vecs.size());
+	cout << "Time spent (linear, AddRandom2Vecs) = " << clock() - start << endl;
+}
+
+void evaluator_test() {
+	using namespace digital_curling;
+	const float random = 0.145f;
+	const unsigned int num = 256;
+
+	Simulator sim;
+
+	// Stone of opponent on the tee
+	GameState gs(8);
+	gs.Set(0, kCenterX, kTeeY);
+
+	// Candidates: hit the stone and draw to the tee
+	ShotVec shots[2];
+	sim.CreateHitShot(ShotPos(kCenterX, kTeeY, false), 16, &shots[0]);
+	sim.CreateShot(ShotPos(kCenterX, kTeeY, false), &shots[1]);
+
+	const char *names[] = { "INDEPENDENT", "ANTITHETIC", "STRATIFIED", "SOBOL" };
+	for (int scheme = search::INDEPENDENT; scheme <= search::SOBOL; scheme++) {
+		search::NoiseSamples samples(num, scheme, 1);
+		search::ShotEvaluation results[2];
+		search::EvaluateShots(&sim, gs, shots, 2, random, random, samples, search::ScoreValue, 0.95, results);
+		search::Estimate diff = search::EstimateDifference(results[0], results[1], scheme, 0.95);
+		cout << names[scheme] << ": " <<
+			results[0].estimate.mean << " [" << results[0].estimate.lower << ", " << results[0].estimate.upper << "], " <<
+			results[1].estimate.mean << " [" << results[1].estimate.lower << ", " << results[1].estimate.upper << "], " <<
+			"diff = " << diff.mean << " +- " << diff.std_error << endl;
+	}
+}
+
+void race_test() {
+	using namespace digital_curling;
+	const float random = 0.145f;
+
+	Simulator sim;
+
+	// Stone of opponent on the tee
+	GameState gs(8);
+	gs.Set(0, kCenterX, kTeeY);
+
+	// Candidates: hit shots with some weights and draw shots around the house
+	std::vector<ShotVec> candidates;
+	ShotVec vec;
+	for (int w = 4; w <= 16; w += 4) {
+		sim.CreateHitShot(ShotPos(kCenterX, kTeeY, false), (float)w, &vec);
+		candidates.push_back(vec);
+	}
+	for (int i = -2; i <= 2; i++) {
+		sim.CreateShot(ShotPos(kCenterX + 0.3f * i, kTeeY + 0.5f, false), &vec);
+		candidates.push_back(vec);
+	}
+
+	search::RaceOptions options;
+	options.time_limit = 10000;
+	time_t start = clock();
+	std::vector<search::RaceResult> results = search::RaceShots(&sim, gs, candidates, random, random, search::ScoreValue, options);
+	cout << "Time spent = " << clock() - start << endl;
+
+	for (const search::RaceResult &r : results) {
+		cout << "candidate " << r.index << (r.survived ? " (survived)" : "") << ": " <<
+			r.estimate.mean << " [" << r.estimate.lower << ", " << r.estimate.upper << "], n = " << r.estimate.num << endl;
+	}
+}
+
 void convert_test() {
 	using namespace digital_curling;
 	ShotVec vecr, vecrp;
@@ -184,14 +319,330 @@ void convert_test() {
 	cout << "hoge" << endl;
 }
 
+// Benchmark of DCP codec: 'POSITION' with stringstream/strtok/atof and with dcurling_dcp.h
+void dcp_test() {
+	using namespace digital_curling;
+	const int num = 100000;
+
+	// Random positions of stones
+	std::mt19937 engine(1);
+	std::uniform_real_distribution<float> dist_x(0.0f, kSideX);
+	std::uniform_real_distribution<float> dist_y(0.0f, kHogY);
+	std::vector<GameState> states(64);
+	for (GameState &gs : states) {
+		for (unsigned int i = 0; i < 16; i++) {
+			gs.Set(i, dist_x(engine), dist_y(engine));
+		}
+	}
+
+	// stringstream, strtok and atof
+	int mismatch = 0;
+	time_t start = clock();
+	for (int n = 0; n < num; n++) {
+		const GameState &gs = states[n % states.size()];
+		std::stringstream sstream;
+		sstream << "POSITION";
+		for (int i = 0; i < 16; i++) {
+			sstream << " " << gs.body[i][0] << " " << gs.body[i][1];
+		}
+
+		char msg[1024];
+		strcpy(msg, sstream.str().c_str());
+		std::vector<std::string> tokens;
+		for (char *token = strtok(msg, " "); token != nullptr; token = strtok(nullptr, " ")) {
+			tokens.push_back(token);
+		}
+		GameState parsed;
+		for (int i = 0; i < 16; i++) {
+			parsed.body[i][0] = (float)atof(tokens[2 * i + 1].c_str());
+			parsed.body[i][1] = (float)atof(tokens[2 * i + 2].c_str());
+		}
+		mismatch += (memcmp(parsed.body, gs.body, sizeof(gs.body)) != 0);
+	}
+	cout << "stringstream: " << (double)(clock() - start) / CLOCKS_PER_SEC * 1e6 / num << " [usec/message], mismatch = " << mismatch << "/" << num << endl;
+
+	// dcurling_dcp.h
+	mismatch = 0;
+	start = clock();
+	for (int n = 0; n < num; n++) {
+		const GameState &gs = states[n % states.size()];
+		char msg[1024];
+		dcp::FormatPosition(gs, msg, sizeof(msg));
+
+		GameState parsed;
+		dcp::ParsePosition(dcp::Tokens(msg), &parsed);
+		mismatch += (memcmp(parsed.body, gs.body, sizeof(gs.body)) != 0);
+	}
+	cout << "dcp:          " << (double)(clock() - start) / CLOCKS_PER_SEC * 1e6 / num << " [usec/message], mismatch = " << mismatch << "/" << num << endl;
+}
+
+// C API: dcsim_simulate() gives the same positions as Simulation(), with noise, without noise (NULL) and in place
+void capi_test() {
+	using namespace digital_curling;
+	const float friction = 12.009216f;
+	const unsigned int freeguard_num = 5;
+	const size_t n = 3;
+
+	Simulator sim(friction);
+	sim.num_freeguard_ = freeguard_num;
+	sim.area_freeguard_ = b2simulator::IN_FREEGUARD;
+	dcsim_simulator *capi = dcsim_create(friction, freeguard_num);
+
+	// Empty house, two stones, and stones 0, 1, 3 and 4 removed
+	GameState states[n] = { GameState(8), GameState(8), GameState(8) };
+	states[1].ShotNum = 2;
+	states[1].Set(0, kCenterX, kTeeY);
+	states[1].Set(1, kCenterX + 0.5f, kTeeY + 2.0f);
+	states[2].ShotNum = 6;
+	states[2].Set(2, kCenterX - 0.4f, kTeeY + 0.3f);
+	states[2].Set(5, kCenterX + 0.2f, kTeeY - 0.6f);
+
+	uint32_t shot_num[n];
+	float x[n * 16], y[n * 16], vx[n], vy[n], noise_1[n], noise_2[n];
+	int32_t curl[n];
+	for (size_t i = 0; i < n; i++) {
+		ShotVec vec;
+		if (i == 0) {
+			sim.CreateShot(ShotPos(kCenterX, kTeeY, false), &vec);
+		}
+		else {
+			sim.CreateHitShot(ShotPos(states[i].body[i][0], states[i].body[i][1], i % 2 != 0), 16.0f, &vec);
+		}
+		shot_num[i] = states[i].ShotNum;
+		vx[i] = vec.x;
+		vy[i] = vec.y;
+		curl[i] = vec.angle;
+		noise_1[i] = 0.05f * i;
+		noise_2[i] = -0.1f * i;
+	}
+
+	for (int mode = 0; mode < 3; mode++) {
+		const char *names[] = { "noise", "no noise", "in place" };
+		bool noise = (mode != 1);
+
+		// Expected positions by Simulation()
+		float expected[n][16][2];
+		for (size_t i = 0; i < n; i++) {
+			GameState gs = states[i];
+			ShotVec vec(vx[i], vy[i], curl[i] != 0);
+			if (noise) {
+				sim.AddNoise2Vec(noise_1[i], noise_2[i], &vec);
+			}
+			sim.Simulation(&gs, vec, 0.0f, 0.0f, nullptr, nullptr, 0);
+			memcpy(expected[i], gs.body, sizeof(expected[i]));
+
+			for (size_t k = 0; k < 16; k++) {
+				x[i * 16 + k] = states[i].body[k][0];
+				y[i * 16 + k] = states[i].body[k][1];
+			}
+		}
+
+		float out_x[n * 16], out_y[n * 16];
+		float *px = (mode == 2) ? x : out_x;
+		float *py = (mode == 2) ? y : out_y;
+		int ret = dcsim_simulate(capi, n, shot_num, x, y, vx, vy, curl,
+			(noise) ? noise_1 : nullptr, (noise) ? noise_2 : nullptr, px, py);
+
+		float diff_max = 0.0f;
+		for (size_t i = 0; i < n; i++) {
+			for (size_t k = 0; k < 16; k++) {
+				diff_max = std::max(diff_max, std::abs(px[i * 16 + k] - expected[i][k][0]));
+				diff_max = std::max(diff_max, std::abs(py[i * 16 + k] - expected[i][k][1]));
+			}
+		}
+		cout << names[mode] << ": ret = " << ret << ", max difference = " << diff_max << " (0)" << endl;
+	}
+
+	// Invalid arguments
+	cout << "one of noise is NULL: " << dcsim_simulate(capi, n, shot_num, x, y, vx, vy, curl, noise_1, nullptr, x, y) <<
+		" (" << DCSIM_INVALID_ARG << ")" << endl;
+	uint32_t over[n] = { 0, 16, 0 };
+	cout << "shot_num 16: " << dcsim_simulate(capi, n, over, x, y, vx, vy, curl, nullptr, nullptr, x, y) <<
+		" (" << DCSIM_INVALID_STATE << ")" << endl;
+
+	dcsim_destroy(capi);
+}
+
+// Win table: save, load and lookup from GameState
+void win_table_test() {
+	using namespace digital_curling;
+
+	// Score of an end for the player with hammer (-2 ... 3)
+	double distribution[WinTable::kNumEndScores] = {};
+	distribution[WinTable::kMaxEndScore - 2] = 0.05;
+	distribution[WinTable::kMaxEndScore - 1] = 0.15;
+	distribution[WinTable::kMaxEndScore]     = 0.20;
+	distribution[WinTable::kMaxEndScore + 1] = 0.35;
+	distribution[WinTable::kMaxEndScore + 2] = 0.20;
+	distribution[WinTable::kMaxEndScore + 3] = 0.05;
+	WinTable table;
+	table.Solve(distribution);
+	table.Save("win_table_test.dcw");
+
+	WinTable loaded;
+	cout << "load: " << loaded.Load("win_table_test.dcw") << endl;
+
+	// 2nd end of 8, first player scored 1 in 1st end, so first player shoots first (second player has hammer)
+	GameState gs(8);
+	gs.CurEnd = 1;
+	gs.Score[0] = 1;
+	gs.WhiteToMove = false;
+	cout << "first:  " << loaded.WinProbability(gs, true) << " (" << table.WinProbability(1, 7, false) << ")" << endl;
+	cout << "second: " << loaded.WinProbability(gs, false) << " (" << table.WinProbability(-1, 7, true) << ")" << endl;
+	cout << "last end, tied, hammer: " << loaded.WinProbability(0, 1, true) << " (0.60 + 0.20 / 2 = 0.70)" << endl;
+
+	// Last end, tied, second player has hammer (first player moves at ShotNum 0, second player at ShotNum 1)
+	GameState last(2);
+	last.CurEnd = 1;
+	last.WhiteToMove = false;
+	cout << "last end, first to move at shot 0:  " << loaded.WinProbability(last, true) << " (0.30)" << endl;
+	last.ShotNum = 1;
+	last.WhiteToMove = true;
+	cout << "last end, second to move at shot 1: " << loaded.WinProbability(last, true) << " (0.30), " << loaded.WinProbability(last, false) << " (0.70)" << endl;
+
+	// 1st end of 2 is over, second player scored 1, so second player shoots first in last end (first player has hammer)
+	GameState over(2);
+	over.ShotNum = 16;
+	over.Score[0] = -1;
+	over.WhiteToMove = true;
+	cout << "end over, first down 1 with hammer: " << loaded.WinProbability(over, true) << " (" << table.WinProbability(-1, 1, true) << ")" << endl;
+}
+
+
+// Last shot: opponent's stone on the tee behind a center guard, own stone in the 8 foot
+void last_shot_test() {
+	using namespace digital_curling;
+	Simulator sim;
+
+	GameState gs(8);
+	gs.ShotNum = 15;
+	gs.Set(0, kCenterX, kTeeY);                 // opponent
+	gs.Set(2, kCenterX, kTeeY + 3.0f);          // opponent (center guard)
+	gs.Set(1, kCenterX + 0.9f, kTeeY + 0.3f);   // own
+
+	search::LastShotOptions options;
+	options.race.seed = 1;
+	time_t start = clock();
+	search::LastShotResult result = search::SolveLastShot(&sim, gs, 0.0725f, 0.29f, options);
+	cout << "shot = (" << result.shot.x << ", " << result.shot.y << ", " << result.shot.angle << "), expected score = " << result.estimate.mean <<
+		" +- " << result.estimate.std_error << endl;
+	cout << result.num_candidates << " candidates, " << result.num_pruned << " pruned, " << result.num_simulations << " simulations in " <<
+		(double)(clock() - start) / CLOCKS_PER_SEC << " [sec]" << endl;
+}
+
+// MCTS: iterations per second by mode and number of threads, and reuse of tree after two shots
+void mcts_test() {
+	using namespace digital_curling;
+	Simulator sim;
+
+	GameState gs(8);
+	gs.ShotNum = 6;
+	gs.Set(0, kCenterX, kTeeY + 2.5f);           // guard
+	gs.Set(1, kCenterX - 0.4f, kTeeY + 0.2f);
+	gs.Set(2, kCenterX + 0.6f, kTeeY - 0.5f);
+	gs.Set(4, kCenterX + 0.1f, kTeeY + 1.2f);
+
+	const char *modes[] = { "root", "tree" };
+	for (int mode = search::ROOT_PARALLEL; mode <= search::TREE_PARALLEL; mode++) {
+		for (unsigned int threads = 1; threads <= 4; threads *= 2) {
+			search::MctsOptions options;
+			options.mode = mode;
+			options.num_threads = threads;
+			options.time_limit = 2000;
+			options.seed = 1;
+			search::Mcts mcts(&sim, 0.0725f, 0.29f, options);
+			search::MctsResult result = mcts.Search(gs);
+			cout << modes[mode] << " parallel, " << threads << " threads: " << result.iterations * 1000.0 / options.time_limit << " [iterations/sec], " <<
+				result.nodes << " nodes, shot = (" << result.shot.x << ", " << result.shot.y << ", " << result.shot.angle << "), value = " << result.value <<
+				" (" << result.visits << " visits)" << endl;
+		}
+	}
+
+	// Own shot and the shot of opponent (matched by stones) are played, then search again
+	search::MctsOptions options;
+	options.time_limit = 2000;
+	options.seed = 1;
+	search::Mcts mcts(&sim, 0.0725f, 0.29f, options);
+	search::MctsResult result = mcts.Search(gs);
+	GameState after = gs;
+	sim.Simulation(&after, result.shot, 0.0725f, 0.29f, nullptr, nullptr);
+	cout << "advance (own shot):      " << mcts.Advance(result.shot, after) << ", " << mcts.NumNodes() << " nodes" << endl;
+	result = mcts.Search(after);
+	cout << "search of opponent:      " << result.reused << " visits reused" << endl;
+	sim.Simulation(&after, result.shot, 0.0725f, 0.29f, nullptr, nullptr);
+	cout << "advance (opponent shot): " << mcts.Advance(after) << ", " << mcts.NumNodes() << " nodes" << endl;
+	result = mcts.Search(after);
+	cout << "search after two shots:  " << result.reused << " visits reused, " << result.iterations << " iterations" << endl;
+}
+
+// MCTS with win table: last stone of the last end, draw to win or hit to lose by the player to move
+void mcts_win_table_test() {
+	using namespace digital_curling;
+	Simulator sim;
+
+	// Score of an end for the player with hammer (same as win_table_test())
+	double distribution[WinTable::kNumEndScores] = {};
+	distribution[WinTable::kMaxEndScore - 2] = 0.05;
+	distribution[WinTable::kMaxEndScore - 1] = 0.15;
+	distribution[WinTable::kMaxEndScore]     = 0.20;
+	distribution[WinTable::kMaxEndScore + 1] = 0.35;
+	distribution[WinTable::kMaxEndScore + 2] = 0.20;
+	distribution[WinTable::kMaxEndScore + 3] = 0.05;
+	WinTable table;
+	table.Solve(distribution);
+
+	// Last stone of the last end, player to move has hammer and is down 1
+	//  draw to the tee scores 2 and wins, hit of own stone gives 1 to the opponent and loses
+	ShotVec draw, hit;
+	sim.CreateShot(ShotPos(kCenterX, kTeeY, false), &draw);
+	sim.CreateHitShot(ShotPos(kCenterX - 0.3f, kTeeY - 0.3f, false), 16.0f, &hit);
+
+	search::MctsOptions options;
+	options.num_threads = 1;
+	options.time_limit = 10000;
+	options.max_iterations = 64;
+	options.win_table = &table;
+	options.generator = [&draw, &hit](b2simulator::Simulator *, const GameState &, std::mt19937 &rng) {
+		return (rng() % 2 == 0) ? draw : hit;
+	};
+	options.seed = 1;
+
+	for (int white = 0; white < 2; white++) {
+		// First player scored 1 in 1st end if second player is to move (and the other way)
+		GameState gs(2);
+		gs.CurEnd = 1;
+		gs.Score[0] = (white) ? 1 : -1;
+		gs.WhiteToMove = (white != 0);
+		gs.ShotNum = 15;
+		gs.Set(0, kCenterX + 0.6f, kTeeY + 0.6f);   // opponent
+		gs.Set(1, kCenterX - 0.3f, kTeeY - 0.3f);   // own
+
+		search::Mcts mcts(&sim, 0.0725f, 0.29f, options);
+		search::MctsResult result = mcts.Search(gs);
+		bool is_draw = (result.shot.x == draw.x && result.shot.y == draw.y);
+		cout << ((white) ? "second" : "first ") << " player to move: " << ((is_draw) ? "draw" : "hit ") << " (draw), value = " <<
+			result.value << " (" << result.visits << " of " << result.iterations << " visits)" << endl;
+	}
+}
+
 int  main(void) {
 
 	//operator_test();
 	//simulation_test();
 	//score_test();
 	create_shot_test();
+	//event_test();
 	//random_test();
+	//noise_test();
+	//evaluator_test();
+	//race_test();
 	//convert_test();
+	//dcp_test();
+	//capi_test();
+	//win_table_test();
+	//last_shot_test();
+	//mcts_test();
+	//mcts_win_table_test();
 
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,315 @@
+//======================================================
+// Generator of win table (probability of winning by score difference, ends remaining and hammer).
+// Distribution of score of an end is estimated from simulated self-play (or logs),
+// and the table is solved by dynamic programming and written for AIs (dcurling_win_table.h).
+//======================================================
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../Simulator/dcurling_simulator.h"
+#include "../Simulator/dcurling_win_table.h"
+#include "../Server/game_log_binary.h"
+
+#ifdef _MSC_VER
+#ifdef _DEBUG
+#pragma comment( lib, "../x64/Debug/Simulator.lib" )
+#endif
+#ifndef _DEBUG
+#pragma comment( lib, "../x64/Release/Simulator.lib" )
+#endif
+#endif
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using std::string;
+
+namespace digital_curling {
+
+	namespace win_table {
+
+		// Options of generator
+		struct Options {
+			string output;               // path of table
+			unsigned int ends;           // number of ends of self-play
+			unsigned int candidates;     // number of candidate shots for each shot of self-play
+			unsigned int threads;        // number of threads (0: number of cores)
+			uint32_t seed;               // seed of thread i is seed + i
+			float random[2];             // random_1 and random_2 of noise
+			float friction;              // friction of simulator
+			unsigned int freeguard_num;  // number of shots of freeguard rule
+			std::vector<string> logs;    // logs (or directories of them) instead of self-play
+
+			Options() :
+				output("win_table.dcw"),
+				ends(1000),
+				candidates(8),
+				threads(0),
+				seed(0),
+				random{ 0.0725f, 0.2900f },  // random_1 and random_2 of config.json
+				friction(12.009216f),         // friction_default of config.json
+				freeguard_num(5) {}
+		};
+
+		// Number of ends with each score of the player with hammer ([s + kMaxEndScore])
+		typedef std::vector<uint64_t> Histogram;
+
+		// Count scores of ends of logs (position after the last shot of each end)
+		static bool CountLogs(const std::vector<string> &paths, Histogram &histogram) {
+			std::vector<string> logs = ListLogs(paths);
+
+			uint64_t ends = 0;
+			for (const string &log : logs) {
+				BinaryLogHeader header;
+				std::vector<BinaryLogRecord> records;
+				if (!ReadLog(log, header, records)) {
+					cerr << "failed to read " << log << endl;
+					return false;
+				}
+
+				for (const BinaryLogRecord &record : records) {
+					if (record.type == BinaryLogRecord::GAMEINFO && record.value[0] == 1) {
+						break;  // mix doubles
+					}
+					if (record.type != BinaryLogRecord::SHOT || record.shot_num != 15) {
+						continue;
+					}
+					GameState gs;
+					gs.ShotNum = 16;
+					memcpy(gs.body, record.after, sizeof(gs.body));
+					histogram[b2simulator::Simulator::GetScore(&gs) + WinTable::kMaxEndScore]++;
+					ends++;
+				}
+			}
+			cout << "> " << ends << " ends from " << logs.size() << " logs." << endl;
+			return ends > 0;
+		}
+
+		// Player of self-play, which takes the best of random shots by score after them
+		class SelfPlay {
+		public:
+			SelfPlay(const Options &options, uint32_t seed) :
+				options_(options),
+				sim_(options.friction),
+				engine_(seed),
+				normal_(0.0f, 1.0f) {
+				sim_.num_freeguard_ = options.freeguard_num;
+				sim_.area_freeguard_ = b2simulator::IN_FREEGUARD;
+			}
+
+			// Play an end and return score of the player with hammer
+			int PlayEnd() {
+				GameState gs(kLastEndMax);
+				while (gs.ShotNum < 16) {
+					ShotVec vec = Noise(ChooseShot(gs));
+					sim_.Simulation(&gs, vec, 0.0f, 0.0f, nullptr, nullptr, 0);
+				}
+				return b2simulator::Simulator::GetScore(&gs);
+			}
+
+		private:
+			// Candidate with the best score for the player to move (one simulation with noise for each)
+			ShotVec ChooseShot(const GameState &gs) {
+				int sign = (gs.ShotNum % 2 == 1) ? 1 : -1;  // player with hammer shoots at odd ShotNum
+				ShotVec best;
+				int best_score = INT32_MIN;
+				for (unsigned int i = 0; i < options_.candidates; i++) {
+					ShotVec vec = CandidateShot(gs);
+					GameState after = gs;
+					sim_.Simulation(&after, Noise(vec), 0.0f, 0.0f, nullptr, nullptr, 0);
+					after.ShotNum = gs.ShotNum + 1;  // also for foul of freeguard rule
+					int score = sign * b2simulator::Simulator::GetScore(&after);
+					if (score > best_score) {
+						best_score = score;
+						best = vec;
+					}
+				}
+				return best;
+			}
+
+			// Random draw shot to the house or guard zone, or hit shot to a stone in play
+			ShotVec CandidateShot(const GameState &gs) {
+				ShotVec vec;
+				bool angle = (std::uniform_int_distribution<int>(0, 1)(engine_) != 0);
+
+				std::vector<unsigned int> stones;
+				for (unsigned int i = 0; i < gs.ShotNum; i++) {
+					if (b2simulator::GetStoneArea(ShotPos(gs.body[i][0], gs.body[i][1], angle)) & b2simulator::IN_PLAYAREA) {
+						stones.push_back(i);
+					}
+				}
+				if (!stones.empty() && std::uniform_int_distribution<int>(0, 1)(engine_) != 0) {
+					unsigned int i = stones[std::uniform_int_distribution<size_t>(0, stones.size() - 1)(engine_)];
+					float weight = std::uniform_real_distribution<float>(1.0f, 16.0f)(engine_);
+					sim_.CreateHitShot(ShotPos(gs.body[i][0], gs.body[i][1], angle), weight, &vec);
+				}
+				else {
+					float x = std::uniform_real_distribution<float>(kCenterX - kHouseR, kCenterX + kHouseR)(engine_);
+					float y = std::uniform_real_distribution<float>(kTeeY - kHouseR, kHogY - kHouseR)(engine_);
+					sim_.CreateShot(ShotPos(x, y, angle), &vec);
+				}
+				return vec;
+			}
+
+			// Shot with noise drawn from engine_
+			ShotVec Noise(ShotVec vec) {
+				float r1 = normal_(engine_);
+				float r2 = normal_(engine_);
+				sim_.AddNoise2Vec(r1 * options_.random[0], r2 * options_.random[1], &vec);
+				return vec;
+			}
+
+			const Options &options_;
+			b2simulator::Simulator sim_;
+			std::mt19937 engine_;
+			std::normal_distribution<float> normal_;
+		};
+
+		// Count scores of ends of self-play in parallel
+		static void CountSelfPlay(const Options &options, Histogram &histogram) {
+			unsigned int num_threads = (options.threads > 0) ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+			cout << "> self-play " << options.ends << " ends with " << num_threads << " threads (seed " << options.seed << ")." << endl;
+
+			std::mutex mtx;  // for histogram
+			std::vector<std::thread> threads;
+			for (unsigned int i = 0; i < num_threads; i++) {
+				unsigned int ends = options.ends / num_threads + ((i < options.ends % num_threads) ? 1 : 0);
+				threads.push_back(std::thread([&options, &histogram, &mtx, i, ends]() {
+					// Simulator of each thread (initialization of tables takes time)
+					SelfPlay player(options, options.seed + i);
+					Histogram local(WinTable::kNumEndScores, 0);
+					for (unsigned int n = 0; n < ends; n++) {
+						local[player.PlayEnd() + WinTable::kMaxEndScore]++;
+					}
+
+					std::lock_guard<std::mutex> lock(mtx);
+					for (int s = 0; s < WinTable::kNumEndScores; s++) {
+						histogram[s] += local[s];
+					}
+				}));
+			}
+			for (std::thread &thread : threads) {
+				thread.join();
+			}
+		}
+
+		// Print distribution and probability of winning of the first end to the last
+		static void PrintTable(const WinTable &table) {
+			cout << "score of an end for the player with hammer:" << endl;
+			for (int s = -WinTable::kMaxEndScore; s <= WinTable::kMaxEndScore; s++) {
+				float p = table.Distribution()[s + WinTable::kMaxEndScore];
+				if (p > 0.0f) {
+					cout << "  " << std::setw(3) << s << " : " << std::fixed << std::setprecision(4) << p << endl;
+				}
+			}
+			cout << "probability of winning with hammer (score difference -3 ... +3):" << endl;
+			for (unsigned int e = kLastEndMax; e >= 1; e--) {
+				cout << "  " << std::setw(2) << e << " ends left :";
+				for (int d = -3; d <= 3; d++) {
+					cout << " " << std::fixed << std::setprecision(3) << table.WinProbability(d, e, true);
+				}
+				cout << endl;
+			}
+			cout.unsetf(std::ios::fixed);
+		}
+
+		static void PrintUsage() {
+			cerr << "usage: WinTable [-o OUTPUT] [-n ENDS] [-c CANDIDATES] [-t THREADS] [-s SEED] [-r R1 R2] [-f FRICTION] [-g FREEGUARD] [LOG...]" << endl;
+			cerr << "  -o OUTPUT     : path of table (default: win_table.dcw)" << endl;
+			cerr << "  -n ENDS       : number of ends of self-play (default: 1000)" << endl;
+			cerr << "  -c CANDIDATES : number of candidate shots for each shot of self-play (default: 8)" << endl;
+			cerr << "  -t THREADS    : number of threads (default: number of cores)" << endl;
+			cerr << "  -s SEED       : seed of random numbers (default: random)" << endl;
+			cerr << "  -r R1 R2      : random_1 and random_2 of noise (default: 0.0725 0.29)" << endl;
+			cerr << "  -f FRICTION   : friction of simulator (default: 12.009216)" << endl;
+			cerr << "  -g FREEGUARD  : number of shots of freeguard rule (default: 5)" << endl;
+			cerr << "  LOG...        : logs (.dcl or .dcb, or directories of them) instead of self-play" << endl;
+		}
+	}
+}
+
+int main(int argc, char* argv[]) {
+	using namespace digital_curling;
+	using namespace digital_curling::win_table;
+
+	Options options;
+	options.seed = std::random_device()();
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		bool has_value = (i + 1 < argc);
+		if (arg == "-o" && has_value) {
+			options.output = argv[++i];
+		}
+		else if (arg == "-n" && has_value) {
+			options.ends = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+		}
+		else if (arg == "-c" && has_value) {
+			options.candidates = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+		}
+		else if (arg == "-t" && has_value) {
+			options.threads = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+		}
+		else if (arg == "-s" && has_value) {
+			options.seed = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+		}
+		else if (arg == "-r" && i + 2 < argc) {
+			options.random[0] = std::strtof(argv[++i], nullptr);
+			options.random[1] = std::strtof(argv[++i], nullptr);
+		}
+		else if (arg == "-f" && has_value) {
+			options.friction = std::strtof(argv[++i], nullptr);
+		}
+		else if (arg == "-g" && has_value) {
+			options.freeguard_num = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+		}
+		else if (arg == "-h" || arg == "--help" || arg[0] == '-') {
+			PrintUsage();
+			return (arg[0] == '-' && arg != "-h" && arg != "--help") ? 1 : 0;
+		}
+		else {
+			options.logs.push_back(arg);
+		}
+	}
+	if (options.ends == 0 || options.candidates == 0) {
+		PrintUsage();
+		return 1;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	Histogram histogram(WinTable::kNumEndScores, 0);
+	if (!options.logs.empty()) {
+		if (!CountLogs(options.logs, histogram)) {
+			cerr << "no ends in logs." << endl;
+			return 1;
+		}
+	}
+	else {
+		CountSelfPlay(options, histogram);
+	}
+
+	double distribution[WinTable::kNumEndScores];
+	for (int s = 0; s < WinTable::kNumEndScores; s++) {
+		distribution[s] = (double)histogram[s];
+	}
+	WinTable table;
+	table.Solve(distribution);
+	PrintTable(table);
+
+	if (!table.Save(options.output)) {
+		return 1;
+	}
+	double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	cout << "> wrote " << options.output << " in " << sec << " sec." << endl;
+	return 0;
+}